@@ -0,0 +1,157 @@
+#!/usr/bin/env python3
+
+# Converts a video recorded with 'record start -raw' (an .omv file) to a
+# file with raw video frames plus (when the recording has audio) a .wav
+# file. Those can be encoded with e.g. ffmpeg, this script prints a
+# suitable ffmpeg command line.
+#
+# For the file format, see src/video/RawVideoWriter.hh.
+
+from struct import Struct
+from sys import argv, exit, stderr
+import wave
+
+headerStruct = Struct('<8sIIIIIIIIIIIIQ')
+chunkStruct = Struct('<4sI')
+
+def uncompressSnappy(data):
+	'''Decompresses a block compressed with the openMSX variant of snappy:
+	that's the raw snappy format, but without the uncompressed length at
+	the start and with 16 (unused) padding bytes at the end.
+	'''
+	pos = 0
+	out = bytearray()
+	end = len(data) - 16
+	while pos < end:
+		tag = data[pos]
+		pos += 1
+		kind = tag & 3
+		if kind == 0:
+			# literal
+			n = tag >> 2
+			if n >= 60:
+				numBytes = n - 59
+				n = int.from_bytes(data[pos:pos + numBytes], 'little')
+				pos += numBytes
+			n += 1
+			out += data[pos:pos + n]
+			pos += n
+			continue
+		if kind == 1:
+			n = ((tag >> 2) & 7) + 4
+			offset = ((tag >> 5) << 8) | data[pos]
+			pos += 1
+		elif kind == 2:
+			n = (tag >> 2) + 1
+			offset = int.from_bytes(data[pos:pos + 2], 'little')
+			pos += 2
+		else:
+			n = (tag >> 2) + 1
+			offset = int.from_bytes(data[pos:pos + 4], 'little')
+			pos += 4
+		start = len(out) - offset
+		if offset >= n:
+			out += out[start:start + n]
+		else:
+			# overlapping copy: repeats the last 'offset' bytes
+			while n > 0:
+				m = min(n, offset)
+				out += out[start:start + m]
+				start += m
+				n -= m
+	return bytes(out)
+
+def pixelFormat(bytesPerPixel, masks):
+	'''Returns the ffmpeg pixel format name for the given pixel layout.
+	'''
+	if bytesPerPixel == 2:
+		if masks == (0xF800, 0x07E0, 0x001F):
+			return 'rgb565le'
+		if masks == (0x7C00, 0x03E0, 0x001F):
+			return 'rgb555le'
+		if masks == (0x001F, 0x07E0, 0xF800):
+			return 'bgr565le'
+		if masks == (0x001F, 0x03E0, 0x7C00):
+			return 'bgr555le'
+	else:
+		# name the bytes in memory order (little endian)
+		names = ''
+		for shift in range(0, 32, 8):
+			byteMask = 0xFF << shift
+			if masks[0] == byteMask:
+				names += 'r'
+			elif masks[1] == byteMask:
+				names += 'g'
+			elif masks[2] == byteMask:
+				names += 'b'
+			else:
+				names += '0'
+		if sorted(names) == ['0', 'b', 'g', 'r']:
+			return names
+	raise ValueError('unsupported pixel format: %d bytes, masks %s' % (
+		bytesPerPixel, ', '.join('%08X' % m for m in masks)))
+
+def convert(inName, outPrefix):
+	with open(inName, 'rb') as inp:
+		header = inp.read(64)
+		(magic, version, width, height, bytesPerPixel,
+			redMask, greenMask, blueMask, channels, sampleRate,
+			fpsMilli, numFrames, reserved, indexOffset
+			) = headerStruct.unpack(header)
+		if magic != b'openMSXv':
+			raise ValueError('not an openMSX raw video file')
+		if version != 1:
+			raise ValueError('unsupported version: %d' % version)
+		if indexOffset == 0:
+			print('warning: recording was not properly stopped',
+				file=stderr)
+		frameSize = width * height * bytesPerPixel
+		fmt = pixelFormat(bytesPerPixel, (redMask, greenMask, blueMask))
+
+		videoName = outPrefix + '.raw'
+		audioName = outPrefix + '.wav'
+		frames = 0
+		with open(videoName, 'wb') as video:
+			audio = None
+			if channels:
+				audio = wave.open(audioName, 'wb')
+				audio.setnchannels(channels)
+				audio.setsampwidth(2)
+				audio.setframerate(sampleRate)
+			while True:
+				chunkHeader = inp.read(chunkStruct.size)
+				if len(chunkHeader) < chunkStruct.size:
+					break
+				tag, size = chunkStruct.unpack(chunkHeader)
+				data = inp.read(size)
+				if len(data) < size:
+					print('warning: truncated file', file=stderr)
+					break
+				if tag == b'vid ':
+					frame = uncompressSnappy(data)
+					assert len(frame) == frameSize
+					video.write(frame)
+					frames += 1
+				elif tag == b'aud ':
+					if audio:
+						audio.writeframes(data)
+				elif tag == b'idx ':
+					break
+			if audio:
+				audio.close()
+
+	fps = fpsMilli / 1000.0 if fpsMilli else 60.0
+	print('wrote %d frames to %s' % (frames, videoName), file=stderr)
+	print('encode with e.g.:', file=stderr)
+	print('  ffmpeg -f rawvideo -pixel_format %s -video_size %dx%d '
+		'-framerate %.3f -i %s %s-c:v libx264 -crf 0 %s.mkv' % (
+			fmt, width, height, fps, videoName,
+			('-i %s ' % audioName) if channels else '',
+			outPrefix),
+		file=stderr)
+
+if __name__ == '__main__':
+	if len(argv) != 3:
+		print('usage: omv2raw.py <input.omv> <output-prefix>', file=stderr)
+		exit(1)
+	convert(argv[1], argv[2])
@@ -0,0 +1,20 @@
+# Startup script for 'make benchmark', see build/main.mk.
+
+# The renderer can only be disabled once openMSX is started. Till then the SDL
+# renderer is active, 'make benchmark' selects SDL's dummy video driver for it.
+set renderer none
+
+set seconds $::env(OPENMSX_BENCHMARK_SECONDS)
+switch -- $::env(OPENMSX_BENCHMARK_CASE) {
+	idle {
+		emulation_benchmark $seconds exit
+	}
+	sprites {
+		# Let the machine boot first, sprite_benchmark takes over the VDP.
+		after time 5 [list sprite_benchmark $seconds 32 exit]
+	}
+	default {
+		puts stderr "Unknown benchmark case: $::env(OPENMSX_BENCHMARK_CASE)"
+		exit 1
+	}
+}
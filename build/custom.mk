@@ -19,3 +19,23 @@ SYMLINK_FOR_BINARY:=true
 # Install content of Contrib/ directory?
 # Currently this contains a version of C-BIOS.
 INSTALL_CONTRIB:=true
+
+# Use computed goto's for the instruction dispatch in the Z80/R800 core?
+# Computed goto's are a gcc extension (also supported by clang), they make
+# the emulation about 10% faster on CPUs with good branch prediction for
+# indirect jumps (most desktop CPUs), but can be a few percent slower on
+# small embedded CPUs. Compiling src/cpu/CPUCore.cc with computed goto's
+# needs quite a lot of memory (around 700MB on recent gcc versions).
+# When set to "false" a portable switch statement is used instead.
+# Use the 'cpu_benchmark' console command to compare both variants.
+COMPUTED_GOTO:=true
+
+# Size (in bytes) of the cache lines of the memory cache in the Z80/R800 core:
+# 64, 128 or 256. Devices that opted in for it (currently the SCC and
+# MegaFlashROM SCC+ mappers and the multi-device slots) can have more of their
+# address space cached with smaller lines, for example the plain memory next
+# to a memory mapped register. On the other hand, more cache lines have to be
+# invalidated and filled again on each bank switch. Use the 'cpu_benchmark'
+# console command, running from a cartridge with one of these mappers, to
+# compare the sizes.
+CPU_CACHELINE_SIZE:=256
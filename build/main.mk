@@ -63,7 +63,7 @@ endif
 # TODO: "dist" and "createsubs" are missing
 # TODO: more missing?
 # Logical targets which require dependency files.
-DEPEND_TARGETS:=all default install run bindist
+DEPEND_TARGETS:=all default install run benchmark bindist
 # Logical targets which do not require dependency files.
 NODEPEND_TARGETS:=clean config probe 3rdparty run-3rdparty staticbindist
 # Mark all logical targets as such.
@@ -377,6 +377,25 @@ else
 endif
 endif
 
+# Instruction dispatch in the Z80/R800 core.
+# The default comes from custom.mk, but a flavour can override it.
+$(call BOOLCHECK,COMPUTED_GOTO)
+ifeq ($(COMPUTED_GOTO),true)
+  COMPILE_FLAGS+=-DUSE_COMPUTED_GOTO
+endif
+
+# Size of the cache lines of the memory cache in the Z80/R800 core.
+# The default comes from custom.mk, but a flavour can override it.
+$(call DEFCHECK,CPU_CACHELINE_SIZE)
+CPU_CACHELINE_BITS:=$(strip \
+	$(if $(filter 64,$(CPU_CACHELINE_SIZE)),6, \
+	$(if $(filter 128,$(CPU_CACHELINE_SIZE)),7, \
+	$(if $(filter 256,$(CPU_CACHELINE_SIZE)),8))))
+ifeq ($(CPU_CACHELINE_BITS),)
+  $(error CPU_CACHELINE_SIZE must be 64, 128 or 256, but is "$(CPU_CACHELINE_SIZE)")
+endif
+COMPILE_FLAGS+=-DFINE_CACHELINE_BITS=$(CPU_CACHELINE_BITS)
+
 # Strip binary?
 OPENMSX_STRIP?=false
 $(call BOOLCHECK,OPENMSX_STRIP)
@@ -570,6 +589,24 @@ run: all
 	$(SUM) "Running $(notdir $(BINARY_FULL))..."
 	$(CMD)$(BINARY_FULL)
 
+# Measure emulation speed: boot a fixed machine without video and sound output
+# and emulate a fixed amount of time with throttling disabled. The result
+# (emulated seconds per second) is printed on stdout. Only compare results of
+# runs on the same host.
+# BENCHMARK_CASE selects what is emulated: "idle" (the machine as it boots) or
+# "sprites" (many moving sprites, see sprite_benchmark in _benchmark.tcl).
+BENCHMARK_MACHINE?=C-BIOS_MSX2+
+BENCHMARK_SECONDS?=60
+BENCHMARK_CASE?=idle
+benchmark: all
+	$(SUM) "Running $(BENCHMARK_CASE) emulation benchmark ($(BENCHMARK_SECONDS)s on $(BENCHMARK_MACHINE))..."
+	$(CMD)SDL_VIDEODRIVER=dummy SDL_AUDIODRIVER=dummy \
+		OPENMSX_BENCHMARK_SECONDS=$(BENCHMARK_SECONDS) \
+		OPENMSX_BENCHMARK_CASE=$(BENCHMARK_CASE) \
+		$(BINARY_FULL) -machine $(BENCHMARK_MACHINE) \
+		-setting build/benchmark/settings.xml \
+		-script build/benchmark/benchmark.tcl
+
 
 # Installation and Binary Packaging
 # =================================
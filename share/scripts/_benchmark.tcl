@@ -0,0 +1,337 @@
+namespace eval benchmark {
+
+set_help_text cpu_benchmark \
+{Measure the emulation speed of the Z80/R800 core.
+
+Usage:
+  cpu_benchmark [<seconds>]
+
+This loads a fixed mix of Z80 instructions in RAM, makes the CPU execute it
+(with interrupts disabled) and emulates <seconds> (default 10) of MSX time
+with throttling disabled. The result is printed on stdout as the number of
+emulated CPU MHz (the real CPU runs at 3.58MHz for Z80 and 7.16MHz for R800).
+
+The currently active CPU is measured, so on a turboR machine this can be
+either the Z80 or the R800. The MSX program that was running is destroyed, so
+it's best to run this on a freshly booted machine, e.g. one started with
+  openmsx -machine C-BIOS_MSX2+
+
+This allows to compare different builds (e.g. with or without computed goto's,
+see COMPUTED_GOTO in build/custom.mk) on the same host.
+}
+
+set_help_text emulation_benchmark \
+{Measure the emulation speed of the complete machine.
+
+Usage:
+  emulation_benchmark [<seconds> [<command>]]
+
+This emulates <seconds> (default 10) of MSX time with throttling disabled and
+reports the number of emulated seconds per host (wall clock) second. Unlike
+cpu_benchmark, this doesn't touch the running MSX program, so it measures
+whatever the machine is doing (CPU, VDP, sound chips, ...). The report also
+shows how the host time was divided over the emulated devices (see
+'help machine_info scheduler_stats'), the remaining time is mostly spent
+emulating the CPU. When <command> is given, it is executed after the result is
+reported (e.g. 'exit').
+
+The result depends on the video and sound settings. For reproducible numbers
+use 'make benchmark', this boots a fixed machine without video and sound
+output, see build/benchmark/.
+}
+
+set_help_text sprite_benchmark \
+{Measure the emulation speed with many sprites on the screen.
+
+Usage:
+  sprite_benchmark [<seconds> [<moving> [<command>]]]
+
+This switches the VDP to screen 5 with 32 sprites of 16x16 pixels, many of them
+on the same lines (more than 8 sprites per line). On each VDP interrupt, an MSX
+routine moves the first <moving> (default 32, 0 means the sprites don't move)
+sprites and writes the complete sprite attribute table to VRAM, like a typical
+game does. Then it runs emulation_benchmark for <seconds> (default 10) and
+executes <command> afterwards.
+
+The MSX program that was running is disturbed, so it's best to run this on a
+freshly booted machine. 'make benchmark BENCHMARK_CASE=sprites' runs it on the
+benchmark machine.
+}
+
+set_help_text resampler_benchmark \
+{Compare the speed of the resample algorithms.
+
+Usage:
+  resampler_benchmark [<seconds>]
+
+This makes the PSG play a tone on all of its channels and then, for each value
+of the 'resampler' setting (fast, blip and hq), emulates <seconds> (default 10)
+of MSX time with throttling disabled. For each algorithm the number of emulated
+seconds per host (wall clock) second is reported. The emulated machine does the
+same work in each run, so the differences are caused by the resampling. The
+sound is also resampled with the 'null' sound driver, so this works without
+sound output as well. Afterwards the 'resampler' setting is restored.
+
+The PSG registers are overwritten, so like cpu_benchmark it's best to run this
+on a freshly booted machine.
+}
+
+# Instruction mix, assembled at address 0xC000:
+#   C000  F3          di
+#   C001  31 00 F0    ld   sp,0xF000
+#   C004  21 00 D0    ld   hl,0xD000  ; outer loop
+#   C007  11 00 D8    ld   de,0xD800
+#   C00A  01 40 00    ld   bc,0x0040
+#   C00D  ED B0       ldir
+#   C00F  06 20       ld   b,0x20
+#   C011  7E          ld   a,(hl)     ; inner loop
+#   C012  86          add  a,(hl)
+#   C013  23          inc  hl
+#   C014  77          ld   (hl),a
+#   C015  E6 0F       and  0x0F
+#   C017  CB 27       sla  a
+#   C019  DD 21 00 D0 ld   ix,0xD000
+#   C01D  DD 7E 05    ld   a,(ix+5)
+#   C020  C5          push bc
+#   C021  C1          pop  bc
+#   C022  CD 2A C0    call 0xC02A
+#   C025  10 EA       djnz 0xC011
+#   C027  C3 04 C0    jp   0xC004
+#   C02A  13          inc  de         ; subroutine
+#   C02B  C9          ret
+variable code {
+	0xF3 0x31 0x00 0xF0 0x21 0x00 0xD0 0x11 0x00 0xD8 0x01 0x40 0x00
+	0xED 0xB0 0x06 0x20 0x7E 0x86 0x23 0x77 0xE6 0x0F 0xCB 0x27 0xDD
+	0x21 0x00 0xD0 0xDD 0x7E 0x05 0xC5 0xC1 0xCD 0x2A 0xC0 0x10 0xEA
+	0xC3 0x04 0xC0 0x13 0xC9}
+
+# Sprite mover, assembled at address 0xC000 (called via H.TIMI). It updates a
+# copy of the sprite attribute table at 0xC100 and writes it to VRAM 0x7600:
+#   C000  21 00 C1    ld   hl,0xC100
+#   C003  06 nn       ld   b,<moving>
+#   C005  34          inc  (hl)       ; move down
+#   C006  23          inc  hl
+#   C007  35          dec  (hl)       ; move left
+#   C008  23          inc  hl
+#   C009  23          inc  hl
+#   C00A  23          inc  hl
+#   C00B  10 F8       djnz 0xC005
+#   C00D  3E 01       ld   a,0x01     ; R#14 = 1
+#   C00F  D3 99       out  (0x99),a
+#   C011  3E 8E       ld   a,0x8E
+#   C013  D3 99       out  (0x99),a
+#   C015  AF          xor  a          ; VRAM write address 0x7600
+#   C016  D3 99       out  (0x99),a
+#   C018  3E 76       ld   a,0x76
+#   C01A  D3 99       out  (0x99),a
+#   C01C  21 00 C1    ld   hl,0xC100
+#   C01F  01 98 80    ld   bc,0x8098
+#   C022  ED B3       otir
+#   C024  C9          ret
+variable sprite_code {
+	0x21 0x00 0xC1 0x06 0x00 0x34 0x23 0x35 0x23 0x23 0x23 0x10 0xF8
+	0x3E 0x01 0xD3 0x99 0x3E 0x8E 0xD3 0x99 0xAF 0xD3 0x99 0x3E 0x76
+	0xD3 0x99 0x21 0x00 0xC1 0x01 0x98 0x80 0xED 0xB3 0xC9}
+
+variable start_wall
+variable start_emu
+variable old_throttle
+variable old_stats
+variable done_cmd
+variable old_resampler
+variable resampler_todo
+variable resampler_result
+
+proc cpu_benchmark {{seconds 10}} {
+	variable code
+	variable old_throttle
+
+	if {![string is double -strict $seconds] || $seconds <= 0} {
+		error "Expected a positive number of seconds, got: $seconds"
+	}
+
+	debug write_block memory 0xC000 [binary format c* $code]
+	# Jump to the code via the H.TIMI hook: this works regardless of
+	# what the CPU is doing (e.g. waiting in a HALT instruction), as long
+	# as the BIOS has VDP interrupts enabled.
+	debug write_block memory 0xFD9F [binary format c* {0xC3 0x00 0xC0}]
+
+	set old_throttle $::throttle
+	set ::throttle off
+	# give the CPU some time to reach the benchmark loop
+	after time 0.1 [namespace code [list start_measure $seconds report_cpu]]
+	return ""
+}
+
+proc emulation_benchmark {{seconds 10} {command ""}} {
+	variable old_throttle
+	variable old_stats
+	variable done_cmd
+
+	if {![string is double -strict $seconds] || $seconds <= 0} {
+		error "Expected a positive number of seconds, got: $seconds"
+	}
+
+	set done_cmd $command
+	set old_throttle $::throttle
+	set ::throttle off
+	set old_stats $::scheduler_stats
+	after time 0 [namespace code [list start_emulation_measure $seconds]]
+	return ""
+}
+
+proc sprite_benchmark {{seconds 10} {moving 32} {command ""}} {
+	variable sprite_code
+
+	if {![string is integer -strict $moving] || $moving < 0 || $moving > 32} {
+		error "Expected a number of moving sprites between 0 and 32, got: $moving"
+	}
+
+	# screen 5: sprite colors 0x7400, sprite attributes 0x7600, sprite
+	# patterns 0x7800, 16x16 sprites, VDP interrupts enabled
+	foreach {reg value} {0 0x06 1 0x62 2 0x1F 5 0xEF 6 0x0F 8 0x08 11 0x00} {
+		debug write "VDP regs" $reg $value
+	}
+	debug write_block VRAM 0x7400 [string repeat [binary format c 0x0F] 512]
+	debug write_block VRAM 0x7800 [string repeat [binary format c 0xFF] 256]
+
+	# 4 groups of 8 overlapping sprites
+	set attributes ""
+	for {set i 0} {$i < 32} {incr i} {
+		set y [expr {20 + ($i & 7) * 3 + ($i / 8) * 50}]
+		append attributes [binary format cccc $y [expr {$i * 8}] [expr {($i & 7) * 4}] 0]
+	}
+	debug write_block memory 0xC100 $attributes
+	debug write_block VRAM 0x7600 $attributes
+
+	if {$moving != 0} {
+		set code [lreplace $sprite_code 4 4 $moving]
+		debug write_block memory 0xC000 [binary format c* $code]
+		debug write_block memory 0xFD9F [binary format c* {0xC3 0x00 0xC0}]
+	}
+	emulation_benchmark $seconds $command
+}
+
+proc resampler_benchmark {{seconds 10}} {
+	variable old_throttle
+	variable old_resampler
+	variable resampler_todo
+	variable resampler_result
+
+	if {![string is double -strict $seconds] || $seconds <= 0} {
+		error "Expected a positive number of seconds, got: $seconds"
+	}
+	if {"PSG regs" ni [debug list]} {
+		error "This machine doesn't have a PSG"
+	}
+
+	# three different tones (~440Hz, ~554Hz, ~659Hz) at maximum volume
+	set regs {0xFE 0x00 0xCA 0x00 0xAA 0x00 0x00 0xB8 0x0F 0x0F 0x0F}
+	for {set i 0} {$i < [llength $regs]} {incr i} {
+		debug write "PSG regs" $i [lindex $regs $i]
+	}
+
+	set old_throttle $::throttle
+	set old_resampler $::resampler
+	set resampler_todo {fast blip hq}
+	set resampler_result [format "%s: resampling the PSG, emulated seconds per second:" \
+		[machine_info config_name]]
+	after time 0 [namespace code [list next_resampler $seconds]]
+	return ""
+}
+
+proc next_resampler {seconds} {
+	variable resampler_todo
+	set ::resampler [lindex $resampler_todo 0]
+	set ::throttle off
+	start_measure $seconds [list report_resampler $seconds]
+}
+
+proc report_resampler {seconds} {
+	variable old_resampler
+	variable resampler_todo
+	variable resampler_result
+
+	lassign [stop_measure] emu wall
+	append resampler_result [format "\n  %-5s %.2f" $::resampler [expr {$emu / $wall}]]
+	set resampler_todo [lrange $resampler_todo 1 end]
+	if {[llength $resampler_todo] != 0} {
+		next_resampler $seconds
+		return
+	}
+	set ::resampler $old_resampler
+	puts stdout $resampler_result
+	message $resampler_result
+}
+
+proc start_emulation_measure {seconds} {
+	# (re)enabling clears the statistics
+	set ::scheduler_stats on
+	start_measure $seconds report_emulation
+}
+
+proc start_measure {seconds report_proc} {
+	variable start_wall
+	variable start_emu
+	set start_wall [clock microseconds]
+	set start_emu [machine_info time]
+	after time $seconds [namespace code $report_proc]
+}
+
+# Returns the measured {emulated wall} times (in seconds) and restores the
+# throttle setting.
+proc stop_measure {} {
+	variable start_wall
+	variable start_emu
+	variable old_throttle
+
+	set wall [expr {([clock microseconds] - $start_wall) / 1000000.0}]
+	set emu  [expr {[machine_info time] - $start_emu}]
+	set ::throttle $old_throttle
+	return [list $emu $wall]
+}
+
+proc report_emulation {} {
+	variable old_stats
+	variable done_cmd
+
+	lassign [stop_measure] emu wall
+	set result [format "%s: emulated %.2fs in %.2fs: %.2f emulated seconds per second" \
+		[machine_info config_name] $emu $wall [expr {$emu / $wall}]]
+	set rest $wall
+	foreach entry [machine_info scheduler_stats device] {
+		lassign $entry name calls time
+		append result [format "\n  %-30s %6.2f%% %10d calls" \
+			$name [expr {100.0 * $time / $wall}] $calls]
+		set rest [expr {$rest - $time}]
+	}
+	append result [format "\n  %-30s %6.2f%%" "CPU and other" [expr {100.0 * $rest / $wall}]]
+	set ::scheduler_stats $old_stats
+	puts stdout $result
+	message $result
+
+	if {$done_cmd ne ""} {
+		uplevel #0 $done_cmd
+	}
+}
+
+proc report_cpu {} {
+	lassign [stop_measure] emu wall
+
+	set cpu [get_active_cpu]
+	set freq [expr {($cpu eq "r800") ? 7.15909 : 3.579545}]
+	set mhz [expr {$freq * $emu / $wall}]
+	set result [format "%s: emulated %.2fs in %.2fs: %.2f emulated MHz (%.2f x real speed)" \
+		$cpu $emu $wall $mhz [expr {$emu / $wall}]]
+	puts stdout $result
+	message $result
+}
+
+namespace export cpu_benchmark
+namespace export emulation_benchmark
+namespace export sprite_benchmark
+namespace export resampler_benchmark
+
+} ;# namespace benchmark
+
+namespace import benchmark::*
@@ -84,6 +84,105 @@ proc go_forward_one_step {} {
 	goto_time_delta [expr { $::speed / 100.0}]
 }
 
+set_help_text reverse_bisect \
+{Search the reverse history for the first moment a condition becomes true.
+
+Usage:
+  reverse_bisect [-precision <seconds>] [-begin <time>] [-end <time>] <condition>
+
+<condition> is a Tcl expression (e.g. {[peek 0xC000] == 3}). It must be false\
+before and true after the moment that is searched for. The search is a binary\
+search over the time range <begin>..<end> (default: the complete history),\
+each step jumps to a point in time with 'reverse goto -novideo' and evaluates\
+the condition there. The search stops when the range is smaller than\
+<precision> (default 0.02s, about one frame).
+
+This is typically used on a replay that was loaded with 'reverse loadreplay'.\
+Going to a point in time that's far away from the nearest snapshot also\
+creates new snapshots on the way, so later steps become faster.
+
+The result is the first time where the condition is true (with the given\
+precision), the machine is left at that time. An error is raised when the\
+condition isn't true at the end of the range.
+
+<begin> and <end> must be inside the reverse history (see 'reverse status')\
+and <begin> must be before <end>. Because they restrict the range, a long\
+search can be split over multiple openMSX processes, each loading the same\
+replay. For example, to search the first 10 minutes of a replay with two\
+processes, in both do 'reverse loadreplay mygame.omr' and then:
+  process 1: reverse_bisect -begin 0 -end 300 {[peek 0xC000] == 3}
+  process 2: reverse_bisect -begin 300 -end 600 {[peek 0xC000] == 3}
+The answer is the result of the first process (in time order) that doesn't\
+raise an error: when the moment lies in the second half, process 1 fails\
+because the condition is not true at its end, and process 2 returns a time\
+after 300. When it lies in the first half, process 2 immediately returns 300.
+}
+proc reverse_bisect {args} {
+	set precision 0.02
+	set condition ""
+	set stats [reverse status]
+	if {[dict get $stats status] eq "disabled"} {
+		error "Reverse is not enabled"
+	}
+	set histBegin [dict get $stats begin]
+	set histEnd   [dict get $stats end]
+	set lo $histBegin
+	set hi $histEnd
+	while {[llength $args] > 0} {
+		set args [lassign $args arg]
+		switch -- $arg {
+			"-precision" {set args [lassign $args precision]}
+			"-begin"     {set args [lassign $args lo]}
+			"-end"       {set args [lassign $args hi]}
+			default {
+				if {$condition ne ""} {error "Too many arguments"}
+				set condition $arg
+			}
+		}
+	}
+	if {$condition eq ""} {error "Missing condition"}
+	if {![string is double -strict $precision] || $precision <= 0} {
+		error "Expected a positive precision, got: $precision"
+	}
+	foreach {option value} [list -begin $lo -end $hi] {
+		if {![string is double -strict $value]} {
+			error "Expected a time for $option, got: $value"
+		}
+		if {$value < $histBegin || $value > $histEnd} {
+			error "$option must be inside the reverse history\
+			       ($histBegin..$histEnd), got: $value"
+		}
+	}
+	if {$lo >= $hi} {
+		error "-begin ($lo) must be before -end ($hi)"
+	}
+
+	reverse goto -novideo $hi
+	if {![bisect_check $condition]} {
+		error "Condition is not true at the end of the range ($hi)"
+	}
+	reverse goto -novideo $lo
+	if {[bisect_check $condition]} {
+		return $lo
+	}
+	# invariant: condition false at 'lo', true at 'hi'
+	while {($hi - $lo) > $precision} {
+		set mid [expr {($lo + $hi) / 2.0}]
+		reverse goto -novideo $mid
+		if {[bisect_check $condition]} {
+			set hi $mid
+		} else {
+			set lo $mid
+		}
+	}
+	reverse goto $hi
+	return $hi
+}
+
+proc bisect_check {condition} {
+	uplevel #0 [list expr $condition]
+}
+
 
 # reverse bookmarks
 
@@ -280,6 +379,7 @@ namespace export reverse_next
 namespace export goto_time_delta
 namespace export go_back_one_step
 namespace export go_forward_one_step
+namespace export reverse_bisect
 namespace export reverse_bookmarks
 
 } ;# namespace reverse
@@ -19,7 +19,20 @@ proc savestate_common {} {
 	}
 }
 
-proc savestate {{name ""}} {
+proc savestate {args} {
+	set format "xml"
+	set name ""
+	while {[llength $args] > 0} {
+		set args [lassign $args arg]
+		if {$arg eq "-format"} {
+			if {[llength $args] == 0} {error "Missing argument for -format"}
+			set args [lassign $args format]
+		} elseif {$name eq ""} {
+			set name $arg
+		} else {
+			error "Too many arguments"
+		}
+	}
 	savestate_common
 	file mkdir $directory
 	if {[catch {screenshot -raw -doublesize $png}]} {
@@ -32,7 +45,7 @@ proc savestate {{name ""}} {
 	}
 	set currentID [machine]
 	# always save using the new (.oms) name
-	store_machine $currentID $fullname_oms
+	store_machine -format $format $currentID $fullname_oms
 	# if successful, delete the old (.gz) filename (deleting a non-exiting
 	# file is not an error)
 	file delete -- $fullname_gz
@@ -129,12 +142,14 @@ proc savestate_list_tab {args} {
 
 # savestate
 set_help_text savestate \
-{savestate [<name>]
+{savestate [-format <xml|bin>] [<name>]
 
 Create a snapshot of the current emulated MSX machine.
 
 Optionally you can specify a name for the savestate. If you omit this the default name 'quicksave' will be taken.
 
+By default the savestate is stored as (compressed) XML. With '-format bin' a compact binary format is used instead, which is a lot faster to save and to load. 'loadstate' accepts both formats.
+
 See also 'loadstate', 'list_savestates', 'delete_savestate'.
 }
 set_tabcompletion_proc savestate [namespace code savestate_tab]
@@ -3,6 +3,7 @@
 #  (preferably keep this list sorted on script name)
 register_lazy "_about.tcl" about
 register_lazy "_backwards_compatibility.tcl" {quit decr restoredefault alias}
+register_lazy "_benchmark.tcl" {cpu_benchmark emulation_benchmark sprite_benchmark resampler_benchmark}
 register_lazy "_cheat.tcl" findcheat
 register_lazy "_cashandler.tcl" {casload cassave caslist casrun caspos caseject tapedeck}
 register_lazy "_cpuregs.tcl" {reg cpuregs get_active_cpu}
@@ -40,7 +41,7 @@ register_lazy "_record_chunks.tcl" record_chunks
 register_lazy "_reg_log.tcl" reg_log
 register_lazy "_reverse.tcl" {
 	reverse_prev reverse_next goto_time_delta go_back_one_step
-	go_forward_one_step reverse_bookmarks
+	go_forward_one_step reverse_bookmarks reverse_bisect
 	toggle_reversebar enable_reversebar disable_reversebar auto_enable}
 register_lazy "_rom_info.tcl" {rom_info getlist_rom_info}
 register_lazy "_save_debuggable.tcl" {
@@ -28,12 +28,14 @@ byte MSXDevice::unmappedWrite[0x10000];
 
 MSXDevice::MSXDevice(const DeviceConfig& config, const string& name)
 	: deviceConfig(config)
+	, fineCacheLines(false)
 {
 	initName(name);
 }
 
 MSXDevice::MSXDevice(const DeviceConfig& config)
 	: deviceConfig(config)
+	, fineCacheLines(false)
 {
 	initName(getDeviceConfig().getAttribute("id"));
 }
@@ -429,9 +431,9 @@ void MSXDevice::writeMem(word /*address*/, byte /*value*/,
 
 byte MSXDevice::peekMem(word address, EmuTime::param /*time*/) const
 {
-	word base = address & CacheLine::HIGH;
-	if (const byte* cache = getReadCacheLine(base)) {
-		word offset = address & CacheLine::LOW;
+	word base = address & FineCacheLine::HIGH;
+	if (const byte* cache = lookupReadCacheLine(base)) {
+		word offset = address & FineCacheLine::LOW;
 		return cache[offset];
 	} else {
 		// peek not supported for this device
@@ -3,6 +3,7 @@
 
 #include "DeviceConfig.hh"
 #include "EmuTime.hh"
+#include "CacheLine.hh"
 #include "openmsx.hh"
 #include "serialize_meta.hh"
 #include <string>
@@ -172,6 +173,30 @@ public:
 	 */
 	virtual byte* getWriteCacheLine(word start) const;
 
+	/** Calls getReadCacheLine() resp. getWriteCacheLine() with the
+	  * granularity this device supports (see setFineCacheLines()), and
+	  * returns the pointer for the interval [start, start +
+	  * FineCacheLine::SIZE). The start of the interval is
+	  * FineCacheLine::SIZE aligned.
+	  */
+	const byte* lookupReadCacheLine(word start) const {
+		if (fineCacheLines) return getReadCacheLine(start);
+		word base = start & CacheLine::HIGH;
+		const byte* line = getReadCacheLine(base);
+		return line ? line + (start - base) : nullptr;
+	}
+	byte* lookupWriteCacheLine(word start) const {
+		if (fineCacheLines) return getWriteCacheLine(start);
+		word base = start & CacheLine::HIGH;
+		byte* line = getWriteCacheLine(base);
+		return line ? line + (start - base) : nullptr;
+	}
+
+	/** Does this device support fine grained cache lines?
+	  * See setFineCacheLines().
+	  */
+	bool hasFineCacheLines() const { return fineCacheLines; }
+
 	/**
 	 * Read a byte from a given memory location. Reading memory
 	 * via this method has no side effects (doesn't change the
@@ -263,6 +288,19 @@ protected:
 	 */
 	virtual void getExtraDeviceInfo(TclObject& result) const;
 
+	/** Opt in for fine grained cache lines: getReadCacheLine() and
+	  * getWriteCacheLine() get called for intervals of
+	  * FineCacheLine::SIZE bytes (aligned at that size) instead of
+	  * CacheLine::SIZE bytes. So a device that can't hand out a whole
+	  * CacheLine::SIZE block (e.g. because there's a memory mapped
+	  * register in that block) can still allow direct access to the
+	  * rest of that block.
+	  * Only call this (in the constructor) when the implementation of
+	  * these two methods handles such smaller intervals correctly (so
+	  * it should use FineCacheLine instead of CacheLine constants).
+	  */
+	void setFineCacheLines() { fineCacheLines = true; }
+
 public:
 	// public to allow non-MSXDevices to use these same arrays
 	static byte unmappedRead [0x10000]; // Read only
@@ -294,6 +332,8 @@ private:
 
 	int ps;
 	int ss;
+
+	bool fineCacheLines;
 };
 
 REGISTER_BASE_NAME_HELPER(MSXDevice, "Device");
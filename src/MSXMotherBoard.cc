@@ -45,9 +45,11 @@
 #include "memory.hh"
 #include "stl.hh"
 #include "unreachable.hh"
+#include <algorithm>
 #include <cassert>
 #include <functional>
 #include <iostream>
+#include <map>
 
 using std::string;
 using std::vector;
@@ -131,6 +133,18 @@ private:
 	MSXMotherBoard& motherBoard;
 };
 
+class SchedulerStatsInfo final : public InfoTopic
+{
+public:
+	explicit SchedulerStatsInfo(MSXMotherBoard& motherBoard);
+	void execute(array_ref<TclObject> tokens,
+	             TclObject& result) const override;
+	string help(const vector<string>& tokens) const override;
+	void tabCompletion(vector<string>& tokens) const override;
+private:
+	MSXMotherBoard& motherBoard;
+};
+
 class FastForwardHelper final : private Schedulable
 {
 public:
@@ -193,6 +207,7 @@ MSXMotherBoard::MSXMotherBoard(Reactor& reactor_)
 	removeExtCommand = make_unique<RemoveExtCmd>(*this);
 	machineNameInfo = make_unique<MachineNameInfo>(*this);
 	deviceInfo = make_unique<DeviceInfo>(*this);
+	schedulerStatsInfo = make_unique<SchedulerStatsInfo>(*this);
 	debugger = make_unique<Debugger>(*this);
 
 	msxMixer->mute(); // powered down
@@ -211,12 +226,19 @@ MSXMotherBoard::MSXMotherBoard(Reactor& reactor_)
 		*reverseManager);
 	realTime = make_unique<RealTime>(
 		*this, reactor.getGlobalSettings(), *eventDelay);
+	schedulerStatsSetting = make_unique<BooleanSetting>(
+		*msxCommandController, "scheduler_stats",
+		"collect statistics about the emulated devices, "
+		"see 'machine_info scheduler_stats'",
+		false, Setting::DONT_SAVE);
 
 	powerSetting.attach(*settingObserver);
+	schedulerStatsSetting->attach(*settingObserver);
 }
 
 MSXMotherBoard::~MSXMotherBoard()
 {
+	schedulerStatsSetting->detach(*settingObserver);
 	powerSetting.detach(*settingObserver);
 	deleteMachine();
 
@@ -956,6 +978,88 @@ void DeviceInfo::tabCompletion(vector<string>& tokens) const
 }
 
 
+// SchedulerStatsInfo
+
+SchedulerStatsInfo::SchedulerStatsInfo(MSXMotherBoard& motherBoard_)
+	: InfoTopic(motherBoard_.getMachineInfoCommand(), "scheduler_stats")
+	, motherBoard(motherBoard_)
+{
+}
+
+void SchedulerStatsInfo::execute(array_ref<TclObject> tokens,
+                                 TclObject& result) const
+{
+	bool perDevice = false;
+	switch (tokens.size()) {
+	case 2:
+		break;
+	case 3:
+		if (tokens[2] == "class") {
+			perDevice = false;
+		} else if (tokens[2] == "device") {
+			perDevice = true;
+		} else {
+			throw CommandException(
+				"Expected 'class' or 'device', got: " +
+				tokens[2].getString());
+		}
+		break;
+	default:
+		throw SyntaxError();
+	}
+
+	// Group per class or per device. Schedulables that don't belong to
+	// a device are listed by their class name in the per device list.
+	std::map<string, Scheduler::Stats> groups;
+	for (auto& p : motherBoard.getScheduler().getStats()) {
+		const auto& className  = p.first.first;
+		const auto& deviceName = p.first.second;
+		auto& g = groups[(perDevice && !deviceName.empty())
+		                 ? deviceName : className];
+		g.calls += p.second.calls;
+		g.time  += p.second.time;
+	}
+
+	// most expensive first
+	vector<std::pair<string, Scheduler::Stats>> sorted(
+		groups.begin(), groups.end());
+	sort(begin(sorted), end(sorted),
+	     [](const std::pair<string, Scheduler::Stats>& x,
+	        const std::pair<string, Scheduler::Stats>& y) {
+		return x.second.time > y.second.time; });
+
+	for (auto& p : sorted) {
+		TclObject line;
+		line.addListElement(p.first);
+		line.addListElement(StringOp::toString(
+			static_cast<unsigned long long>(p.second.calls)));
+		line.addListElement(p.second.time / 1e9);
+		result.addListElement(line);
+	}
+}
+
+string SchedulerStatsInfo::help(const vector<string>& /*tokens*/) const
+{
+	return "machine_info scheduler_stats [class|device]\n"
+	       "Returns statistics about the sync points (the points in "
+	       "time where the emulation of a device, e.g. the VDP or a "
+	       "sound chip, is brought up-to-date) that were executed since "
+	       "the 'scheduler_stats' setting was enabled. The result is a "
+	       "list of {<name> <number of calls> <host time in seconds>} "
+	       "entries, most expensive first. The entries are grouped per "
+	       "C++ class (the default) or per MSX device. The time spent "
+	       "emulating the CPU itself is not included.";
+}
+
+void SchedulerStatsInfo::tabCompletion(vector<string>& tokens) const
+{
+	if (tokens.size() == 3) {
+		static const char* const modes[] = { "class", "device" };
+		completeString(tokens, modes);
+	}
+}
+
+
 // FastForwardHelper
 
 FastForwardHelper::FastForwardHelper(MSXMotherBoard& motherBoard_)
@@ -1008,6 +1112,9 @@ void SettingObserver::update(const Setting& setting)
 		} else {
 			motherBoard.powerDown();
 		}
+	} else if (&setting == motherBoard.schedulerStatsSetting.get()) {
+		motherBoard.getScheduler().setStatsEnabled(
+			motherBoard.schedulerStatsSetting->getBoolean());
 	} else {
 		UNREACHABLE;
 	}
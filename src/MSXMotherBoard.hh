@@ -52,6 +52,7 @@ class ResetCmd;
 class ReverseManager;
 class SettingObserver;
 class Scheduler;
+class SchedulerStatsInfo;
 class Setting;
 class StateChangeDistributor;
 
@@ -252,12 +253,15 @@ private:
 	std::unique_ptr<MachineNameInfo> machineNameInfo;
 	std::unique_ptr<DeviceInfo>   deviceInfo;
 	friend class DeviceInfo;
+	std::unique_ptr<SchedulerStatsInfo> schedulerStatsInfo;
+	friend class SchedulerStatsInfo;
 
 	std::unique_ptr<FastForwardHelper> fastForwardHelper;
 
 	std::unique_ptr<SettingObserver> settingObserver;
 	friend class SettingObserver;
 	BooleanSetting& powerSetting;
+	std::unique_ptr<BooleanSetting> schedulerStatsSetting;
 
 	bool powered;
 	bool active;
@@ -35,6 +35,7 @@
 #include "FileOperations.hh"
 #include "ReadDir.hh"
 #include "Thread.hh"
+#include "WorkerThread.hh"
 #include "Timer.hh"
 #include "serialize.hh"
 #include "openmsx.hh"
@@ -204,6 +205,7 @@ void Reactor::init()
 	virtualDrive = make_unique<DiskChanger>(
 		*this, "virtual_drive");
 	filePool = make_unique<FilePool>(*globalCommandController, *this);
+	backgroundWorker = make_unique<WorkerThread>();
 	userSettings = make_unique<UserSettings>(
 		*globalCommandController);
 	softwareDatabase = make_unique<RomDatabase>(
@@ -869,29 +871,60 @@ StoreMachineCommand::StoreMachineCommand(
 
 void StoreMachineCommand::execute(array_ref<TclObject> tokens, TclObject& result)
 {
+	bool binary = false;
+	vector<string> arguments;
+	for (size_t i = 1; i < tokens.size(); ++i) {
+		string_ref token = tokens[i].getString();
+		if (token == "-format") {
+			if (++i == tokens.size()) {
+				throw CommandException("Missing argument");
+			}
+			string_ref format = tokens[i].getString();
+			if (format == "xml") {
+				binary = false;
+			} else if (format == "bin") {
+				binary = true;
+			} else {
+				throw CommandException(
+					"Unknown savestate format '" + format +
+					"', must be 'xml' or 'bin'.");
+			}
+		} else {
+			arguments.push_back(token.str());
+		}
+	}
+
 	string filename;
-	string_ref machineID;
-	switch (tokens.size()) {
-	case 1:
+	string machineID;
+	switch (arguments.size()) {
+	case 0:
 		machineID = reactor.getMachineID();
-		filename = FileOperations::getNextNumberedFileName("savestates", "openmsxstate", ".xml.gz");
 		break;
-	case 2:
-		machineID = tokens[1].getString();
-		filename = FileOperations::getNextNumberedFileName("savestates", "openmsxstate", ".xml.gz");
+	case 1:
+		machineID = arguments[0];
 		break;
-	case 3:
-		machineID = tokens[1].getString();
-		filename = tokens[2].getString().str();
+	case 2:
+		machineID = arguments[0];
+		filename = arguments[1];
 		break;
 	default:
 		throw SyntaxError();
 	}
+	if (filename.empty()) {
+		filename = FileOperations::getNextNumberedFileName(
+			"savestates", "openmsxstate", binary ? ".oms" : ".xml.gz");
+	}
 
 	auto& board = reactor.getMachine(machineID);
 
-	XmlOutputArchive out(filename);
-	out.serialize("machine", board);
+	if (binary) {
+		BinOutputArchive out(filename);
+		out.serialize("machine", board);
+		out.close();
+	} else {
+		XmlOutputArchive out(filename);
+		out.serialize("machine", board);
+	}
 	result.setString(filename);
 }
 
@@ -902,6 +935,11 @@ string StoreMachineCommand::help(const vector<string>& /*tokens*/) const
 		"store_machine machineID             Save state of machine \"machineID\" to file \"openmsxNNNN.xml.gz\"\n"
                 "store_machine machineID <filename>  Save state of machine \"machineID\" to indicated file\n"
 		"\n"
+		"All variants accept the option '-format <xml|bin>' (default xml). The binary\n"
+		"format is much faster to save and load, and results in smaller files (the\n"
+		"default filename then is \"openmsxNNNN.oms\"). restore_machine detects the\n"
+		"format automatically.\n"
+		"\n"
 		"This is a low-level command, the 'savestate' script is easier to use.";
 }
 
@@ -959,8 +997,13 @@ void RestoreMachineCommand::execute(array_ref<TclObject> tokens,
 
 	//std::cerr << "Loading " << filename << std::endl;
 	try {
-		XmlInputArchive in(filename);
-		in.serialize("machine", *newBoard);
+		if (BinInputArchive::isBinArchive(filename)) {
+			BinInputArchive in(filename);
+			in.serialize("machine", *newBoard);
+		} else {
+			XmlInputArchive in(filename);
+			in.serialize("machine", *newBoard);
+		}
 	} catch (XMLException& e) {
 		throw CommandException("Cannot load state, bad file format: " + e.getMessage());
 	} catch (MSXException& e) {
@@ -982,6 +1025,8 @@ string RestoreMachineCommand::help(const vector<string>& /*tokens*/) const
 		"restore_machine                       Load state from last saved state in default directory\n"
 		"restore_machine <filename>            Load state from indicated file\n"
 		"\n"
+		"Both XML and binary savestates (see 'help store_machine') can be loaded.\n"
+		"\n"
 		"This is a low-level command, the 'loadstate' script is easier to use.";
 }
 
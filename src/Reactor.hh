@@ -48,6 +48,7 @@ class RestoreMachineCommand;
 class AviRecorder;
 class ConfigInfo;
 class RealTimeInfo;
+class WorkerThread;
 template <typename T> class EnumSetting;
 
 /**
@@ -84,6 +85,7 @@ public:
 	EnumSetting<int>& getMachineSetting() { return *machineSetting; }
 	RomDatabase& getSoftwareDatabase() { return *softwareDatabase; }
 	FilePool& getFilePool() { return *filePool; }
+	WorkerThread& getBackgroundWorker() { return *backgroundWorker; }
 
 	void switchMachine(const std::string& machine);
 	MSXMotherBoard* getMotherBoard() const;
@@ -144,6 +146,7 @@ private:
 	std::unique_ptr<DiskManipulator> diskManipulator;
 	std::unique_ptr<DiskChanger> virtualDrive;
 	std::unique_ptr<FilePool> filePool;
+	std::unique_ptr<WorkerThread> backgroundWorker;
 
 	std::unique_ptr<EnumSetting<int>> machineSetting;
 	std::unique_ptr<UserSettings> userSettings;
@@ -13,6 +13,7 @@
 #include "FileContext.hh"
 #include "StateChange.hh"
 #include "Timer.hh"
+#include "WorkerThread.hh"
 #include "CliComm.hh"
 #include "Display.hh"
 #include "Reactor.hh"
@@ -23,6 +24,7 @@
 #include "serialize_stl.hh"
 #include "xrange.hh"
 #include <functional>
+#include <set>
 #include <cassert>
 #include <cmath>
 
@@ -103,8 +105,9 @@ SERIALIZE_CLASS_VERSION(Replay, 4);
 
 void ReverseManager::ReverseHistory::swap(ReverseHistory& other)
 {
-	std::swap(chunks, other.chunks);
-	std::swap(events, other.events);
+	std::swap(chunks,          other.chunks);
+	std::swap(events,          other.events);
+	std::swap(lastDeltaBlocks, other.lastDeltaBlocks);
 }
 
 void ReverseManager::ReverseHistory::clear()
@@ -112,6 +115,7 @@ void ReverseManager::ReverseHistory::clear()
 	// clear() and free storage capacity
 	Chunks().swap(chunks);
 	Events().swap(events);
+	lastDeltaBlocks.clear();
 }
 
 
@@ -254,14 +258,21 @@ void ReverseManager::debugInfo(TclObject& result) const
 	// information means nothing. We should remove this later.
 	StringOp::Builder res;
 	size_t totalSize = 0;
+	std::set<const DeltaBlock*> seenBlocks; // count shared blocks only once
 	for (auto& p : history.chunks) {
 		auto& chunk = p.second;
+		size_t deltaSize = 0;
+		for (auto& block : chunk.deltaBlocks) {
+			if (seenBlocks.insert(block.get()).second) {
+				deltaSize += block->getDeltaSize();
+			}
+		}
 		res << p.first << ' '
 		    << (chunk.time - EmuTime::zero).toDouble() << ' '
 		    << ((chunk.time - EmuTime::zero).toDouble() / (getCurrentTime() - EmuTime::zero).toDouble()) * 100 << '%'
-		    << " (" << chunk.size << ')'
+		    << " (" << chunk.size << " + " << deltaSize << ')'
 		    << " (next event index: " << chunk.eventCount << ")\n";
-		totalSize += chunk.size;
+		totalSize += chunk.size + deltaSize;
 	}
 	res << "total size: " << totalSize << '\n';
 	result.setString(string(res));
@@ -415,7 +426,8 @@ void ReverseManager::goTo(
 			newBoard_ = reactor.createEmptyMotherBoard();
 			newBoard = newBoard_.get();
 			MemInputArchive in(it->second.savestate.data(),
-					   it->second.size);
+					   it->second.size,
+					   it->second.deltaBlocks);
 			in.serialize("machine", *newBoard);
 
 			if (eventDelay) {
@@ -595,7 +607,8 @@ void ReverseManager::saveReplay(
 	// restore first snapshot to be able to serialize it to a file
 	auto initialBoard = reactor.createEmptyMotherBoard();
 	MemInputArchive in(begin(chunks)->second.savestate.data(),
-	                   begin(chunks)->second.size);
+	                   begin(chunks)->second.size,
+	                   begin(chunks)->second.deltaBlocks);
 	in.serialize("machine", *initialBoard);
 	replay.motherBoards.push_back(move(initialBoard));
 
@@ -623,7 +636,8 @@ void ReverseManager::saveReplay(
 					// this is a new one, add it to the list of snapshots
 					Reactor::Board board = reactor.createEmptyMotherBoard();
 					MemInputArchive in2(it->second.savestate.data(),
-							    it->second.size);
+							    it->second.size,
+							    it->second.deltaBlocks);
 					in2.serialize("machine", *board);
 					replay.motherBoards.push_back(move(board));
 					lastAddedIt = it;
@@ -765,7 +779,8 @@ void ReverseManager::loadReplay(
 		ReverseChunk newChunk;
 		newChunk.time = m->getCurrentTime();
 
-		MemOutputArchive out;
+		MemOutputArchive out(newHistory.lastDeltaBlocks,
+		                     newChunk.deltaBlocks);
 		out.serialize("machine", *m);
 		newChunk.savestate = out.releaseBuffer(newChunk.size);
 
@@ -798,6 +813,9 @@ void ReverseManager::transferHistory(ReverseHistory& oldHistory,
 
 	// actual history transfer
 	history.swap(oldHistory);
+	// The keyframes were taken from the memory blocks of the old machine,
+	// new snapshots of this machine can't share them.
+	history.lastDeltaBlocks.clear();
 
 	// resume collecting (and event recording)
 	collecting = true;
@@ -902,12 +920,32 @@ void ReverseManager::takeSnapshot(EmuTime::param time)
 	// the same moment in time).
 
 	// actually create new snapshot
-	MemOutputArchive out;
+	vector<shared_ptr<DeltaBlock>> deltaBlocks;
+	MemOutputArchive out(history.lastDeltaBlocks, deltaBlocks);
 	out.serialize("machine", motherBoard);
 	ReverseChunk& newChunk = history.chunks[seqNum];
+	newChunk.deltaBlocks.swap(deltaBlocks);
 	newChunk.time = time;
 	newChunk.savestate = out.releaseBuffer(newChunk.size);
 	newChunk.eventCount = replayIndex;
+
+	compressOldKeyframes();
+}
+
+void ReverseManager::compressOldKeyframes()
+{
+	// Keyframes that got replaced by a newer keyframe are only needed to
+	// restore older snapshots. Compressing them takes a relatively long
+	// time, so do that in a background thread to avoid a hiccup in the
+	// emulation each time a snapshot is taken. The task only holds a
+	// weak reference: there's no point in compressing a block of which
+	// the snapshot(s) got dropped in the mean time.
+	auto& worker = motherBoard.getReactor().getBackgroundWorker();
+	for (auto& keyframe : history.lastDeltaBlocks.releaseOldKeyframes()) {
+		worker.addTask([keyframe]() {
+			if (auto block = keyframe.lock()) block->compress();
+		});
+	}
 }
 
 void ReverseManager::replayNextEvent()
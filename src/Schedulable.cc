@@ -12,6 +12,7 @@ Schedulable::Schedulable(Scheduler& scheduler_)
 Schedulable::~Schedulable()
 {
 	removeSyncPoints();
+	scheduler.schedulableDeleted(*this);
 }
 
 void Schedulable::schedulerDeleted()
@@ -20,6 +21,11 @@ void Schedulable::schedulerDeleted()
 	          << "\" failed to unregister." << std::endl;
 }
 
+std::string Schedulable::getStatsDeviceName() const
+{
+	return {};
+}
+
 void Schedulable::setSyncPoint(EmuTime::param timestamp)
 {
 	scheduler.setSyncPoint(timestamp, *this);
@@ -5,6 +5,7 @@
 #include "serialize.hh"
 #include "serialize_meta.hh"
 #include "serialize_stl.hh"
+#include <string>
 
 namespace openmsx {
 
@@ -55,6 +56,13 @@ public:
 	 */
 	virtual void schedulerDeleted();
 
+	/** The name of the MSX device this Schedulable belongs to. Only used
+	  * to group the scheduler statistics (see 'machine_info
+	  * scheduler_stats'). The default implementation returns an empty
+	  * string, meaning: not part of a specific device.
+	  */
+	virtual std::string getStatsDeviceName() const;
+
 	Scheduler& getScheduler() const { return scheduler; }
 
 	/** Convenience method:
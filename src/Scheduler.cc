@@ -3,9 +3,16 @@
 #include "Thread.hh"
 #include "MSXCPU.hh"
 #include "serialize.hh"
+#include "StringOp.hh"
 #include <cassert>
 #include <algorithm>
+#include <chrono>
+#include <cstdlib>
 #include <iterator> // for back_inserter
+#include <typeinfo>
+#if defined(__GNUC__)
+#include <cxxabi.h>
+#endif
 
 namespace openmsx {
 
@@ -22,7 +29,9 @@ struct EqualSchedulable {
 Scheduler::Scheduler()
 	: scheduleTime(EmuTime::zero)
 	, cpu(nullptr)
+	, statsGeneration(0)
 	, scheduleInProgress(false)
+	, statsEnabled(false)
 {
 }
 
@@ -43,10 +52,13 @@ void Scheduler::setSyncPoint(EmuTime::param time, Schedulable& device)
 	assert(time >= scheduleTime);
 
 	// Push sync point into queue.
+#if SCHEDULER_HEAP_QUEUE
+	queue.insert(SynchronizationPoint(time, &device));
+#else
 	queue.insert(SynchronizationPoint(time, &device),
 	             [](SynchronizationPoint& sp) { sp.setTime(EmuTime::infinity); },
-	             [](const SynchronizationPoint& x, const SynchronizationPoint& y) {
-	                     return x.getTime() < y.getTime(); });
+	             EarlierSyncPoint());
+#endif
 
 	if (!scheduleInProgress && cpu) {
 		// only when scheduleHelper() is not being executed
@@ -61,6 +73,10 @@ Scheduler::SyncPoints Scheduler::getSyncPoints(const Schedulable& device) const
 	SyncPoints result;
 	copy_if(std::begin(queue), std::end(queue), back_inserter(result),
 	        EqualSchedulable(device));
+	// The queue is not necessarily sorted (see SchedulerHeapQueue). All
+	// these sync points belong to the same device, so sorting on time
+	// alone gives a deterministic result.
+	std::sort(std::begin(result), std::end(result), EarlierSyncPoint());
 	return result;
 }
 
@@ -80,14 +96,22 @@ bool Scheduler::pendingSyncPoint(const Schedulable& device,
                                  EmuTime& result) const
 {
 	assert(Thread::isMainThread());
-	auto it = std::find_if(std::begin(queue), std::end(queue),
-	                       EqualSchedulable(device));
-	if (it != std::end(queue)) {
-		result = it->getTime();
-		return true;
-	} else {
-		return false;
+	// Find the earliest one, the queue is not necessarily sorted.
+	bool found = false;
+	for (auto& sp : queue) {
+		if ((sp.getDevice() == &device) &&
+		    (!found || (sp.getTime() < result))) {
+			result = sp.getTime();
+			found = true;
+		}
 	}
+	return found;
+}
+
+void Scheduler::schedulableDeleted(const Schedulable& device)
+{
+	// A new Schedulable may later be created at the same address.
+	statsCache.erase(&device);
 }
 
 EmuTime::param Scheduler::getCurrentTime() const
@@ -109,7 +133,11 @@ void Scheduler::scheduleHelper(EmuTime::param limit, EmuTime next)
 
 		queue.remove_front();
 
-		device->executeUntil(next);
+		if (unlikely(statsEnabled)) {
+			executeWithStats(*device, next);
+		} else {
+			device->executeUntil(next);
+		}
 
 		next = getNext();
 		if (likely(next > limit)) break;
@@ -119,6 +147,68 @@ void Scheduler::scheduleHelper(EmuTime::param limit, EmuTime next)
 	cpu->setNextSyncPoint(next);
 }
 
+void Scheduler::setStatsEnabled(bool enabled)
+{
+	statsEnabled = enabled;
+	++statsGeneration;
+	stats.clear();
+	statsCache.clear();
+}
+
+void Scheduler::executeWithStats(Schedulable& device, EmuTime::param time)
+{
+	// Lookup before starting the measurement, so that the first call
+	// of each Schedulable doesn't include the name lookup.
+	auto& s = getStatsFor(device);
+	auto generation = statsGeneration;
+
+	using namespace std::chrono;
+	auto start = steady_clock::now();
+	device.executeUntil(time);
+	auto duration = steady_clock::now() - start;
+
+	// Don't use 's' when executeUntil() (e.g. a Tcl 'after' callback)
+	// changed the setting, this cleared the statistics.
+	if (generation == statsGeneration) {
+		++s.calls;
+		s.time += duration_cast<nanoseconds>(duration).count();
+	}
+}
+
+// Returns the (unmangled) name of the dynamic type of the given Schedulable,
+// without the 'openmsx::' prefix.
+static std::string getClassName(const Schedulable& device)
+{
+	const char* name = typeid(device).name();
+	std::string result;
+#if defined(__GNUC__)
+	int status;
+	if (char* demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status)) {
+		result = demangled;
+		free(demangled);
+	} else {
+		result = name;
+	}
+#else
+	result = name; // MSVC already returns a readable name
+	if (StringOp::startsWith(result, "class ")) result.erase(0, 6);
+	if (StringOp::startsWith(result, "struct ")) result.erase(0, 7);
+#endif
+	if (StringOp::startsWith(result, "openmsx::")) result.erase(0, 9);
+	return result;
+}
+
+Scheduler::Stats& Scheduler::getStatsFor(const Schedulable& device)
+{
+	auto it = statsCache.find(&device);
+	if (likely(it != statsCache.end())) return *it->second;
+
+	auto& s = stats[std::make_pair(getClassName(device),
+	                               device.getStatsDeviceName())];
+	statsCache[&device] = &s;
+	return s;
+}
+
 
 template <typename Archive>
 void SynchronizationPoint::serialize(Archive& ar, unsigned /*version*/)
@@ -3,11 +3,26 @@
 
 #include "EmuTime.hh"
 #include "SchedulerQueue.hh"
+#include "SchedulerHeapQueue.hh"
+#include "hash_map.hh"
 #include "likely.hh"
+#include <map>
+#include <string>
+#include <utility>
 #include <vector>
 
 namespace openmsx {
 
+// Select the data structure for the queue of pending sync points:
+//  0: SchedulerQueue, a sorted array, very fast for the typical number of
+//     sync points (~10), but inserting is O(N)
+//  1: SchedulerHeapQueue, same as above for a small number of sync points,
+//     switches to a heap when there are many sync points (large machine
+//     configs with many extensions)
+#ifndef SCHEDULER_HEAP_QUEUE
+#define SCHEDULER_HEAP_QUEUE 1
+#endif
+
 class Schedulable;
 class MSXCPU;
 
@@ -30,6 +45,13 @@ private:
 	Schedulable* device;
 };
 
+struct EarlierSyncPoint {
+	bool operator()(const SynchronizationPoint& x,
+	                const SynchronizationPoint& y) const {
+		return x.getTime() < y.getTime();
+	}
+};
+
 
 class Scheduler
 {
@@ -69,6 +91,28 @@ public:
 		scheduleTime = limit;
 	}
 
+	/** Statistics about the executeUntil() calls of a group of
+	  * Schedulables.
+	  */
+	struct Stats {
+		Stats() : calls(0), time(0) {}
+		uint64_t calls; // number of executeUntil() calls
+		uint64_t time;  // total host time spent in these calls (in ns)
+	};
+	/** Statistics per (Schedulable subclass name, device name) pair.
+	  * The device name is empty for Schedulables that don't belong to an
+	  * MSX device, see Schedulable::getStatsDeviceName().
+	  */
+	using StatsMap = std::map<std::pair<std::string, std::string>, Stats>;
+
+	/** Enable/disable collecting statistics about the executed sync
+	  * points. Collecting has a small overhead, so it's disabled by
+	  * default. Enabling (again) clears the previously collected data.
+	  */
+	void setStatsEnabled(bool enabled);
+	bool isStatsEnabled() const { return statsEnabled; }
+	const StatsMap& getStats() const { return stats; }
+
 	template <typename Archive>
 	void serialize(Archive& ar, unsigned version);
 
@@ -106,16 +150,34 @@ private: // -> intended for Schedulable
 	 */
 	bool pendingSyncPoint(const Schedulable& device, EmuTime& result) const;
 
+	/** Called when the given Schedulable is destroyed.
+	  */
+	void schedulableDeleted(const Schedulable& device);
+
 private:
 	void scheduleHelper(EmuTime::param limit, EmuTime next);
+	void executeWithStats(Schedulable& device, EmuTime::param time);
+	Stats& getStatsFor(const Schedulable& device);
 
-	/** Vector used as heap, not a priority queue because that
-	  * doesn't allow removal of non-top element.
+	/** Not a std::priority_queue because that doesn't allow removal of
+	  * non-top element.
 	  */
+#if SCHEDULER_HEAP_QUEUE
+	SchedulerHeapQueue<SynchronizationPoint, EarlierSyncPoint> queue;
+#else
 	SchedulerQueue<SynchronizationPoint> queue;
+#endif
 	EmuTime scheduleTime;
 	MSXCPU* cpu;
+
+	StatsMap stats;
+	// Lookup of the entry in 'stats' for a Schedulable. Only used to
+	// avoid the (relatively expensive) name lookup on each call.
+	hash_map<const Schedulable*, Stats*> statsCache;
+	unsigned statsGeneration; // changes each time 'stats' is cleared
+
 	bool scheduleInProgress;
+	bool statsEnabled;
 };
 
 } // namespace openmsx
@@ -0,0 +1,285 @@
+#ifndef SCHEDULERHEAPQUEUE_HH
+#define SCHEDULERHEAPQUEUE_HH
+
+#include "MemBuffer.hh"
+#include "likely.hh"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+
+namespace openmsx {
+
+// Alternative for SchedulerQueue that scales better to a large number of
+// elements.
+//
+// As long as the number of elements stays small (below HEAP_THRESHOLD), this
+// is a sorted array, very similar to SchedulerQueue: it also has spare
+// capacity at the front, so removing the smallest element is O(1) and
+// inserting an element that's only slightly bigger than the smallest one is
+// often O(1) as well. But inserting an arbitrary element is O(N).
+//
+// When the array grows beyond HEAP_THRESHOLD elements, it's reinterpreted as
+// a d-ary heap (a sorted array already satisfies the heap property, so this
+// switch is free). In that mode insert and remove_front are O(log(N)). The
+// queue switches back to a sorted array when it becomes empty.
+//
+// Unlike SchedulerQueue, the ordering criterion is a template parameter of
+// the class (it's needed in more methods than only insert()).
+//
+// Elements that are equivalent according to LESS keep their relative order:
+// a newly inserted element comes after all existing equivalent elements. In
+// heap mode this is achieved by giving each element a sequence number.
+//
+// Iterating over the elements (begin(), end()) visits all elements, but in
+// heap mode not in sorted order. front() is always the smallest element.
+template<typename T, typename LESS> class SchedulerHeapQueue
+{
+public:
+	static const size_t CAPACITY = 32; // initial capacity
+	static const size_t SPARE_FRONT = 1;
+	static const size_t HEAP_THRESHOLD = 24;
+	static const size_t ARITY = 4; // a 4-ary heap is shallower than a
+	                               // binary one and its children share
+	                               // a cache line
+
+	explicit SchedulerHeapQueue(LESS less_ = LESS())
+		: items(CAPACITY)
+		, seqs (CAPACITY)
+		, capacity(CAPACITY)
+		, first(SPARE_FRONT)
+		, num(0)
+		, nextSeq(0)
+		, heapMode(false)
+		, less(less_)
+	{
+	}
+
+	size_t size()  const { return num; }
+	bool   empty() const { return num == 0; }
+
+	// Returns reference to the smallest element.
+	      T& front()       { assert(!empty()); return items[first]; }
+	const T& front() const { assert(!empty()); return items[first]; }
+
+	// Iteration in unspecified order.
+	      T* begin()       { return items.data() + first; }
+	const T* begin() const { return items.data() + first; }
+	      T* end()         { return items.data() + first + num; }
+	const T* end()   const { return items.data() + first + num; }
+
+	// Insert new element.
+	void insert(const T& t)
+	{
+		if (likely(!heapMode)) {
+			if (num < HEAP_THRESHOLD) {
+				insertSorted(t);
+				return;
+			}
+			heapMode = true;
+		}
+		insertHeap(t);
+	}
+
+	// Remove the smallest element.
+	void remove_front()
+	{
+		assert(!empty());
+		if (likely(!heapMode)) {
+			++first;
+			--num;
+			if (num == 0) first = SPARE_FRONT;
+			return;
+		}
+		--num;
+		if (num != 0) {
+			move(0, num);
+			siftDown(0);
+		} else {
+			reset();
+		}
+	}
+
+	// Remove the smallest element for which the given predicate returns
+	// true (when there are several equivalent ones, the one that was
+	// inserted first). This is the same element SchedulerQueue::remove()
+	// would remove.
+	template<typename PRED> bool remove(PRED p)
+	{
+		T* it = std::find_if(begin(), end(), p);
+		if (it == end()) return false;
+		size_t i = it - begin();
+
+		if (!heapMode) {
+			// sorted, so the first match is the smallest one
+			std::copy(it + 1, end(), it);
+			std::copy(seq(i + 1), seq(num), seq(i));
+			--num;
+			if (num == 0) first = SPARE_FRONT;
+			return true;
+		}
+		// heap order is not sorted order, look at all other matches
+		for (size_t j = i + 1; j != num; ++j) {
+			if (p(item(j)) && before(j, i)) i = j;
+		}
+		--num;
+		if (i != num) {
+			move(i, num);
+			if ((i != 0) && before(i, parent(i))) {
+				siftUp(i);
+			} else {
+				siftDown(i);
+			}
+		} else if (num == 0) {
+			reset();
+		}
+		return true;
+	}
+
+	// Remove all elements for which the given predicate returns true.
+	template<typename PRED> void remove_all(PRED p)
+	{
+		size_t j = 0;
+		for (size_t i = 0; i != num; ++i) {
+			if (!p(item(i))) {
+				if (i != j) move(j, i);
+				++j;
+			}
+		}
+		num = j;
+		if (num == 0) {
+			reset();
+		} else if (heapMode && (num > 1)) {
+			// restore heap property
+			for (size_t i = parent(num - 1) + 1; i-- != 0; ) {
+				siftDown(i);
+			}
+		}
+	}
+
+private:
+	      T& item(size_t i)       { return items[first + i]; }
+	const T& item(size_t i) const { return items[first + i]; }
+	uint64_t* seq(size_t i) { return seqs.data() + first + i; }
+
+	static size_t parent(size_t i) { return (i - 1) / ARITY; }
+
+	// Should the element at position 'i' come before the one at 'j'?
+	bool before(size_t i, size_t j)
+	{
+		if (less(item(i), item(j))) return true;
+		if (less(item(j), item(i))) return false;
+		return *seq(i) < *seq(j);
+	}
+
+	void move(size_t dst, size_t src)
+	{
+		item(dst) = item(src);
+		*seq(dst) = *seq(src);
+	}
+
+	void reset()
+	{
+		assert(num == 0);
+		first = SPARE_FRONT;
+		heapMode = false;
+	}
+
+	void insertSorted(const T& t)
+	{
+		// find position after all elements that are not bigger
+		size_t pos = 0;
+		while ((pos != num) && !less(t, item(pos))) ++pos;
+
+		if ((pos <= (num - pos)) && (first != 0)) {
+			// shift the first part one position to the front
+			--first;
+			std::copy(begin() + 1, begin() + 1 + pos, begin());
+			std::copy(seq(1), seq(1 + pos), seq(0));
+		} else {
+			makeRoomBack();
+			std::copy_backward(begin() + pos, end(), end() + 1);
+			std::copy_backward(seq(pos), seq(num), seq(num + 1));
+		}
+		item(pos) = t;
+		*seq(pos) = nextSeq++;
+		++num;
+	}
+
+	void insertHeap(const T& t)
+	{
+		makeRoomBack();
+		item(num) = t;
+		*seq(num) = nextSeq++;
+		++num;
+		siftUp(num - 1);
+	}
+
+	// Make sure there's room for (at least) one more element at the back.
+	void makeRoomBack()
+	{
+		if (likely((first + num) != capacity)) return;
+
+		if (first > (capacity / 4)) {
+			// enough spare room at the front, move everything
+			std::copy(begin(), end(), items.data() + SPARE_FRONT);
+			std::copy(seq(0), seq(num), seqs.data() + SPARE_FRONT);
+		} else {
+			size_t newCapacity = 2 * capacity;
+			MemBuffer<T>        newItems(newCapacity);
+			MemBuffer<uint64_t> newSeqs (newCapacity);
+			std::copy(begin(), end(), newItems.data() + SPARE_FRONT);
+			std::copy(seq(0), seq(num), newSeqs.data() + SPARE_FRONT);
+			items = std::move(newItems);
+			seqs  = std::move(newSeqs);
+			capacity = newCapacity;
+		}
+		first = SPARE_FRONT;
+	}
+
+	void siftUp(size_t i)
+	{
+		while (i != 0) {
+			size_t p = parent(i);
+			if (!before(i, p)) break;
+			swap(i, p);
+			i = p;
+		}
+	}
+
+	void siftDown(size_t i)
+	{
+		while (true) {
+			size_t c = ARITY * i + 1;
+			if (c >= num) break;
+			size_t last = std::min(c + ARITY, num);
+			size_t smallest = c;
+			for (++c; c < last; ++c) {
+				if (before(c, smallest)) smallest = c;
+			}
+			if (!before(smallest, i)) break;
+			swap(i, smallest);
+			i = smallest;
+		}
+	}
+
+	void swap(size_t i, size_t j)
+	{
+		std::swap(item(i), item(j));
+		std::swap(*seq(i), *seq(j));
+	}
+
+private:
+	MemBuffer<T> items;
+	MemBuffer<uint64_t> seqs; // sequence numbers, parallel to 'items'
+	size_t capacity;
+	size_t first; // index of the first used element
+	size_t num;   // number of elements
+	uint64_t nextSeq;
+	bool heapMode;
+	LESS less;
+};
+
+} // namespace openmsx
+
+#endif // SCHEDULERHEAPQUEUE_HH
@@ -0,0 +1,90 @@
+#include "SchedulerHeapQueue.hh"
+#include "SchedulerQueue.hh"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace openmsx;
+
+// Compare SchedulerHeapQueue against the (simpler) SchedulerQueue for a
+// random sequence of operations. Both must return the elements in exactly
+// the same order, also for elements with equal time.
+
+struct Elem {
+	uint64_t time;
+	unsigned id;
+};
+
+struct LessElem {
+	bool operator()(const Elem& x, const Elem& y) const {
+		return x.time < y.time;
+	}
+};
+
+// Both queues contain the same elements (possibly in a different order).
+static void checkSameElements(
+	const SchedulerHeapQueue<Elem, LessElem>& heapQueue,
+	const SchedulerQueue<Elem>& sortedQueue)
+{
+	std::vector<unsigned> ids1, ids2;
+	for (auto& e : heapQueue)   ids1.push_back(e.id);
+	for (auto& e : sortedQueue) ids2.push_back(e.id);
+	std::sort(ids1.begin(), ids1.end());
+	std::sort(ids2.begin(), ids2.end());
+	assert(ids1 == ids2);
+}
+
+static void test(std::mt19937& rng, unsigned maxSize)
+{
+	SchedulerHeapQueue<Elem, LessElem> heapQueue;
+	SchedulerQueue<Elem> sortedQueue;
+	uint64_t now = 0;
+	unsigned id = 0;
+
+	for (int step = 0; step < 20000; ++step) {
+		unsigned op = rng() % 10;
+		if ((op < 5) && (sortedQueue.size() < maxSize)) {
+			// small range of times, so that there are many equal ones
+			Elem e = { now + rng() % 50, id++ };
+			heapQueue.insert(e);
+			sortedQueue.insert(e,
+				[](Elem& s) { s.time = uint64_t(-1); },
+				LessElem());
+		} else if (op < 8) {
+			if (sortedQueue.empty()) continue;
+			assert(heapQueue.front().id == sortedQueue.front().id);
+			now = sortedQueue.front().time;
+			heapQueue.remove_front();
+			sortedQueue.remove_front();
+		} else if (op == 8) {
+			unsigned m = rng() % 7;
+			auto pred = [m](const Elem& e) { return (e.id % 7) == m; };
+			heapQueue.remove_all(pred);
+			sortedQueue.remove_all(pred);
+		} else {
+			// Typically several elements match, both queues must
+			// remove the same one (the smallest).
+			unsigned m = rng() % 5;
+			auto pred = [m](const Elem& e) { return (e.id % 5) == m; };
+			bool r1 = heapQueue.remove(pred);
+			bool r2 = sortedQueue.remove(pred);
+			assert(r1 == r2); (void)r1; (void)r2;
+			checkSameElements(heapQueue, sortedQueue);
+		}
+		assert(heapQueue.size() == sortedQueue.size());
+	}
+}
+
+int main()
+{
+	std::mt19937 rng(12345);
+	for (unsigned maxSize : { 4, 16, 30, 100, 500 }) {
+		for (int i = 0; i < 20; ++i) {
+			test(rng, maxSize);
+		}
+	}
+	std::cout << "All tests passed" << std::endl;
+}
@@ -182,10 +182,12 @@
 //
 // #define USE_COMPUTED_GOTO
 //
-// Computed goto's are not enabled by default:
+// Computed goto's are enabled by default (when compiling with gcc or clang),
+// see COMPUTED_GOTO in build/custom.mk. Without them a (portable) switch
+// statement is used for the instruction dispatch:
 // - Computed goto's are a gcc extension, it's not part of the official c++
-//   standard. So this will only work if you use gcc as your compiler (it
-//   won't work with visual c++ for example)
+//   standard. So this will only work if you use gcc (or clang) as your
+//   compiler (it won't work with visual c++ for example)
 // - This is only beneficial on CPUs with branch prediction for indirect jumps
 //   and a reasonable amout of cache. For example it is very benefical for a
 //   intel core2 cpu (10% faster), but not for a ARM920 (a few percent slower)
@@ -193,9 +195,8 @@
 //   on the compiler. On older gcc versions it requires up to 1.5GB of memory.
 //   But even on more recent gcc versions it still requires around 700MB.
 //
-// Probably the easiest way to enable this, is to pass the -DUSE_COMPUTED_GOTO
-// flag to the compiler. This is for example done in the super-opt flavour.
-// See build/flavour-super-opt.mk
+// The build system passes the -DUSE_COMPUTED_GOTO flag to the compiler. Use
+// the 'cpu_benchmark' console command to measure the difference.
 
 
 using std::string;
@@ -347,8 +348,13 @@ template<class T> EmuTime::param CPUCore<T>::getCurrentTime() const
 
 template<class T> void CPUCore<T>::invalidateMemCache(unsigned start, unsigned size)
 {
-	unsigned first = start / CacheLine::SIZE;
-	unsigned num = (size + CacheLine::SIZE - 1) / CacheLine::SIZE;
+	// Devices that didn't opt in for fine grained cache lines answer
+	// getReadCacheLine() for a whole CacheLine::SIZE block at once (see
+	// MSXDevice::setFineCacheLines()), so invalidate complete blocks.
+	static const unsigned FINE_PER_BLOCK = CacheLine::SIZE / FineCacheLine::SIZE;
+	unsigned first = (start / CacheLine::SIZE) * FINE_PER_BLOCK;
+	unsigned last = ((start + size + CacheLine::SIZE - 1) / CacheLine::SIZE) * FINE_PER_BLOCK;
+	unsigned num = last - first;
 	memset(&readCacheLine  [first], 0, num * sizeof(byte*)); // nullptr
 	memset(&writeCacheLine [first], 0, num * sizeof(byte*)); //
 	memset(&readCacheTried [first], 0, num * sizeof(bool));  // FALSE
@@ -593,10 +599,10 @@ template<class T> template<bool PRE_PB, bool POST_PB>
 NEVER_INLINE byte CPUCore<T>::RDMEMslow(unsigned address, unsigned cc)
 {
 	// not cached
-	unsigned high = address >> CacheLine::BITS;
+	unsigned high = address >> FineCacheLine::BITS;
 	if (!readCacheTried[high]) {
 		// try to cache now
-		unsigned addrBase = address & CacheLine::HIGH;
+		unsigned addrBase = address & FineCacheLine::HIGH;
 		if (const byte* line = interface->getReadCacheLine(addrBase)) {
 			// cached ok
 			T::template PRE_MEM<PRE_PB, POST_PB>(address);
@@ -617,7 +623,7 @@ NEVER_INLINE byte CPUCore<T>::RDMEMslow(unsigned address, unsigned cc)
 template<class T> template<bool PRE_PB, bool POST_PB>
 ALWAYS_INLINE byte CPUCore<T>::RDMEM_impl2(unsigned address, unsigned cc)
 {
-	const byte* line = readCacheLine[address >> CacheLine::BITS];
+	const byte* line = readCacheLine[address >> FineCacheLine::BITS];
 	if (likely(line != nullptr)) {
 		// cached, fast path
 		T::template PRE_MEM<PRE_PB, POST_PB>(address);
@@ -655,8 +661,8 @@ NEVER_INLINE unsigned CPUCore<T>::RD_WORD_slow(unsigned address, unsigned cc)
 template<class T> template<bool PRE_PB, bool POST_PB>
 ALWAYS_INLINE unsigned CPUCore<T>::RD_WORD_impl2(unsigned address, unsigned cc)
 {
-	const byte* line = readCacheLine[address >> CacheLine::BITS];
-	if (likely(((address & CacheLine::LOW) != CacheLine::LOW) && line)) {
+	const byte* line = readCacheLine[address >> FineCacheLine::BITS];
+	if (likely(((address & FineCacheLine::LOW) != FineCacheLine::LOW) && line)) {
 		// fast path: cached and two bytes in same cache line
 		T::template PRE_WORD<PRE_PB, POST_PB>(address);
 		T::template POST_WORD<       POST_PB>(address);
@@ -689,10 +695,10 @@ template<class T> template<bool PRE_PB, bool POST_PB>
 NEVER_INLINE void CPUCore<T>::WRMEMslow(unsigned address, byte value, unsigned cc)
 {
 	// not cached
-	unsigned high = address >> CacheLine::BITS;
+	unsigned high = address >> FineCacheLine::BITS;
 	if (!writeCacheTried[high]) {
 		// try to cache now
-		unsigned addrBase = address & CacheLine::HIGH;
+		unsigned addrBase = address & FineCacheLine::HIGH;
 		if (byte* line = interface->getWriteCacheLine(addrBase)) {
 			// cached ok
 			T::template PRE_MEM<PRE_PB, POST_PB>(address);
@@ -714,7 +720,7 @@ template<class T> template<bool PRE_PB, bool POST_PB>
 ALWAYS_INLINE void CPUCore<T>::WRMEM_impl2(
 	unsigned address, byte value, unsigned cc)
 {
-	byte* line = writeCacheLine[address >> CacheLine::BITS];
+	byte* line = writeCacheLine[address >> FineCacheLine::BITS];
 	if (likely(line != nullptr)) {
 		// cached, fast path
 		T::template PRE_MEM<PRE_PB, POST_PB>(address);
@@ -747,8 +753,8 @@ template<class T> NEVER_INLINE void CPUCore<T>::WR_WORD_slow(
 template<class T> ALWAYS_INLINE void CPUCore<T>::WR_WORD(
 	unsigned address, unsigned value, unsigned cc)
 {
-	byte* line = writeCacheLine[address >> CacheLine::BITS];
-	if (likely(((address & CacheLine::LOW) != CacheLine::LOW) && line)) {
+	byte* line = writeCacheLine[address >> FineCacheLine::BITS];
+	if (likely(((address & FineCacheLine::LOW) != FineCacheLine::LOW) && line)) {
 		// fast path: cached and two bytes in same cache line
 		T::template PRE_WORD<true, true>(address);
 		T::template POST_WORD<     true>(address);
@@ -771,8 +777,8 @@ template<class T> template<bool PRE_PB, bool POST_PB>
 ALWAYS_INLINE void CPUCore<T>::WR_WORD_rev2(
 	unsigned address, unsigned value, unsigned cc)
 {
-	byte* line = writeCacheLine[address >> CacheLine::BITS];
-	if (likely(((address & CacheLine::LOW) != CacheLine::LOW) && line)) {
+	byte* line = writeCacheLine[address >> FineCacheLine::BITS];
+	if (likely(((address & FineCacheLine::LOW) != FineCacheLine::LOW) && line)) {
 		// fast path: cached and two bytes in same cache line
 		T::template PRE_WORD<PRE_PB, POST_PB>(address);
 		T::template POST_WORD<       POST_PB>(address);
@@ -896,7 +902,7 @@ void CPUCore<T>::executeInstructions()
 	if (likely(!T::limitReached())) { \
 		incR(1); \
 		unsigned address = getPC(); \
-		const byte* line = readCacheLine[address >> CacheLine::BITS]; \
+		const byte* line = readCacheLine[address >> FineCacheLine::BITS]; \
 		if (likely(line != nullptr)) { \
 			setPC(address + 1); \
 			T::template PRE_MEM<false, false>(address); \
@@ -110,10 +110,10 @@ private:
 	void update(const Setting& setting);
 
 	// memory cache
-	const byte* readCacheLine[CacheLine::NUM];
-	byte* writeCacheLine[CacheLine::NUM];
-	bool readCacheTried [CacheLine::NUM];
-	bool writeCacheTried[CacheLine::NUM];
+	const byte* readCacheLine[FineCacheLine::NUM];
+	byte* writeCacheLine[FineCacheLine::NUM];
+	bool readCacheTried [FineCacheLine::NUM];
+	bool writeCacheTried[FineCacheLine::NUM];
 
 	MSXMotherBoard& motherboard;
 	Scheduler& scheduler;
@@ -2,6 +2,11 @@
 #define CACHELINE_HH
 
 namespace openmsx {
+
+// Granularity with which the cacheability of memory is queried from devices,
+// see MSXDevice::getReadCacheLine() and getWriteCacheLine(). Devices can opt
+// in for the (possibly smaller) FineCacheLine granularity, see
+// MSXDevice::setFineCacheLines().
 namespace CacheLine {
 
 static const unsigned BITS = 8; // 256 bytes
@@ -11,6 +16,29 @@ static const unsigned LOW  = SIZE - 1;
 static const unsigned HIGH = 0xFFFF - LOW;
 
 } // namespace CacheLine
+
+// Granularity of the memory cache in the CPU (and of the related tables in
+// MSXCPUInterface). Smaller cache lines allow to cache more of the address
+// space of a device that opted in for it (for example the plain memory
+// around a memory mapped register), at the expense of more cache line
+// lookups. Set with CPU_CACHELINE_SIZE in build/custom.mk, the build passes
+// it on as FINE_CACHELINE_BITS. It can't be bigger than CacheLine::SIZE.
+#ifndef FINE_CACHELINE_BITS
+#define FINE_CACHELINE_BITS 8
+#endif
+namespace FineCacheLine {
+
+static const unsigned BITS = FINE_CACHELINE_BITS;
+static const unsigned SIZE = 1 << BITS;
+static const unsigned NUM  = 0x10000 / SIZE;
+static const unsigned LOW  = SIZE - 1;
+static const unsigned HIGH = 0xFFFF - LOW;
+
+static_assert((6 <= BITS) && (BITS <= CacheLine::BITS),
+              "FINE_CACHELINE_BITS must be in range [6..8]");
+
+} // namespace FineCacheLine
+
 } // namespace openmsx
 
 #endif
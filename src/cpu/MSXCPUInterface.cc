@@ -175,10 +175,10 @@ void MSXCPUInterface::removeAllWatchPoints()
 byte MSXCPUInterface::readMemSlow(word address, EmuTime::param time)
 {
 	// something special in this region?
-	if (unlikely(disallowReadCache[address >> CacheLine::BITS])) {
+	if (unlikely(disallowReadCache[address >> FineCacheLine::BITS])) {
 		// execute read watches before actual read
-		if (readWatchSet[address >> CacheLine::BITS]
-		                [address &  CacheLine::LOW]) {
+		if (readWatchSet[address >> FineCacheLine::BITS]
+		                [address &  FineCacheLine::LOW]) {
 			executeMemWatch(WatchPoint::READ_MEM, address);
 		}
 	}
@@ -200,7 +200,7 @@ void MSXCPUInterface::writeMemSlow(word address, byte value, EmuTime::param time
 		visibleDevices[address>>14]->writeMem(address, value, time);
 	}
 	// something special in this region?
-	if (unlikely(disallowWriteCache[address >> CacheLine::BITS])) {
+	if (unlikely(disallowWriteCache[address >> FineCacheLine::BITS])) {
 		// slot-select-ignore writes (Super Lode Runner)
 		for (auto& g : globalWrites) {
 			// very primitive address selection mechanism,
@@ -210,8 +210,8 @@ void MSXCPUInterface::writeMemSlow(word address, byte value, EmuTime::param time
 			}
 		}
 		// execute write watches after actual write
-		if (writeWatchSet[address >> CacheLine::BITS]
-		                 [address &  CacheLine::LOW]) {
+		if (writeWatchSet[address >> FineCacheLine::BITS]
+		                 [address &  FineCacheLine::LOW]) {
 			executeMemWatch(WatchPoint::WRITE_MEM, address, value);
 		}
 	}
@@ -285,14 +285,15 @@ void MSXCPUInterface::unsetExpanded(int ps)
 
 void MSXCPUInterface::changeExpanded(bool newExpanded)
 {
+	static const unsigned line = 0xFFFF >> FineCacheLine::BITS;
 	if (newExpanded) {
-		disallowReadCache [0xFF] |=  SECUNDARY_SLOT_BIT;
-		disallowWriteCache[0xFF] |=  SECUNDARY_SLOT_BIT;
+		disallowReadCache [line] |=  SECUNDARY_SLOT_BIT;
+		disallowWriteCache[line] |=  SECUNDARY_SLOT_BIT;
 	} else {
-		disallowReadCache [0xFF] &= ~SECUNDARY_SLOT_BIT;
-		disallowWriteCache[0xFF] &= ~SECUNDARY_SLOT_BIT;
+		disallowReadCache [line] &= ~SECUNDARY_SLOT_BIT;
+		disallowWriteCache[line] &= ~SECUNDARY_SLOT_BIT;
 	}
-	msxcpu.invalidateMemCache(0xFFFF & CacheLine::HIGH, 0x100);
+	msxcpu.invalidateMemCache(0xFFFF & FineCacheLine::HIGH, FineCacheLine::SIZE);
 }
 
 MSXDevice*& MSXCPUInterface::getDevicePtr(byte port, bool isIn)
@@ -529,8 +530,8 @@ void MSXCPUInterface::registerGlobalWrite(MSXDevice& device, word address)
 {
 	globalWrites.push_back({&device, address});
 
-	disallowWriteCache[address >> CacheLine::BITS] |= GLOBAL_WRITE_BIT;
-	msxcpu.invalidateMemCache(address & CacheLine::HIGH, 0x100);
+	disallowWriteCache[address >> FineCacheLine::BITS] |= GLOBAL_WRITE_BIT;
+	msxcpu.invalidateMemCache(address & FineCacheLine::HIGH, FineCacheLine::SIZE);
 }
 
 void MSXCPUInterface::unregisterGlobalWrite(MSXDevice& device, word address)
@@ -539,14 +540,14 @@ void MSXCPUInterface::unregisterGlobalWrite(MSXDevice& device, word address)
 	move_pop_back(globalWrites, rfind_unguarded(globalWrites, info));
 
 	for (auto& g : globalWrites) {
-		if ((g.addr >> CacheLine::BITS) ==
-		    (address  >> CacheLine::BITS)) {
+		if ((g.addr >> FineCacheLine::BITS) ==
+		    (address  >> FineCacheLine::BITS)) {
 			// there is still a global write in this region
 			return;
 		}
 	}
-	disallowWriteCache[address >> CacheLine::BITS] &= ~GLOBAL_WRITE_BIT;
-	msxcpu.invalidateMemCache(address & CacheLine::HIGH, 0x100);
+	disallowWriteCache[address >> FineCacheLine::BITS] &= ~GLOBAL_WRITE_BIT;
+	msxcpu.invalidateMemCache(address & FineCacheLine::HIGH, FineCacheLine::SIZE);
 }
 
 ALWAYS_INLINE void MSXCPUInterface::updateVisible(int page, int ps, int ss)
@@ -829,9 +830,9 @@ void MSXCPUInterface::unregisterIOWatch(WatchPoint& watchPoint, MSXDevice** devi
 
 void MSXCPUInterface::updateMemWatch(WatchPoint::Type type)
 {
-	std::bitset<CacheLine::SIZE>* watchSet =
+	std::bitset<FineCacheLine::SIZE>* watchSet =
 		(type == WatchPoint::READ_MEM) ? readWatchSet : writeWatchSet;
-	for (unsigned i = 0; i < CacheLine::NUM; ++i) {
+	for (unsigned i = 0; i < FineCacheLine::NUM; ++i) {
 		watchSet[i].reset();
 	}
 	for (auto& w : watchPoints) {
@@ -841,12 +842,12 @@ void MSXCPUInterface::updateMemWatch(WatchPoint::Type type)
 			assert(beginAddr <= endAddr);
 			assert(endAddr < 0x10000);
 			for (unsigned addr = beginAddr; addr <= endAddr; ++addr) {
-				watchSet[addr >> CacheLine::BITS].set(
-				         addr  & CacheLine::LOW);
+				watchSet[addr >> FineCacheLine::BITS].set(
+				         addr  & FineCacheLine::LOW);
 			}
 		}
 	}
-	for (unsigned i = 0; i < CacheLine::NUM; ++i) {
+	for (unsigned i = 0; i < FineCacheLine::NUM; ++i) {
 		if (readWatchSet [i].any()) {
 			disallowReadCache [i] |=  MEMORY_WATCH_BIT;
 		} else {
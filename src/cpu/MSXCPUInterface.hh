@@ -106,7 +106,7 @@ public:
 	 * This reads a byte from the currently selected device
 	 */
 	inline byte readMem(word address, EmuTime::param time) {
-		if (unlikely(disallowReadCache[address >> CacheLine::BITS])) {
+		if (unlikely(disallowReadCache[address >> FineCacheLine::BITS])) {
 			return readMemSlow(address, time);
 		}
 		return visibleDevices[address >> 14]->readMem(address, time);
@@ -116,7 +116,7 @@ public:
 	 * This writes a byte to the currently selected device
 	 */
 	inline void writeMem(word address, byte value, EmuTime::param time) {
-		if (unlikely(disallowWriteCache[address >> CacheLine::BITS])) {
+		if (unlikely(disallowWriteCache[address >> FineCacheLine::BITS])) {
 			writeMemSlow(address, value, time);
 			return;
 		}
@@ -141,7 +141,7 @@ public:
 
 	/**
 	 * Test that the memory in the interval [start, start +
-	 * CacheLine::SIZE) is cacheable for reading. If it is, a pointer to a
+	 * FineCacheLine::SIZE) is cacheable for reading. If it is, a pointer to a
 	 * buffer containing this interval must be returned. If not, a null
 	 * pointer must be returned.
 	 * Cacheable for reading means the data may be read directly
@@ -152,15 +152,15 @@ public:
 	 * An interval will never contain the address 0xffff.
 	 */
 	inline const byte* getReadCacheLine(word start) const {
-		if (unlikely(disallowReadCache[start >> CacheLine::BITS])) {
+		if (unlikely(disallowReadCache[start >> FineCacheLine::BITS])) {
 			return nullptr;
 		}
-		return visibleDevices[start >> 14]->getReadCacheLine(start);
+		return visibleDevices[start >> 14]->lookupReadCacheLine(start);
 	}
 
 	/**
 	 * Test that the memory in the interval [start, start +
-	 * CacheLine::SIZE) is cacheable for writing. If it is, a pointer to a
+	 * FineCacheLine::SIZE) is cacheable for writing. If it is, a pointer to a
 	 * buffer containing this interval must be returned. If not, a null
 	 * pointer must be returned.
 	 * Cacheable for writing means the data may be written directly
@@ -171,10 +171,10 @@ public:
 	 * An interval will never contain the address 0xffff.
 	 */
 	inline byte* getWriteCacheLine(word start) const {
-		if (unlikely(disallowWriteCache[start >> CacheLine::BITS])) {
+		if (unlikely(disallowWriteCache[start >> FineCacheLine::BITS])) {
 			return nullptr;
 		}
-		return visibleDevices[start >> 14]->getWriteCacheLine(start);
+		return visibleDevices[start >> 14]->lookupWriteCacheLine(start);
 	}
 
 	/**
@@ -368,10 +368,10 @@ private:
 
 	std::unique_ptr<VDPIODelay> delayDevice; // can be nullptr
 
-	byte disallowReadCache [CacheLine::NUM];
-	byte disallowWriteCache[CacheLine::NUM];
-	std::bitset<CacheLine::SIZE> readWatchSet [CacheLine::NUM];
-	std::bitset<CacheLine::SIZE> writeWatchSet[CacheLine::NUM];
+	byte disallowReadCache [FineCacheLine::NUM];
+	byte disallowWriteCache[FineCacheLine::NUM];
+	std::bitset<FineCacheLine::SIZE> readWatchSet [FineCacheLine::NUM];
+	std::bitset<FineCacheLine::SIZE> writeWatchSet[FineCacheLine::NUM];
 
 	struct GlobalWriteInfo {
 		MSXDevice* device;
@@ -30,6 +30,9 @@ MSXMultiMemDevice::MSXMultiMemDevice(const HardwareConfig& hwConf)
 {
 	// add sentinel at the end
 	ranges.emplace_back(0x0000, 0x10000, getCPUInterface().getDummyDevice());
+
+	// the sub-devices are queried with their own granularity
+	setFineCacheLines();
 }
 
 MSXMultiMemDevice::~MSXMultiMemDevice()
@@ -125,29 +128,40 @@ void MSXMultiMemDevice::writeMem(word address, byte value, EmuTime::param time)
 	searchDevice(address)->writeMem(address, value, time);
 }
 
+// Is the block (of the size the device gets queried with) that contains
+// 'start' completely inside the range [base, base + size)?
+static bool blockInside(word start, unsigned base, unsigned size,
+                        const MSXDevice& device)
+{
+	unsigned high = device.hasFineCacheLines() ? FineCacheLine::HIGH
+	                                           : CacheLine::HIGH;
+	unsigned first = start & high;
+	unsigned last  = first + (0xFFFF - high);
+	return isInside(first, base, size) && isInside(last, base, size);
+}
+
 const byte* MSXMultiMemDevice::getReadCacheLine(word start) const
 {
-	assert((start & CacheLine::HIGH) == start); // start is aligned
-	// Because start is aligned we don't need to wory about the begin
-	// address of the range. But we must make sure the end of the range
-	// doesn't only fill a partial cacheline.
+	assert((start & FineCacheLine::HIGH) == start); // start is aligned
+	// Because start is aligned and this device is queried per
+	// FineCacheLine, a range can end (or begin) in the middle of the
+	// block the sub-device gets queried with. Such a partial block can't
+	// be cached.
 	const auto& range = searchRange(start);
-	if (unlikely(((range.base + range.size) & CacheLine::HIGH) == start)) {
-		// The end of this memory device only fills a partial
-		// cacheline. This can't be cached.
+	if (unlikely(!blockInside(start, range.base, range.size, *range.device))) {
 		return nullptr;
 	}
-	return searchDevice(start)->getReadCacheLine(start);
+	return range.device->lookupReadCacheLine(start);
 }
 
 byte* MSXMultiMemDevice::getWriteCacheLine(word start) const
 {
-	assert((start & CacheLine::HIGH) == start);
+	assert((start & FineCacheLine::HIGH) == start);
 	const auto& range = searchRange(start);
-	if (unlikely(((range.base + range.size) & CacheLine::HIGH) == start)) {
+	if (unlikely(!blockInside(start, range.base, range.size, *range.device))) {
 		return nullptr;
 	}
-	return searchDevice(start)->getWriteCacheLine(start);
+	return range.device->lookupWriteCacheLine(start);
 }
 
 } // namespace openmsx
@@ -184,6 +184,9 @@ MegaFlashRomSCCPlus::MegaFlashRomSCCPlus(
 	      getCurrentTime())
 	, flash(rom, getSectorInfo(), 0x205B, false, config)
 {
+	// with small cache lines, only the region around the subslot register
+	// (0xFFFF) is uncached instead of the complete 0xFF00-0xFFFF block
+	setFineCacheLines();
 	powerUp(getCurrentTime());
 
 	getCPUInterface().register_IO_Out(0x10, this);
@@ -323,7 +326,7 @@ byte MegaFlashRomSCCPlus::readMem(word addr, EmuTime::param time)
 const byte* MegaFlashRomSCCPlus::getReadCacheLine(word addr) const
 {
 	if ((configReg & 0x10) &&
-	    ((addr & CacheLine::HIGH) == (0xFFFF & CacheLine::HIGH))) {
+	    ((addr & FineCacheLine::HIGH) == (0xFFFF & FineCacheLine::HIGH))) {
 		// read subslot register
 		return nullptr;
 	}
@@ -35,6 +35,7 @@ RomKonamiSCC::RomKonamiSCC(const DeviceConfig& config, Rom&& rom_)
 			"chips!");
 		alreadyWarnedForSha1Sum = rom.getOriginalSHA1();
 	}
+	setFineCacheLines();
 	powerUp(getCurrentTime());
 }
 
@@ -114,10 +115,10 @@ byte* RomKonamiSCC::getWriteCacheLine(word address) const
 	} else if (sccEnabled && (0x9800 <= address) && (address < 0xA000)) {
 		// write to SCC
 		return nullptr;
-	} else if ((address & 0xF800) == (0x9000 & CacheLine::HIGH)) {
+	} else if ((address & 0xF800) == (0x9000 & FineCacheLine::HIGH)) {
 		// SCC enable/disable
 		return nullptr;
-	} else if ((address & 0x1800) == (0x1000 & CacheLine::HIGH)) {
+	} else if ((address & 0x1800) == (0x1000 & FineCacheLine::HIGH)) {
 		// page selection
 		return nullptr;
 	} else {
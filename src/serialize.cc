@@ -5,10 +5,12 @@
 #include "XMLElement.hh"
 #include "ConfigException.hh"
 #include "XMLException.hh"
-#include "snappy.hh"
+#include "DeltaBlock.hh"
 #include "MemBuffer.hh"
+#include "memory.hh"
 #include "StringOp.hh"
 #include "FileOperations.hh"
+#include "File.hh"
 #include "Version.hh"
 #include "Date.hh"
 #include "cstdiop.hh" // for dup()
@@ -27,6 +29,7 @@ void ArchiveBase<Derived>::attribute(const char* name, const char* value)
 }
 template class ArchiveBase<MemOutputArchive>;
 template class ArchiveBase<XmlOutputArchive>;
+template class ArchiveBase<BinOutputArchive>;
 
 ////
 
@@ -110,6 +113,7 @@ void OutputArchiveBase<Derived>::serialize_blob(
 
 template class OutputArchiveBase<MemOutputArchive>;
 template class OutputArchiveBase<XmlOutputArchive>;
+template class OutputArchiveBase<BinOutputArchive>;
 
 ////
 
@@ -169,6 +173,7 @@ void InputArchiveBase<Derived>::serialize_blob(
 
 template class InputArchiveBase<MemInputArchive>;
 template class InputArchiveBase<XmlInputArchive>;
+template class InputArchiveBase<BinInputArchive>;
 
 ////
 
@@ -208,34 +213,28 @@ string_ref MemInputArchive::loadStr()
 
 ////
 
-// Too small inputs don't compress very well (often the compressed size is even
-// bigger than the input). It also takes a relatively long time (because snappy
-// has a relatively large setup time). I choose this value semi-arbitrary. I
-// only made it >= 52 so that the (incompressible) RP5C01 registers won't be
-// compressed.
+// Too small inputs don't benefit from being stored in a separate DeltaBlock
+// (the bookkeeping overhead is bigger than the potential gain). I choose this
+// value semi-arbitrary. I only made it >= 52 so that the (always changing)
+// RP5C01 registers are stored directly in the stream.
 static const size_t SMALL_SIZE = 100;
 void MemOutputArchive::serialize_blob(const char*, const void* data, size_t len)
 {
-	// Compress in-memory blobs:
+	// Store large blobs as DeltaBlocks:
 	//
-	// This is a bit slower than memcpy, but it uses a lot less memory.
-	// Memory usage is important for the reverse feature, where we keep a
-	// lot of savestates in memory.
+	// Most of the time only a small part of the large memory blocks (RAM,
+	// VRAM, ...) changes between two snapshots. DeltaBlocks only store
+	// those changes (relative to a full copy in an earlier snapshot) and
+	// are shared between snapshots when nothing changed at all. The
+	// stream itself only stores the index of the DeltaBlock.
 	//
-	// I compared 'gzip level=1' (fastest version with lowest compression
-	// ratio) with 'lzo'. lzo was considerably faster. Compression ratio
-	// was about the same (maybe lzo was slightly better (OTOH on higher
-	// levels gzip compresses better)). So I decided to go with lzo.
-	//
-	// Later I compared 'lzo' with 'snappy', lzo compresses 6-25% better,
-	// but 'snappy' is about twice as fast. So I switched to 'snappy'.
+	// Full copies are compressed (with snappy) once they're no longer
+	// the most recent copy of that block. See ReverseManager.
 	if (len >= SMALL_SIZE) {
-		size_t dstLen = snappy::maxCompressedLength(len);
-		byte* buf = buffer.allocate(sizeof(dstLen) + dstLen);
-		snappy::compress(static_cast<const char*>(data), len,
-		                 reinterpret_cast<char*>(&buf[sizeof(dstLen)]), dstLen);
-		memcpy(buf, &dstLen, sizeof(dstLen)); // fill-in actual size
-		buffer.deallocate(&buf[sizeof(dstLen) + dstLen]); // dealloc unused portion
+		size_t deltaBlockIdx = deltaBlocks.size();
+		save(deltaBlockIdx);
+		deltaBlocks.push_back(lastDeltaBlocks.createNew(
+			data, static_cast<const uint8_t*>(data), len));
 	} else {
 		byte* buf = buffer.allocate(len);
 		memcpy(buf, data, len);
@@ -246,10 +245,9 @@ void MemOutputArchive::serialize_blob(const char*, const void* data, size_t len)
 void MemInputArchive::serialize_blob(const char*, void* data, size_t len)
 {
 	if (len >= SMALL_SIZE) {
-		size_t srcLen; load(srcLen);
-		snappy::uncompress(reinterpret_cast<const char*>(buffer.getCurrentPos()),
-		                   srcLen, reinterpret_cast<char*>(data), len);
-		buffer.skip(srcLen);
+		size_t deltaBlockIdx; load(deltaBlockIdx);
+		assert(deltaBlockIdx < deltaBlocks.size());
+		deltaBlocks[deltaBlockIdx]->apply(static_cast<uint8_t*>(data), len);
 	} else {
 		memcpy(data, buffer.getCurrentPos(), len);
 		buffer.skip(len);
@@ -546,4 +544,266 @@ int XmlInputArchive::countChildren() const
 	return int(elems.back().first->getChildren().size());
 }
 
+////
+
+// File layout of a binary archive:
+//   BIN_MAGIC              8 bytes
+//   format version         varint
+//   openMSX version        string   (same info as in the XML root tag)
+//   date/time              string
+//   platform               string
+//   serialized data
+// A varint is an unsigned integer stored in little endian groups of 7 bits,
+// the highest bit in each byte indicates whether more bytes follow. Signed
+// integers are first zigzag encoded. Strings and blobs are stored as a
+// varint length followed by the data; blobs additionally store an encoding
+// byte. Large blobs (e.g. RAM, VRAM, sample RAM) are stored uncompressed and
+// start at a multiple of BIN_PAGE_SIZE bytes in the file (the padding in
+// front is not stored explicitly), so that they can be used directly from
+// the memory mapped file. The format version must be incremented when this
+// layout changes
+// (changes in the serialized classes themselves are handled via the
+// regular per-class version mechanism).
+static const char BIN_MAGIC[8] = { 'o','M','S','X','b','i','n','\x1a' };
+static const unsigned BIN_FORMAT_VERSION = 2;
+
+// blob encodings
+static const byte BLOB_RAW     = 0;
+static const byte BLOB_ZLIB    = 1;
+static const byte BLOB_ALIGNED = 2; // raw, page aligned (format version 2)
+
+// Don't bother compressing small blobs.
+static const size_t BIN_COMPRESS_MIN_SIZE = 256;
+// Blobs of at least this size are stored page aligned (and uncompressed).
+static const size_t BIN_ALIGN_MIN_SIZE = 4096;
+static const size_t BIN_PAGE_SIZE = 4096;
+
+static size_t alignPadding(size_t offset)
+{
+	return (BIN_PAGE_SIZE - (offset % BIN_PAGE_SIZE)) % BIN_PAGE_SIZE;
+}
+
+BinOutputArchive::BinOutputArchive(const string& filename_)
+	: filename(filename_)
+{
+	memcpy(buffer.allocate(sizeof(BIN_MAGIC)), BIN_MAGIC, sizeof(BIN_MAGIC));
+	save(BIN_FORMAT_VERSION);
+	save(Version::full());
+	save(Date::toString(time(nullptr)));
+	save(string(TARGET_PLATFORM));
+}
+
+void BinOutputArchive::close()
+{
+	assert(openSections.empty());
+	size_t size;
+	MemBuffer<byte> data = buffer.release(size);
+	File file(filename, File::TRUNCATE);
+	file.write(data.data(), size);
+}
+
+void BinOutputArchive::saveVarint(uint64_t value)
+{
+	byte tmp[10];
+	size_t len = 0;
+	while (value >= 0x80) {
+		tmp[len++] = byte(value | 0x80);
+		value >>= 7;
+	}
+	tmp[len++] = byte(value);
+	buffer.insert(tmp, len);
+}
+
+void BinOutputArchive::saveFixed(uint64_t value, size_t len)
+{
+	byte tmp[8];
+	for (size_t i = 0; i < len; ++i) {
+		tmp[i] = byte(value >> (8 * i));
+	}
+	buffer.insert(tmp, len);
+}
+
+void BinOutputArchive::save(const string& str)
+{
+	saveVarint(str.size());
+	buffer.insert(str.data(), str.size());
+}
+
+void BinOutputArchive::serialize_blob(const char*, const void* data, size_t len)
+{
+	saveVarint(len);
+	if (len >= BIN_ALIGN_MIN_SIZE) {
+		// Positions in the buffer are also positions in the file.
+		putByte(BLOB_ALIGNED);
+		size_t padding = alignPadding(buffer.getPosition());
+		memset(buffer.allocate(padding), 0, padding);
+		buffer.insert(data, len);
+		return;
+	}
+	if (len >= BIN_COMPRESS_MIN_SIZE) {
+		// Fast compression level: for typical savestates the size
+		// difference with level 9 is small, the speed difference isn't.
+		auto dstLen = compressBound(uLong(len));
+		MemBuffer<byte> buf(dstLen);
+		if (compress2(buf.data(), &dstLen,
+		              static_cast<const Bytef*>(data), uLong(len),
+		              Z_BEST_SPEED) != Z_OK) {
+			throw MSXException("Error while compressing blob.");
+		}
+		if (dstLen < len) {
+			putByte(BLOB_ZLIB);
+			saveVarint(dstLen);
+			buffer.insert(buf.data(), dstLen);
+			return;
+		}
+	}
+	putByte(BLOB_RAW);
+	buffer.insert(data, len);
+}
+
+void BinOutputArchive::beginSection()
+{
+	// The size of the section is only known at the end. Use a fixed
+	// size encoding so that it can be filled in without moving the data.
+	saveFixed(0, 8);
+	openSections.push_back(buffer.getPosition());
+}
+
+void BinOutputArchive::endSection()
+{
+	assert(!openSections.empty());
+	size_t beginPos = openSections.back();
+	openSections.pop_back();
+	uint64_t skip = buffer.getPosition() - beginPos;
+	byte tmp[8];
+	for (int i = 0; i < 8; ++i) {
+		tmp[i] = byte(skip >> (8 * i));
+	}
+	buffer.insertAt(beginPos - sizeof(tmp), tmp, sizeof(tmp));
+}
+
+////
+
+BinInputArchive::BinInputArchive(const string& filename)
+	: file(make_unique<File>(filename))
+{
+	size_t size;
+	begin  = file->mmap(size);
+	pos    = begin;
+	finish = begin + size;
+
+	if ((size < sizeof(BIN_MAGIC)) ||
+	    (memcmp(get(sizeof(BIN_MAGIC)), BIN_MAGIC, sizeof(BIN_MAGIC)) != 0)) {
+		throw MSXException("Not a binary savestate file: " + filename);
+	}
+	unsigned formatVersion;
+	load(formatVersion);
+	if (formatVersion > BIN_FORMAT_VERSION) {
+		throw MSXException(StringOp::Builder() <<
+			"Binary savestate format version " << formatVersion <<
+			" is not supported, your openMSX installation is too old.");
+	}
+	loadStr(); // openMSX version
+	loadStr(); // date/time
+	loadStr(); // platform
+}
+
+BinInputArchive::~BinInputArchive()
+{
+}
+
+bool BinInputArchive::isBinArchive(const string& filename)
+{
+	try {
+		File file(filename);
+		char magic[sizeof(BIN_MAGIC)];
+		if (file.getSize() < sizeof(magic)) return false;
+		file.read(magic, sizeof(magic));
+		return memcmp(magic, BIN_MAGIC, sizeof(magic)) == 0;
+	} catch (MSXException&) {
+		return false;
+	}
+}
+
+const byte* BinInputArchive::get(size_t len)
+{
+	if (unlikely(len > size_t(finish - pos))) {
+		throw MSXException("Corrupt savestate: unexpected end of file.");
+	}
+	const byte* result = pos;
+	pos += len;
+	return result;
+}
+
+uint64_t BinInputArchive::loadVarint()
+{
+	uint64_t result = 0;
+	for (unsigned shift = 0; shift < 64; shift += 7) {
+		byte b = getByte();
+		result |= uint64_t(b & 0x7F) << shift;
+		if (!(b & 0x80)) return result;
+	}
+	throw MSXException("Corrupt savestate: invalid integer.");
+}
+
+uint64_t BinInputArchive::loadFixed(size_t len)
+{
+	const byte* p = get(len);
+	uint64_t result = 0;
+	for (size_t i = 0; i < len; ++i) {
+		result |= uint64_t(p[i]) << (8 * i);
+	}
+	return result;
+}
+
+void BinInputArchive::load(string& s)
+{
+	s = loadStr().str();
+}
+
+string_ref BinInputArchive::loadStr()
+{
+	size_t len = loadVarint();
+	return string_ref(reinterpret_cast<const char*>(get(len)), len);
+}
+
+void BinInputArchive::serialize_blob(const char*, void* data, size_t len)
+{
+	if (loadVarint() != len) {
+		throw MSXException(StringOp::Builder() <<
+			"Length of blob different from expected value (" <<
+			len << ')');
+	}
+	switch (getByte()) {
+	case BLOB_RAW:
+		memcpy(data, get(len), len);
+		break;
+	case BLOB_ALIGNED:
+		get(alignPadding(pos - begin));
+		memcpy(data, get(len), len);
+		break;
+	case BLOB_ZLIB: {
+		size_t srcLen = loadVarint();
+		const byte* src = get(srcLen);
+		auto dstLen = uLongf(len);
+		if ((uncompress(static_cast<Bytef*>(data), &dstLen,
+		                src, uLong(srcLen)) != Z_OK) ||
+		    (dstLen != len)) {
+			throw MSXException("Error while decompressing blob.");
+		}
+		break;
+	}
+	default:
+		throw MSXException("Unsupported encoding for blob.");
+	}
+}
+
+void BinInputArchive::skipSection(bool skip)
+{
+	size_t num = loadFixed(8);
+	if (skip) {
+		get(num);
+	}
+}
+
 } // namespace openmsx
@@ -21,6 +21,9 @@
 namespace openmsx {
 
 template<typename T> struct SerializeClassVersion;
+class DeltaBlock;
+class LastDeltaBlocks;
+class File;
 
 // In this section, the archive classes are defined.
 //
@@ -36,7 +39,9 @@ template<typename T> struct SerializeClassVersion;
 //      in a newer version of openMSX). It is also not platform independent
 //      (e.g. integers are stored using native platform endianess).
 //      The main use case for this archive format is regular in memory
-//      snapshots, for example to support replay/rewind.
+//      snapshots, for example to support replay/rewind. Large blobs are not
+//      stored in the stream itself but in separate DeltaBlocks, this allows
+//      to only store the changes relative to an earlier snapshot.
 //   - XML
 //      Stores the stream in a XML file. These files are meant to be portable
 //      to different architectures (e.g. little/big endian, 32/64 bit system).
@@ -46,6 +51,10 @@ template<typename T> struct SerializeClassVersion;
 //      is not a design goal (e.g. simply changing a value will probably work,
 //      but swapping the position of two tag or adding or removing tags can
 //      easily break the stream).
+//   - Bin
+//      Stores the stream in a compact binary file. Like XML it is portable
+//      and versioned, but it is not human readable. It's much faster to
+//      create and to load than XML, and the files are smaller.
 //   - Text
 //      This stores to stream in a flat ascii file (one item per line). This
 //      format is only written as a proof-of-concept to test the design. It's
@@ -587,7 +596,10 @@ protected:
 class MemOutputArchive final : public OutputArchiveBase<MemOutputArchive>
 {
 public:
-	MemOutputArchive()
+	MemOutputArchive(LastDeltaBlocks& lastDeltaBlocks_,
+	                 std::vector<std::shared_ptr<DeltaBlock>>& deltaBlocks_)
+		: lastDeltaBlocks(lastDeltaBlocks_)
+		, deltaBlocks(deltaBlocks_)
 	{
 	}
 
@@ -639,13 +651,17 @@ private:
 
 	OutputBuffer buffer;
 	std::vector<size_t> openSections;
+	LastDeltaBlocks& lastDeltaBlocks;
+	std::vector<std::shared_ptr<DeltaBlock>>& deltaBlocks;
 };
 
 class MemInputArchive final : public InputArchiveBase<MemInputArchive>
 {
 public:
-	MemInputArchive(const byte* data, size_t size)
+	MemInputArchive(const byte* data, size_t size,
+	                const std::vector<std::shared_ptr<DeltaBlock>>& deltaBlocks_)
 		: buffer(data, size)
+		, deltaBlocks(deltaBlocks_)
 	{
 	}
 
@@ -689,6 +705,7 @@ private:
 	}
 
 	InputBuffer buffer;
+	const std::vector<std::shared_ptr<DeltaBlock>>& deltaBlocks;
 };
 
 ////
@@ -814,11 +831,164 @@ private:
 	std::vector<std::pair<const XMLElement*, size_t>> elems;
 };
 
+////
+
+// Compact binary (on-disk) archive.
+//
+// Like the XML archives (and unlike the memory archives) this stores version
+// information, so files can still be loaded by later openMSX versions. And
+// the format doesn't depend on the endianness or the word size of the host:
+// integers are stored in a variable-length encoding, floating point values
+// in little endian IEEE format and enums as strings. Large blobs are
+// (individually) compressed, the rest of the stream is stored uncompressed.
+// Sections (see beginSection()) can really be skipped during loading.
+//
+// The file starts with a magic string, so it can be distinguished from an
+// XML archive, see BinInputArchive::isBinArchive().
+
+// Unsigned integer type with the same size as the given floating point type.
+template<typename T> struct FloatBits;
+template<> struct FloatBits<float>  { using type = uint32_t; };
+template<> struct FloatBits<double> { using type = uint64_t; };
+
+class BinOutputArchive final : public OutputArchiveBase<BinOutputArchive>
+{
+public:
+	explicit BinOutputArchive(const std::string& filename);
+
+	/** Write the archive to disk.
+	 * Must be called once, after all data has been serialized.
+	 * @throws FileException
+	 */
+	void close();
+
+	template<typename T> void save(const T& t)
+	{
+		saveImpl(t, std::is_floating_point<T>());
+	}
+	inline void saveChar(char c) { putByte(c); }
+	void save(const std::string& str);
+	void save(bool b)          { putByte(b); }
+	void save(unsigned char b) { putByte(b); }
+	void save(signed char c)   { putByte(c); }
+	void save(char c)          { putByte(c); }
+	void serialize_blob(const char* tag, const void* data, size_t len);
+
+	void beginSection();
+	void endSection();
+
+//internal:
+	inline bool translateEnumToString() const { return true; }
+
+private:
+	template<typename T> void saveImpl(const T& t, std::false_type /*float*/)
+	{
+		static_assert(std::is_integral<T>::value, "integral type expected");
+		saveVarint(zigzag(t, std::is_signed<T>()));
+	}
+	template<typename T> void saveImpl(const T& t, std::true_type /*float*/)
+	{
+		typename FloatBits<T>::type bits;
+		memcpy(&bits, &t, sizeof(T));
+		saveFixed(bits, sizeof(T));
+	}
+	template<typename T> static uint64_t zigzag(T t, std::true_type /*signed*/)
+	{
+		auto i = int64_t(t);
+		return (uint64_t(i) << 1) ^ uint64_t(i >> 63);
+	}
+	template<typename T> static uint64_t zigzag(T t, std::false_type /*signed*/)
+	{
+		return uint64_t(t);
+	}
+	void putByte(byte b) { *buffer.allocate(1) = b; }
+	void saveVarint(uint64_t value);
+	void saveFixed(uint64_t value, size_t len);
+
+	OutputBuffer buffer;
+	std::vector<size_t> openSections;
+	std::string filename;
+};
+
+// The input file is memory mapped (on platforms that support it), so data
+// is only read from disk when it's actually needed. Large blobs are stored
+// uncompressed and page aligned, they are copied straight from the OS page
+// cache (shared by all processes that load the same file) into the device.
+class BinInputArchive final : public InputArchiveBase<BinInputArchive>
+{
+public:
+	explicit BinInputArchive(const std::string& filename);
+	~BinInputArchive();
+
+	/** Does the given file start with the signature of a binary archive?
+	 * Returns false for non-existing or unreadable files.
+	 */
+	static bool isBinArchive(const std::string& filename);
+
+	inline bool versionAtLeast(unsigned actual, unsigned required) const
+	{
+		return actual >= required;
+	}
+	inline bool versionBelow(unsigned actual, unsigned required) const
+	{
+		return actual < required;
+	}
+
+	template<typename T> void load(T& t)
+	{
+		loadImpl(t, std::is_floating_point<T>());
+	}
+	inline void loadChar(char& c) { c = getByte(); }
+	void load(std::string& s);
+	string_ref loadStr();
+	void load(bool& b)          { b = getByte() != 0; }
+	void load(unsigned char& b) { b = getByte(); }
+	void load(signed char& c)   { c = getByte(); }
+	void load(char& c)          { c = getByte(); }
+	void serialize_blob(const char* tag, void* data, size_t len);
+
+	void skipSection(bool skip);
+
+//internal:
+	inline bool translateEnumToString() const { return true; }
+
+private:
+	template<typename T> void loadImpl(T& t, std::false_type /*float*/)
+	{
+		static_assert(std::is_integral<T>::value, "integral type expected");
+		t = unzigzag<T>(loadVarint(), std::is_signed<T>());
+	}
+	template<typename T> void loadImpl(T& t, std::true_type /*float*/)
+	{
+		auto bits = typename FloatBits<T>::type(loadFixed(sizeof(T)));
+		memcpy(&t, &bits, sizeof(T));
+	}
+	template<typename T> static T unzigzag(uint64_t u, std::true_type /*signed*/)
+	{
+		return T(int64_t(u >> 1) ^ -int64_t(u & 1));
+	}
+	template<typename T> static T unzigzag(uint64_t u, std::false_type /*signed*/)
+	{
+		return T(u);
+	}
+	byte getByte() { return *get(1); }
+	const byte* get(size_t len);
+	uint64_t loadVarint();
+	uint64_t loadFixed(size_t len);
+
+	std::unique_ptr<File> file;
+	const byte* begin;
+	const byte* pos;
+	const byte* finish;
+};
+
 #define INSTANTIATE_SERIALIZE_METHODS(CLASS) \
 template void CLASS::serialize(MemInputArchive&,   unsigned); \
 template void CLASS::serialize(MemOutputArchive&,  unsigned); \
 template void CLASS::serialize(XmlInputArchive&,   unsigned); \
-template void CLASS::serialize(XmlOutputArchive&,  unsigned);
+template void CLASS::serialize(XmlOutputArchive&,  unsigned); \
+template void CLASS::serialize(BinInputArchive&,   unsigned); \
+template void CLASS::serialize(BinOutputArchive&,  unsigned);
 
 } // namespace openmsx
 
@@ -11,6 +11,8 @@ DACSound16S::DACSound16S(string_ref name_, string_ref desc,
 	: SoundDevice(config.getMotherBoard().getMSXMixer(), name_, desc, 1)
 	, lastWrittenValue(0)
 {
+	// Once the blip buffer is empty, it stays empty until writeDAC().
+	allowIdle();
 	registerSound(config);
 }
 
@@ -34,6 +36,7 @@ void DACSound16S::writeDAC(int16_t value, EmuTime::param time)
 	int delta = value - lastWrittenValue;
 	if (delta == 0) return;
 	lastWrittenValue = value;
+	wakeUp(); // doesn't go via updateStream()
 
 	BlipBuffer::TimeIndex t;
 	getHostSampleClock().getTicksTill(time, t);
@@ -22,6 +22,7 @@
 #include "unreachable.hh"
 #include "vla.hh"
 #include <algorithm>
+#include <atomic>
 #include <tuple>
 #include <cmath>
 #include <cstring>
@@ -44,12 +45,14 @@ MSXMixer::MSXMixer(Mixer& mixer_, MSXMotherBoard& motherBoard_,
 	, motherBoard(motherBoard_)
 	, commandController(motherBoard.getMSXCommandController())
 	, masterVolume(mixer.getMasterVolume())
+	, soundThreadsSetting(mixer.getSoundThreadsSetting())
 	, speedSetting(globalSettings.getSpeedSetting())
 	, throttleManager(globalSettings.getThrottleManager())
 	, prevTime(getCurrentTime(), 44100)
 	, soundDeviceInfo(commandController.getMachineInfoCommand())
 	, recorder(nullptr)
 	, synchronousCounter(0)
+	, deviceBufSize(0)
 {
 	hostSampleRate = 44100;
 	fragmentSize = 0;
@@ -58,8 +61,10 @@ MSXMixer::MSXMixer(Mixer& mixer_, MSXMotherBoard& motherBoard_,
 	unmute(); // calls Mixer::registerMixer()
 
 	reschedule2();
+	updateWorkers();
 
 	masterVolume.attach(*this);
+	soundThreadsSetting.attach(*this);
 	speedSetting.attach(*this);
 	throttleManager.attach(*this);
 }
@@ -73,6 +78,7 @@ MSXMixer::~MSXMixer()
 
 	throttleManager.detach(*this);
 	speedSetting.detach(*this);
+	soundThreadsSetting.detach(*this);
 	masterVolume.detach(*this);
 
 	mute(); // calls Mixer::unregisterMixer()
@@ -485,37 +491,69 @@ void MSXMixer::generate(int16_t* output, EmuTime::param time, unsigned samples)
 	// reuse 'output' as temporary storage
 	auto* monoBuf = reinterpret_cast<int32_t*>(output);
 
+	// Generating the devices is independent of each other (only the mixing
+	// below depends on the order), so when possible let the worker threads
+	// generate them all upfront. For small chunks that's not worth the
+	// synchronization overhead.
+	static const unsigned MIN_PARALLEL_SAMPLES = 64;
+	unsigned pitch = (2 * samples + 3 + 3) & ~3; // keep SSE alignment
+	bool parallel = !workers.empty() && (infos.size() > 1) &&
+	                (samples >= MIN_PARALLEL_SAMPLES);
+	if (parallel) {
+		generateParallel(time, samples, pitch);
+	}
+	// Returns the output of the i-th device (or nullptr if it's silent).
+	// When not yet generated, the device writes its output in 'buf'.
+	auto getDeviceData = [&](unsigned i, int32_t* buf) -> const int32_t* {
+		if (!parallel) {
+			return infos[i].device->updateBuffer(samples, buf, time)
+			     ? buf : nullptr;
+		}
+		return deviceActive[i] ? &deviceBuf[i * pitch] : nullptr;
+	};
+	// Same as above, but the output always ends up in 'buf'.
+	auto updateBuffer = [&](unsigned i, int32_t* buf) {
+		const int32_t* data = getDeviceData(i, buf);
+		if (data && (data != buf)) {
+			unsigned n = infos[i].device->isStereo() ? 2 * samples
+			                                         : samples;
+			memcpy(buf, data, n * sizeof(int32_t));
+		}
+		return data != nullptr;
+	};
+
 	static const unsigned HAS_MONO_FLAG = 1;
 	static const unsigned HAS_STEREO_FLAG = 2;
 	unsigned usedBuffers = 0;
 
 	// FIXME: The Infos should be ordered such that all the mono
 	// devices are handled first
-	for (auto& info : infos) {
+	for (unsigned i = 0; i < infos.size(); ++i) {
+		auto& info = infos[i];
 		SoundDevice& device = *info.device;
 		int l1 = info.left1;
 		int r1 = info.right1;
 		if (!device.isStereo()) {
 			if (l1 == r1) {
 				if (!(usedBuffers & HAS_MONO_FLAG)) {
-					if (device.updateBuffer(samples, monoBuf, time)) {
+					if (updateBuffer(i, monoBuf)) {
 						usedBuffers |= HAS_MONO_FLAG;
 						mul(monoBuf, samples, l1);
 					}
 				} else {
-					if (device.updateBuffer(samples, tmpBuf, time)) {
-						mulAcc(monoBuf, tmpBuf, samples, l1);
+					if (auto* data = getDeviceData(i, tmpBuf)) {
+						mulAcc(monoBuf, data, samples, l1);
 					}
 				}
 			} else {
 				if (!(usedBuffers & HAS_STEREO_FLAG)) {
-					if (device.updateBuffer(samples, stereoBuf, time)) {
+					if (updateBuffer(i, stereoBuf)) {
 						usedBuffers |= HAS_STEREO_FLAG;
 						mulExpand(stereoBuf, samples, l1, r1);
 					}
 				} else {
-					if (device.updateBuffer(samples, tmpBuf, time)) {
-						mulExpandAcc(stereoBuf, tmpBuf, samples, l1, r1);
+					if (auto* data = getDeviceData(i, tmpBuf)) {
+						mulExpandAcc(stereoBuf, data, samples, l1, r1);
 					}
 				}
 			}
@@ -526,24 +564,24 @@ void MSXMixer::generate(int16_t* output, EmuTime::param time, unsigned samples)
 				assert(l2 == 0);
 				assert(r1 == 0);
 				if (!(usedBuffers & HAS_STEREO_FLAG)) {
-					if (device.updateBuffer(samples, stereoBuf, time)) {
+					if (updateBuffer(i, stereoBuf)) {
 						usedBuffers |= HAS_STEREO_FLAG;
 						mul(stereoBuf, 2 * samples, l1);
 					}
 				} else {
-					if (device.updateBuffer(samples, tmpBuf, time)) {
-						mulAcc(stereoBuf, tmpBuf, 2 * samples, l1);
+					if (auto* data = getDeviceData(i, tmpBuf)) {
+						mulAcc(stereoBuf, data, 2 * samples, l1);
 					}
 				}
 			} else {
 				if (!(usedBuffers & HAS_STEREO_FLAG)) {
-					if (device.updateBuffer(samples, stereoBuf, time)) {
+					if (updateBuffer(i, stereoBuf)) {
 						usedBuffers |= HAS_STEREO_FLAG;
 						mulMix2(stereoBuf, samples, l1, l2, r1, r2);
 					}
 				} else {
-					if (device.updateBuffer(samples, tmpBuf, time)) {
-						mulMix2Acc(stereoBuf, tmpBuf, samples, l1, l2, r1, r2);
+					if (auto* data = getDeviceData(i, tmpBuf)) {
+						mulMix2Acc(stereoBuf, data, samples, l1, l2, r1, r2);
 					}
 				}
 			}
@@ -591,6 +629,58 @@ void MSXMixer::generate(int16_t* output, EmuTime::param time, unsigned samples)
 	}
 }
 
+void MSXMixer::generateParallel(
+	EmuTime::param time, unsigned samples, unsigned pitch)
+{
+	auto num = unsigned(infos.size());
+	unsigned size = num * pitch;
+	if (deviceBufSize < size) {
+		deviceBufSize = size;
+		deviceBuf.resize(deviceBufSize);
+	}
+	deviceActive.assign(num, false);
+	deviceErrors.assign(num, nullptr);
+
+	// All threads (the workers and this thread) repeatedly take the next
+	// device that's not yet generated. Some devices are a lot more
+	// expensive than others, this keeps all threads busy.
+	std::atomic<unsigned> next(0);
+	auto task = [&]() {
+		while (true) {
+			unsigned i = next++;
+			if (i >= num) break;
+			// tasks can't throw, rethrow below
+			try {
+				deviceActive[i] = infos[i].device->updateBuffer(
+					samples, &deviceBuf[i * pitch], time);
+			} catch (...) {
+				deviceErrors[i] = std::current_exception();
+			}
+		}
+	};
+	auto numWorkers = std::min<unsigned>(unsigned(workers.size()), num - 1);
+	for (unsigned t = 0; t < numWorkers; ++t) {
+		workers[t]->addTask(task);
+	}
+	task();
+	for (unsigned t = 0; t < numWorkers; ++t) {
+		workers[t]->waitIdle();
+	}
+
+	for (auto& e : deviceErrors) {
+		if (e) std::rethrow_exception(e);
+	}
+}
+
+void MSXMixer::updateWorkers()
+{
+	auto num = unsigned(soundThreadsSetting.getInt());
+	while (workers.size() < num) {
+		workers.push_back(make_unique<WorkerThread>());
+	}
+	workers.resize(num);
+}
+
 bool MSXMixer::needStereoRecording() const
 {
 	return any_of(begin(infos), end(infos),
@@ -659,6 +749,8 @@ void MSXMixer::update(const Setting& setting)
 {
 	if (&setting == &masterVolume) {
 		updateMasterVolume();
+	} else if (&setting == &soundThreadsSetting) {
+		updateWorkers();
 	} else if (&setting == &speedSetting) {
 		if (synchronousCounter == 0) {
 			setMixerParams(fragmentSize, hostSampleRate);
@@ -819,6 +911,22 @@ void MSXMixer::SoundDeviceInfoTopic::execute(
 		result.setString(device->getDescription());
 		break;
 	}
+	case 4: {
+		SoundDevice* device = msxMixer.findDevice(tokens[2].getString());
+		if (!device) {
+			throw CommandException("Unknown sound device");
+		}
+		if (tokens[3].getString() != "stats") {
+			throw CommandException("Unknown subcommand, expected 'stats'");
+		}
+		result.addListElement("generated");
+		result.addListElement(StringOp::toString(device->getGeneratedSamples()));
+		result.addListElement("skipped");
+		result.addListElement(StringOp::toString(device->getSkippedSamples()));
+		result.addListElement("idle");
+		result.addListElement(int(device->isIdle()));
+		break;
+	}
 	default:
 		throw CommandException("Too many parameters");
 	}
@@ -826,7 +934,10 @@ void MSXMixer::SoundDeviceInfoTopic::execute(
 
 string MSXMixer::SoundDeviceInfoTopic::help(const vector<string>& /*tokens*/) const
 {
-	return "Shows a list of available sound devices.\n";
+	return "Shows a list of available sound devices, or the description of "
+	       "the given sound device.\n"
+	       "'machine_info sounddevice <device> stats' shows the number of "
+	       "generated and skipped (because the device was idle) samples.\n";
 }
 
 void MSXMixer::SoundDeviceInfoTopic::tabCompletion(vector<string>& tokens) const
@@ -838,6 +949,9 @@ void MSXMixer::SoundDeviceInfoTopic::tabCompletion(vector<string>& tokens) const
 			devices.push_back(info.device->getName());
 		}
 		completeString(tokens, devices);
+	} else if (tokens.size() == 4) {
+		static const char* const subCmds[] = { "stats" };
+		completeString(tokens, subCmds);
 	}
 }
 
@@ -6,7 +6,10 @@
 #include "InfoTopic.hh"
 #include "EmuTime.hh"
 #include "DynamicClock.hh"
+#include "MemBuffer.hh"
+#include "WorkerThread.hh"
 #include <cstdint>
+#include <exception>
 #include <vector>
 #include <memory>
 
@@ -123,6 +126,9 @@ private:
 	void reschedule();
 	void reschedule2();
 	void generate(int16_t* buffer, EmuTime::param time, unsigned samples);
+	void generateParallel(EmuTime::param time, unsigned samples,
+	                      unsigned pitch);
+	void updateWorkers();
 
 	// Schedulable
 	void executeUntil(EmuTime::param time) override;
@@ -146,6 +152,7 @@ private:
 	MSXCommandController& commandController;
 
 	IntegerSetting& masterVolume;
+	IntegerSetting& soundThreadsSetting;
 	IntegerSetting& speedSetting;
 	ThrottleManager& throttleManager;
 
@@ -164,6 +171,14 @@ private:
 
 	unsigned muteCount;
 	int32_t tl0, tr0; // internal DC-filter state
+
+	// Extra threads to generate the sound devices in parallel (see the
+	// 'sound_threads' setting), and the output of those devices.
+	std::vector<std::unique_ptr<WorkerThread>> workers;
+	MemBuffer<int32_t, SSE2_ALIGNMENT> deviceBuf;
+	unsigned deviceBufSize;
+	std::vector<char> deviceActive; // result of updateBuffer()
+	std::vector<std::exception_ptr> deviceErrors;
 };
 
 } // namespace openmsx
@@ -3,16 +3,22 @@
 #include "NullSoundDriver.hh"
 #include "SDLSoundDriver.hh"
 #include "DirectXSoundDriver.hh"
+#include "Reactor.hh"
 #include "CommandController.hh"
+#include "TclObject.hh"
 #include "CliComm.hh"
 #include "MSXException.hh"
 #include "memory.hh"
+#include "outer.hh"
 #include "stl.hh"
 #include "unreachable.hh"
 #include "components.hh"
 #include "build-info.hh"
 #include <cassert>
 
+using std::string;
+using std::vector;
+
 namespace openmsx {
 
 #if defined(_WIN32)
@@ -62,6 +68,12 @@ Mixer::Mixer(Reactor& reactor_, CommandController& commandController_)
 	, samplesSetting(
 		commandController, "samples",
 		"mixer samples", defaultsamples, 64, 8192)
+	, soundThreadsSetting(
+		commandController, "sound_threads",
+		"number of extra threads used to generate the sound of the "
+		"sound devices in parallel, 0 means all sound is generated "
+		"in the emulation thread", 0, 0, 8)
+	, soundDriverInfo(reactor.getOpenMSXInfoCommand())
 	, muteCount(0)
 {
 	muteSetting       .attach(*this);
@@ -192,4 +204,39 @@ void Mixer::update(const Setting& setting)
 	}
 }
 
+
+// class SoundDriverInfoTopic
+
+Mixer::SoundDriverInfoTopic::SoundDriverInfoTopic(InfoCommand& openMSXInfoCommand)
+	: InfoTopic(openMSXInfoCommand, "sound_driver_stats")
+{
+}
+
+void Mixer::SoundDriverInfoTopic::execute(
+	array_ref<TclObject> /*tokens*/, TclObject& result) const
+{
+	auto& mixer = OUTER(Mixer, soundDriverInfo);
+	auto stats = mixer.driver->getStats();
+	result.addListElement("underruns");
+	result.addListElement(int(stats.underruns));
+	result.addListElement("overruns");
+	result.addListElement(int(stats.overruns));
+	result.addListElement("buffered");
+	result.addListElement(int(stats.buffered));
+	result.addListElement("latency");
+	result.addListElement(int(stats.latency));
+}
+
+string Mixer::SoundDriverInfoTopic::help(const vector<string>& /*tokens*/) const
+{
+	return "Shows statistics about the buffer between the emulation and the "
+	       "sound output: the number of underruns (the sound output ran "
+	       "out of samples, this causes hiccups), the number of overruns "
+	       "(the number of samples that were dropped because the buffer "
+	       "was full, that's normal when the emulation isn't throttled), the number of "
+	       "currently buffered samples and the maximum number of buffered "
+	       "samples (this adapts to the number of underruns). All zeros "
+	       "when the sound driver doesn't keep track of these.";
+}
+
 } // namespace openmsx
@@ -2,6 +2,7 @@
 #define MIXER_HH
 
 #include "Observer.hh"
+#include "InfoTopic.hh"
 #include "BooleanSetting.hh"
 #include "EnumSetting.hh"
 #include "IntegerSetting.hh"
@@ -46,6 +47,7 @@ public:
 	void uploadBuffer(MSXMixer& msxMixer, int16_t* buffer, unsigned len);
 
 	IntegerSetting& getMasterVolume() { return masterVolume; }
+	IntegerSetting& getSoundThreadsSetting() { return soundThreadsSetting; }
 
 private:
 	void reloadDriver();
@@ -65,6 +67,14 @@ private:
 	IntegerSetting masterVolume;
 	IntegerSetting frequencySetting;
 	IntegerSetting samplesSetting;
+	IntegerSetting soundThreadsSetting;
+
+	struct SoundDriverInfoTopic final : InfoTopic {
+		explicit SoundDriverInfoTopic(InfoCommand& openMSXInfoCommand);
+		void execute(array_ref<TclObject> tokens,
+		             TclObject& result) const override;
+		std::string help(const std::vector<std::string>& tokens) const override;
+	} soundDriverInfo;
 
 	int muteCount;
 };
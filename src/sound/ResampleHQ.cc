@@ -27,6 +27,9 @@
 #ifdef __SSE2__
 #include <emmintrin.h>
 #endif
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
 namespace openmsx {
 
@@ -295,6 +298,81 @@ static inline void calcSseStereo(const float* buf_, const float* tab_, size_t le
 }
 #endif
 
+#ifdef __AVX2__
+static inline __m256 fmadd(__m256 a, __m256 b, __m256 c)
+{
+#ifdef __FMA__
+	return _mm256_fmadd_ps(a, b, c);
+#else
+	return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+}
+
+// Same as calcSseMono(), but handles 8 (or 16) coefficients per step.
+static inline void calcAvx2Mono(const float* buf, const float* tab, size_t len, int* out)
+{
+	assert((len % 4) == 0);
+	assert((uintptr_t(tab) % 16) == 0);
+
+	__m256 a0 = _mm256_setzero_ps();
+	__m256 a1 = _mm256_setzero_ps();
+	size_t i = 0;
+	for (/**/; (i + 16) <= len; i += 16) {
+		a0 = fmadd(_mm256_loadu_ps(buf + i + 0), _mm256_loadu_ps(tab + i + 0), a0);
+		a1 = fmadd(_mm256_loadu_ps(buf + i + 8), _mm256_loadu_ps(tab + i + 8), a1);
+	}
+	if (len & 8) {
+		a0 = fmadd(_mm256_loadu_ps(buf + i), _mm256_loadu_ps(tab + i), a0);
+		i += 8;
+	}
+	__m256 a = _mm256_add_ps(a0, a1);
+	__m128 s = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+	if (len & 4) {
+		s = _mm_add_ps(s, _mm_mul_ps(_mm_loadu_ps(buf + i), _mm_load_ps(tab + i)));
+	}
+	__m128 t = _mm_add_ps(s, _mm_movehl_ps(s, s));
+	t = _mm_add_ss(t, _mm_shuffle_ps(t, t, 1));
+
+	*out = _mm_cvtss_si32(t);
+}
+
+// Same as calcSseStereo(). Each coefficient is duplicated (t0 t0 t1 t1 ..) to
+// match the interleaved left/right samples in the buffer.
+static inline void calcAvx2Stereo(const float* buf, const float* tab, size_t len, int* out)
+{
+	assert((len % 4) == 0);
+	assert((uintptr_t(tab) % 16) == 0);
+
+	__m256i dup = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+	__m256 a0 = _mm256_setzero_ps();
+	__m256 a1 = _mm256_setzero_ps();
+	size_t i = 0;
+	for (/**/; (i + 8) <= len; i += 8) {
+		__m256 t0 = _mm256_permutevar8x32_ps(
+			_mm256_castps128_ps256(_mm_load_ps(tab + i + 0)), dup);
+		__m256 t1 = _mm256_permutevar8x32_ps(
+			_mm256_castps128_ps256(_mm_load_ps(tab + i + 4)), dup);
+		a0 = fmadd(_mm256_loadu_ps(buf + 2 * i + 0), t0, a0);
+		a1 = fmadd(_mm256_loadu_ps(buf + 2 * i + 8), t1, a1);
+	}
+	if (len & 4) {
+		__m256 t0 = _mm256_permutevar8x32_ps(
+			_mm256_castps128_ps256(_mm_load_ps(tab + i)), dup);
+		a0 = fmadd(_mm256_loadu_ps(buf + 2 * i), t0, a0);
+	}
+	__m256 a = _mm256_add_ps(a0, a1);
+	__m128 s = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+	s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+	__m128i si = _mm_cvtps_epi32(s);
+#if ASM_X86_64
+	*reinterpret_cast<int64_t*>(out) = _mm_cvtsi128_si64(si);
+#else
+	out[0] = _mm_cvtsi128_si32(si);
+	out[1] = _mm_cvtsi128_si32(_mm_shuffle_epi32(si, 0x55));
+#endif
+}
+#endif
+
 template <unsigned CHANNELS>
 void ResampleHQ<CHANNELS>::calcOutput(
 	float pos, int* __restrict output)
@@ -309,7 +387,14 @@ void ResampleHQ<CHANNELS>::calcOutput(
 	bufIdx *= CHANNELS;
 	const float* buf = &buffer[bufIdx];
 
-#ifdef __SSE2__
+#if defined(__AVX2__)
+	if (CHANNELS == 1) {
+		calcAvx2Mono  (buf, tab, filterLen, output);
+	} else {
+		calcAvx2Stereo(buf, tab, filterLen, output);
+	}
+	return;
+#elif defined(__SSE2__)
 	if (CHANNELS == 1) {
 		calcSseMono  (buf, tab, filterLen, output);
 	} else {
@@ -8,13 +8,6 @@
 
 namespace openmsx {
 
-// 16-byte aligned buffer of ints (shared among all instances of this resampler)
-static std::vector<int> bufferStorage; // (possibly) unaligned storage
-static unsigned bufferSize = 0; // usable buffer size (aligned portion)
-static int* bufferInt = nullptr; // pointer to aligned sub-buffer
-
-////
-
 template<unsigned CHANNELS>
 std::unique_ptr<ResampleLQ<CHANNELS>> ResampleLQ<CHANNELS>::create(
 		ResampledSoundDevice& input,
@@ -40,6 +33,8 @@ ResampleLQ<CHANNELS>::ResampleLQ(
 	, hostClock(hostClock_)
 	, emuClock(hostClock.getTime(), emuSampleRate)
 	, step(FP::roundRatioDown(emuSampleRate, hostClock.getFreq()))
+	, bufferSize(0)
+	, bufferInt(nullptr)
 {
 	for (auto& l : lastInput) l = 0;
 }
@@ -114,7 +109,7 @@ bool ResampleLQUp<CHANNELS>::generateOutput(
 	// this is currently only used to upsample cassette player sound,
 	// sound quality is not so important here, so use 0-th order
 	// interpolation (instead of 1st-order).
-	int* buffer = &bufferInt[4 - 2 * CHANNELS];
+	int* buffer = &this->bufferInt[4 - 2 * CHANNELS];
 	for (unsigned i = 0; i < hostNum; ++i) {
 		unsigned p = pos.toInt();
 		assert(p < valid);
@@ -150,7 +145,7 @@ bool ResampleLQDown<CHANNELS>::generateOutput(
 	unsigned valid;
 	if (!this->fetchData(time, valid)) return false;
 
-	int* buffer = &bufferInt[4 - 2 * CHANNELS];
+	int* buffer = &this->bufferInt[4 - 2 * CHANNELS];
 #ifdef __arm__
 	if (CHANNELS == 1) {
 		unsigned dummy;
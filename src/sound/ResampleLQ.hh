@@ -5,6 +5,7 @@
 #include "DynamicClock.hh"
 #include "FixedPoint.hh"
 #include <memory>
+#include <vector>
 
 namespace openmsx {
 
@@ -29,6 +30,11 @@ protected:
 	using FP = FixedPoint<14>;
 	const FP step;
 	int lastInput[2 * CHANNELS];
+
+	// 16-byte aligned buffer of ints
+	std::vector<int> bufferStorage; // (possibly) unaligned storage
+	unsigned bufferSize; // usable buffer size (aligned portion)
+	int* bufferInt; // pointer to aligned sub-buffer
 };
 
 template <unsigned CHANNELS>
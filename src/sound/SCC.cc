@@ -127,6 +127,9 @@ SCC::SCC(const string& name_, const DeviceConfig& config,
 	setInputRate(int(input + 0.5f));
 
 	powerUp(time);
+	// Muted channels stay muted until the volume or enable registers
+	// change, skipChannels() keeps the phase counters running.
+	allowIdle();
 	registerSound(config);
 }
 
@@ -532,16 +535,29 @@ void SCC::generateChannels(int** bufs, unsigned num)
 #endif
 		} else {
 			bufs[i] = nullptr; // channel muted
-			// Update phase counter.
-			unsigned newCount = count[i] + num * incr[i];
-			count[i] = newCount % (period[i] + 1);
-			pos[i] = (pos[i] + newCount / (period[i] + 1)) % 32;
-			// Channel stays off until next waveform index.
-			out[i] = 0;
+			advanceMuted(i, num);
 		}
 	}
 }
 
+void SCC::skipChannels(unsigned num)
+{
+	// all channels are muted (see generateChannels())
+	for (unsigned i = 0; i < 5; ++i) {
+		advanceMuted(i, num);
+	}
+}
+
+inline void SCC::advanceMuted(unsigned i, unsigned num)
+{
+	// Update phase counter.
+	unsigned newCount = count[i] + num * incr[i];
+	count[i] = newCount % (period[i] + 1);
+	pos[i] = (pos[i] + newCount / (period[i] + 1)) % 32;
+	// Channel stays off until next waveform index.
+	out[i] = 0;
+}
+
 
 // Debuggable
 
@@ -571,6 +587,7 @@ byte SCC::Debuggable::read(unsigned address, EmuTime::param time)
 void SCC::Debuggable::write(unsigned address, byte value, EmuTime::param time)
 {
 	auto& scc = OUTER(SCC, debuggable);
+	scc.wakeUp(); // doesn't go via writeMem()
 	if (address < 0xA0) {
 		// read wave form 1..5
 		scc.writeWave(address >> 5, address, value);
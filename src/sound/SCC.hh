@@ -32,7 +32,9 @@ private:
 	// SoundDevice
 	int getAmplificationFactor() const override;
 	void generateChannels(int** bufs, unsigned num) override;
+	void skipChannels(unsigned num) override;
 
+	inline void advanceMuted(unsigned channel, unsigned num);
 	inline int adjust(signed char wav, byte vol);
 	byte readWave(unsigned channel, unsigned address, EmuTime::param time) const;
 	void writeWave(unsigned channel, unsigned offset, byte value);
@@ -19,6 +19,14 @@ namespace openmsx {
 SDLSoundDriver::SDLSoundDriver(Reactor& reactor_,
                                unsigned wantedFreq, unsigned wantedSamples)
 	: reactor(reactor_)
+	, readIdx(0)
+	, writeIdx(0)
+	, underruns(0)
+	, refilling(true)
+	, overruns(0)
+	, refilled(0)
+	, lastUnderruns(0)
+	, stableSamples(0)
 	, muted(true)
 {
 	SDL_AudioSpec desired;
@@ -44,7 +52,12 @@ SDLSoundDriver::SDLSoundDriver(Reactor& reactor_,
 	frequency = audioSpec.freq;
 	fragmentSize = audioSpec.samples;
 
-	mixBufferSize = 3 * (audioSpec.size / sizeof(int16_t)) + 2;
+	// Buffer between two and four fragments, see adjustLatency().
+	unsigned fragment = audioSpec.size / sizeof(int16_t);
+	minLatency = 2 * fragment;
+	maxLatency = 4 * fragment;
+	maxFilled = minLatency;
+	mixBufferSize = maxLatency + 2;
 	mixBuffer.resize(mixBufferSize);
 	reInit();
 }
@@ -60,6 +73,10 @@ void SDLSoundDriver::reInit()
 	SDL_LockAudio();
 	readIdx  = 0;
 	writeIdx = 0;
+	// Running out of samples while the (now empty) buffer is filled up
+	// again is not an underrun, see audioCallback().
+	refilling = true;
+	refilled = 0;
 	SDL_UnlockAudio();
 }
 
@@ -97,9 +114,9 @@ void SDLSoundDriver::audioCallbackHelper(void* userdata, byte* strm, int len)
 		audioCallback(reinterpret_cast<int16_t*>(strm), len / sizeof(int16_t));
 }
 
-unsigned SDLSoundDriver::getBufferFilled() const
+unsigned SDLSoundDriver::getBufferFilled(unsigned readPos, unsigned writePos) const
 {
-	int result = writeIdx - readIdx;
+	int result = writePos - readPos;
 	if (result < 0) result += mixBufferSize;
 	assert((0 <= result) && (unsigned(result) < mixBufferSize));
 	return result;
@@ -107,71 +124,120 @@ unsigned SDLSoundDriver::getBufferFilled() const
 
 unsigned SDLSoundDriver::getBufferFree() const
 {
-	// we can't distinguish completely filled from completely empty
-	// (in both cases readIx would be equal to writeIdx), so instead
-	// we define full as '(writeIdx + 2) == readIdx' (note that index
-	// increases in steps of 2 (stereo)).
-	int result = mixBufferSize - 2 - getBufferFilled();
-	assert((0 <= result) && (unsigned(result) < mixBufferSize));
-	return result;
+	// We can't distinguish completely filled from completely empty
+	// (in both cases readIdx would be equal to writeIdx). That's not a
+	// problem because we never fill the buffer beyond 'maxFilled', which
+	// is at most 'mixBufferSize - 2'.
+	unsigned filled = getBufferFilled(
+		readIdx.load(std::memory_order_acquire),
+		writeIdx.load(std::memory_order_relaxed));
+	return (filled < maxFilled) ? (maxFilled - filled) : 0;
+}
+
+void SDLSoundDriver::adjustLatency(unsigned len)
+{
+	// After an underrun, buffer a quarter fragment more (up to
+	// 'maxLatency'). After 10 seconds without underruns, try again with a
+	// quarter fragment less (down to 'minLatency').
+	unsigned step = fragmentSize / 2; // stereo, so 2 * fragmentSize / 4
+	unsigned newUnderruns = underruns.load(std::memory_order_relaxed);
+	if (newUnderruns != lastUnderruns) {
+		lastUnderruns = newUnderruns;
+		stableSamples = 0;
+		maxFilled = std::min(maxFilled + step, maxLatency);
+	} else {
+		stableSamples += len;
+		if (stableSamples >= 2 * 10 * frequency) {
+			stableSamples = 0;
+			maxFilled = std::max(maxFilled - step, minLatency);
+		}
+	}
 }
 
 void SDLSoundDriver::audioCallback(int16_t* stream, unsigned len)
 {
 	assert((len & 1) == 0); // stereo
-	unsigned available = getBufferFilled();
+	unsigned readPos = readIdx.load(std::memory_order_relaxed);
+	unsigned available = getBufferFilled(
+		readPos, writeIdx.load(std::memory_order_acquire));
 	unsigned num = std::min(len, available);
-	if ((readIdx + num) < mixBufferSize) {
-		memcpy(stream, &mixBuffer[readIdx], num * sizeof(int16_t));
-		readIdx += num;
+	if ((readPos + num) < mixBufferSize) {
+		memcpy(stream, &mixBuffer[readPos], num * sizeof(int16_t));
+		readPos += num;
 	} else {
-		unsigned len1 = mixBufferSize - readIdx;
-		memcpy(stream, &mixBuffer[readIdx], len1 * sizeof(int16_t));
+		unsigned len1 = mixBufferSize - readPos;
+		memcpy(stream, &mixBuffer[readPos], len1 * sizeof(int16_t));
 		unsigned len2 = num - len1;
 		memcpy(&stream[len1], &mixBuffer[0], len2 * sizeof(int16_t));
-		readIdx = len2;
+		readPos = len2;
 	}
+	readIdx.store(readPos, std::memory_order_release);
 	int missing = len - available;
 	if (missing > 0) {
-		// buffer underrun
+		// buffer underrun, but only count it when the buffer was already
+		// filled after reInit() (otherwise every unmute would increase
+		// the latency, see adjustLatency())
 		memset(&stream[available], 0, missing * sizeof(int16_t));
+		if (!refilling.load(std::memory_order_acquire)) {
+			underruns.fetch_add(1, std::memory_order_relaxed);
+		}
 	}
 }
 
 void SDLSoundDriver::uploadBuffer(int16_t* buffer, unsigned len)
 {
-	SDL_LockAudio();
 	len *= 2; // stereo
+	adjustLatency(len);
 	unsigned free = getBufferFree();
+	if ((len > free) &&
+	    reactor.getGlobalSettings().getThrottleManager().isThrottled()) {
+		// Wait till there's enough room, or till the buffer is empty
+		// ('len' can be larger than 'maxFilled').
+		do {
+			Timer::sleep(5000); // 5ms
+			if (MSXMotherBoard* board = reactor.getMotherBoard()) {
+				board->getRealTime().resync();
+			}
+			free = getBufferFree();
+		} while ((len > free) && (free < maxFilled));
+	}
 	if (len > free) {
-		if (reactor.getGlobalSettings().getThrottleManager().isThrottled()) {
-			do {
-				SDL_UnlockAudio();
-				Timer::sleep(5000); // 5ms
-				SDL_LockAudio();
-				if (MSXMotherBoard* board = reactor.getMotherBoard()) {
-					board->getRealTime().resync();
-				}
-				free = getBufferFree();
-			} while (len > free);
-		} else {
-			// drop excess samples
-			len = free;
-		}
+		// drop excess samples
+		overruns += (len - free) / 2; // stereo
+		len = free;
 	}
-	assert(len <= free);
-	if ((writeIdx + len) < mixBufferSize) {
-		memcpy(&mixBuffer[writeIdx], buffer, len * sizeof(int16_t));
-		writeIdx += len;
+	unsigned writePos = writeIdx.load(std::memory_order_relaxed);
+	if ((writePos + len) < mixBufferSize) {
+		memcpy(&mixBuffer[writePos], buffer, len * sizeof(int16_t));
+		writePos += len;
 	} else {
-		unsigned len1 = mixBufferSize - writeIdx;
-		memcpy(&mixBuffer[writeIdx], buffer, len1 * sizeof(int16_t));
+		unsigned len1 = mixBufferSize - writePos;
+		memcpy(&mixBuffer[writePos], buffer, len1 * sizeof(int16_t));
 		unsigned len2 = len - len1;
 		memcpy(&mixBuffer[0], &buffer[len1], len2 * sizeof(int16_t));
-		writeIdx = len2;
+		writePos = len2;
 	}
+	writeIdx.store(writePos, std::memory_order_release);
 
-	SDL_UnlockAudio();
+	if (refilling.load(std::memory_order_relaxed)) {
+		// at least one fragment uploaded since reInit()
+		refilled += len;
+		if (refilled >= 2 * fragmentSize) { // stereo
+			refilling.store(false, std::memory_order_release);
+		}
+	}
+}
+
+SoundDriver::Stats SDLSoundDriver::getStats() const
+{
+	Stats stats;
+	stats.underruns = underruns.load(std::memory_order_relaxed);
+	stats.overruns  = overruns;
+	stats.buffered  = getBufferFilled(
+		readIdx.load(std::memory_order_acquire),
+		writeIdx.load(std::memory_order_relaxed)) / 2; // stereo
+	stats.latency   = maxFilled / 2;
+	return stats;
 }
 
 } // namespace openmsx
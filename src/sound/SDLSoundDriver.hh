@@ -4,6 +4,7 @@
 #include "SoundDriver.hh"
 #include "MemBuffer.hh"
 #include "openmsx.hh"
+#include <atomic>
 
 namespace openmsx {
 
@@ -26,11 +27,13 @@ public:
 	unsigned getSamples() const override;
 
 	void uploadBuffer(int16_t* buffer, unsigned len) override;
+	Stats getStats() const override;
 
 private:
 	void reInit();
-	unsigned getBufferFilled() const;
+	unsigned getBufferFilled(unsigned readPos, unsigned writePos) const;
 	unsigned getBufferFree() const;
+	void adjustLatency(unsigned len);
 	static void audioCallbackHelper(void* userdata, byte* strm, int len);
 	void audioCallback(int16_t* stream, unsigned len);
 
@@ -39,7 +42,24 @@ private:
 	unsigned mixBufferSize;
 	unsigned frequency;
 	unsigned fragmentSize;
-	unsigned readIdx, writeIdx;
+
+	// mixBuffer is a lock-free single-producer/single-consumer ring
+	// buffer: only uploadBuffer() (emulation thread) writes 'writeIdx'
+	// and only audioCallback() (SDL audio thread) writes 'readIdx'.
+	std::atomic<unsigned> readIdx;
+	std::atomic<unsigned> writeIdx;
+	std::atomic<unsigned> underruns; // written by the audio thread
+	// Set by reInit(), cleared by uploadBuffer() once the buffer has been
+	// filled with at least one fragment again.
+	std::atomic<bool> refilling;
+
+	// Only used in the emulation thread.
+	unsigned overruns; // # dropped samples
+	unsigned refilled; // # samples uploaded since reInit()
+	unsigned maxFilled; // adapts to the number of underruns
+	unsigned minLatency, maxLatency;
+	unsigned lastUnderruns;
+	unsigned stableSamples; // # samples uploaded since last underrun
 	bool muted;
 };
 
@@ -17,17 +17,6 @@ using std::string;
 
 namespace openmsx {
 
-static MemBuffer<int, SSE2_ALIGNMENT> mixBuffer;
-static unsigned mixBufferSize = 0;
-
-static void allocateMixBuffer(unsigned size)
-{
-	if (unlikely(mixBufferSize < size)) {
-		mixBufferSize = size;
-		mixBuffer.resize(mixBufferSize);
-	}
-}
-
 static string makeUnique(MSXMixer& mixer, string_ref name)
 {
 	string result = name.str();
@@ -46,10 +35,15 @@ SoundDevice::SoundDevice(MSXMixer& mixer_, string_ref name_,
 	: mixer(mixer_)
 	, name(makeUnique(mixer, name_))
 	, description(description_.str())
+	, mixBufferSize(0)
+	, generatedSamples(0)
+	, skippedSamples(0)
 	, numChannels(numChannels_)
 	, stereo(stereo_ ? 2 : 1)
 	, numRecordChannels(0)
 	, balanceCenter(true)
+	, idleAllowed(false)
+	, idle(false)
 {
 	assert(numChannels <= MAX_CHANNELS);
 	assert(stereo == 1 || stereo == 2);
@@ -125,6 +119,8 @@ void SoundDevice::unregisterSound()
 void SoundDevice::updateStream(EmuTime::param time)
 {
 	mixer.updateStream(time);
+	// the device is (possibly) about to change, don't skip it anymore
+	wakeUp();
 }
 
 void SoundDevice::recordChannel(unsigned channel, const Filename& filename)
@@ -139,6 +135,8 @@ void SoundDevice::recordChannel(unsigned channel, const Filename& filename)
 	}
 	bool recording = writer[channel] != nullptr;
 	if (recording != wasRecording) {
+		wakeUp(); // also record silence
+
 		if (recording) {
 			if (numRecordChannels == 0) {
 				mixer.setSynchronousMode(true);
@@ -161,12 +159,22 @@ void SoundDevice::muteChannel(unsigned channel, bool muted)
 	channelMuted[channel] = muted;
 }
 
+void SoundDevice::skipChannels(unsigned /*num*/)
+{
+}
+
 bool SoundDevice::mixChannels(int* dataOut, unsigned samples)
 {
 #ifdef __SSE2__
 	assert((uintptr_t(dataOut) & 15) == 0); // must be 16-byte aligned
 #endif
 	if (samples == 0) return true;
+	if (idle) {
+		skipChannels(samples);
+		skippedSamples += samples;
+		return false;
+	}
+	generatedSamples += samples;
 	unsigned outputStereo = isStereo() ? 2 : 1;
 
 	MemoryOps::MemSet<unsigned> mset;
@@ -196,7 +204,11 @@ bool SoundDevice::mixChannels(int* dataOut, unsigned samples)
 		}
 	}
 	if (separateChannels) {
-		allocateMixBuffer(pitch * separateChannels);
+		unsigned size = pitch * separateChannels;
+		if (unlikely(mixBufferSize < size)) {
+			mixBufferSize = size;
+			mixBuffer.resize(mixBufferSize);
+		}
 		mset(reinterpret_cast<unsigned*>(mixBuffer.data()),
 		     pitch * separateChannels, 0);
 		// still need to fill in (some) bufs[i] pointers
@@ -211,6 +223,18 @@ bool SoundDevice::mixChannels(int* dataOut, unsigned samples)
 
 	generateChannels(bufs, samples);
 
+	if (idleAllowed && (numRecordChannels == 0)) {
+		// When all channels are silent, the device stays silent until
+		// it's touched again. Till then there's no need to generate it.
+		idle = true;
+		for (unsigned i = 0; i < numChannels; ++i) {
+			if (bufs[i]) {
+				idle = false;
+				break;
+			}
+		}
+	}
+
 	if (separateChannels == 0) {
 		for (unsigned i = 0; i < numChannels; ++i) {
 			if (bufs[i]) {
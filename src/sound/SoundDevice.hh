@@ -2,7 +2,9 @@
 #define SOUNDDEVICE_HH
 
 #include "EmuTime.hh"
+#include "MemBuffer.hh"
 #include "string_ref.hh"
+#include <cstdint>
 #include <memory>
 
 namespace openmsx {
@@ -46,6 +48,17 @@ public:
 	void recordChannel(unsigned channel, const Filename& filename);
 	void muteChannel  (unsigned channel, bool muted);
 
+	/** Is the generation of this device currently skipped?
+	  * See allowIdle().
+	  */
+	bool isIdle() const { return idle; }
+
+	/** Number of samples that were generated resp. skipped (because the
+	  * device was idle) since this device was created.
+	  */
+	uint64_t getGeneratedSamples() const { return generatedSamples; }
+	uint64_t getSkippedSamples()   const { return skippedSamples; }
+
 protected:
 	/** Constructor.
 	  * @param mixer The Mixer object
@@ -75,6 +88,20 @@ protected:
 	/** @see Mixer::updateStream */
 	void updateStream(EmuTime::param time);
 
+	/** Allow to skip this device while it's idle: once generateChannels()
+	  * produced silence on all channels, it's no longer called (instead
+	  * skipChannels() is called) until the next updateStream() or wakeUp().
+	  * Only use this when generateChannels() keeps producing silence as
+	  * long as the device isn't touched.
+	  */
+	void allowIdle() { idleAllowed = true; }
+
+	/** Stop skipping this device (see allowIdle()). Must be called for
+	  * changes that can make the device produce sound again and that don't
+	  * already go via updateStream().
+	  */
+	void wakeUp() { idle = false; }
+
 	void setInputRate(unsigned sampleRate) { inputSampleRate = sampleRate; }
 	unsigned getInputRate() const { return inputSampleRate; }
 
@@ -123,6 +150,14 @@ protected:
 	  */
 	virtual void generateChannels(int** buffers, unsigned num) = 0;
 
+	/** Called instead of generateChannels() while the device is idle (see
+	  * allowIdle()). It should update the internal state the same way as
+	  * generating 'num' (silent) samples would. The default implementation
+	  * does nothing, that's correct for devices that don't change their
+	  * state while they're silent.
+	  */
+	virtual void skipChannels(unsigned num);
+
 	/** Calls generateChannels() and combines the output to a single
 	  * channel.
 	  * @param dataOut Output buffer, must be big enough to hold
@@ -148,6 +183,14 @@ private:
 
 	std::unique_ptr<Wav16Writer> writer[MAX_CHANNELS];
 
+	// Per device (not shared), so that devices can be generated in
+	// parallel (see MSXMixer).
+	MemBuffer<int, SSE2_ALIGNMENT> mixBuffer;
+	unsigned mixBufferSize;
+
+	uint64_t generatedSamples;
+	uint64_t skippedSamples;
+
 	unsigned inputSampleRate;
 	const unsigned numChannels;
 	const unsigned stereo;
@@ -155,6 +198,8 @@ private:
 	int channelBalance[MAX_CHANNELS];
 	bool channelMuted[MAX_CHANNELS];
 	bool balanceCenter;
+	bool idleAllowed;
+	bool idle;
 };
 
 } // namespace openmsx
@@ -30,6 +30,17 @@ public:
 
 	virtual void uploadBuffer(int16_t* buffer, unsigned len) = 0;
 
+	/** Statistics about the buffer between the emulation and the sound
+	  * output. Drivers that don't keep track of these return all zeros.
+	  */
+	struct Stats {
+		unsigned underruns; // # times the output ran out of samples
+		unsigned overruns;  // # samples dropped because the buffer was full
+		unsigned buffered;  // # samples currently in the buffer
+		unsigned latency;   // max # samples that are buffered
+	};
+	virtual Stats getStats() const { return Stats(); }
+
 protected:
 	SoundDriver() {}
 };
@@ -505,6 +505,8 @@ Y8950::Y8950(const std::string& name_, const DeviceConfig& config,
 	setInputRate(int(input + 0.5f));
 
 	reset(time);
+	// When muted, generateChannels() doesn't update the internal state.
+	allowIdle();
 	registerSound(config);
 }
 
@@ -43,6 +43,7 @@
 #include "Math.hh"
 #include "outer.hh"
 #include "serialize.hh"
+#include "vla.hh"
 #include <cmath>
 #include <cstring>
 
@@ -373,10 +374,6 @@ static const signed char lfo_pm_table[8 * 8 * 2] = {
 	7, 3, 0,-3,-7,-3, 0, 3  // LFO PM depth = 1
 };
 
-// TODO clean this up
-static int phase_modulation;  // phase modulation input (SLOT 2)
-static int phase_modulation2; // phase modulation input (SLOT 3
-                              // in 4 operator channels)
 
 
 YMF262::Slot::Slot()
@@ -517,23 +514,17 @@ void YMF262::Slot::advancePhaseGenerator(Channel& ch, unsigned lfo_pm)
 	}
 }
 
-// advance to next sample
-void YMF262::advance()
+// advance both slots to the next sample
+inline void YMF262::Channel::advance(unsigned egCnt, unsigned lfo_pm)
 {
-	// Vibrato: 8 output levels (triangle waveform);
-	// 1 level takes 1024 samples
-	lfo_pm_cnt.addQuantum();
-	unsigned lfo_pm = (lfo_pm_cnt.toInt() & 7) | lfo_pm_depth_range;
-
-	++eg_cnt;
-	for (auto& ch : channel) {
-		for (int s = 0; s < 2; ++s) {
-			auto& op = ch.slot[s];
-			op.advanceEnvelopeGenerator(eg_cnt);
-			op.advancePhaseGenerator(ch, lfo_pm);
-		}
+	for (auto& op : slot) {
+		op.advanceEnvelopeGenerator(egCnt);
+		op.advancePhaseGenerator(*this, lfo_pm);
 	}
+}
 
+inline void YMF262::advanceNoise()
+{
 	// The Noise Generator of the YM3812 is 23-bit shift register.
 	// Period is equal to 2^23-2 samples.
 	// Register works at sampling frequency of the chip, so output
@@ -560,6 +551,13 @@ void YMF262::advance()
 }
 
 
+inline bool YMF262::Slot::isSilent() const
+{
+	// op_calc() returns 0 for any phase or lfo_am value, and because the
+	// envelope is off this doesn't change until the next key-on.
+	return (state == EG_OFF) && ((TLL + volume) >= ENV_QUIET);
+}
+
 inline int YMF262::Slot::op_calc(unsigned phase, unsigned lfo_am) const
 {
 	unsigned env = (TLL + volume + (lfo_am & AMmask)) << 4;
@@ -569,7 +567,8 @@ inline int YMF262::Slot::op_calc(unsigned phase, unsigned lfo_am) const
 
 // calculate output of a standard 2 operator channel
 // (or 1st part of a 4-op channel)
-void YMF262::Channel::chan_calc(unsigned lfo_am)
+void YMF262::Channel::chan_calc(
+	unsigned lfo_am, int& phase_modulation, int& phase_modulation2)
 {
 	// !! something is wrong with this, it caused bug
 	// !!    [2823673] moonsound 4 operator FM fail
@@ -608,7 +607,8 @@ void YMF262::Channel::chan_calc(unsigned lfo_am)
 }
 
 // calculate output of a 2nd part of 4-op channel
-void YMF262::Channel::chan_calc_ext(unsigned lfo_am)
+void YMF262::Channel::chan_calc_ext(
+	unsigned lfo_am, int& phase_modulation, int& phase_modulation2)
 {
 	// !! see remark in chan_cal(), something is wrong with this
 	// !! optimization disabled for now
@@ -1459,6 +1459,7 @@ YMF262::YMF262(const std::string& name_,
 	// avoid (harmless) UMR in serialize()
 	memset(chanout, 0, sizeof(chanout));
 	memset(reg, 0, sizeof(reg));
+	phase_modulation = phase_modulation2 = 0;
 
 	init_tables();
 
@@ -1468,6 +1469,8 @@ YMF262::YMF262(const std::string& name_,
 	setInputRate(int(input + 0.5f));
 
 	reset(config.getMotherBoard().getCurrentTime());
+	// When muted, generateChannels() doesn't update the internal state.
+	allowIdle();
 	registerSound(config);
 }
 
@@ -1522,8 +1525,12 @@ void YMF262::generateChannels(int** bufs, unsigned num)
 		return;
 	}
 
-	bool rhythmEnabled = (rhythm & 0x20) != 0;
-
+	// The LFOs are the same for all channels, calculate them upfront. This
+	// allows to calculate the channels one by one (instead of all channels
+	// sample per sample), so that the state of a single channel can stay
+	// in registers and silent channels can be skipped.
+	VLA(unsigned, lfoAm, num);
+	VLA(unsigned, lfoPm, num);
 	for (unsigned j = 0; j < num; ++j) {
 		// Amplitude modulation: 27 output levels (triangle waveform);
 		// 1 level takes one of: 192, 256 or 448 samples
@@ -1534,52 +1541,140 @@ void YMF262::generateChannels(int** bufs, unsigned num)
 			lfo_am_cnt = LFOAMIndex(0);
 		}
 		unsigned tmp = lfo_am_table[lfo_am_cnt.toInt()];
-		unsigned lfo_am = lfo_am_depth ? tmp : tmp / 4;
-
-		// clear channel outputs
-		memset(chanout, 0, sizeof(chanout));
-
-		// channels 0,3 1,4 2,5  9,12 10,13 11,14
-		// in either 2op or 4op mode
-		for (int k = 0; k <= 9; k += 9) {
-			for (int i = 0; i < 3; ++i) {
-				auto& ch0 = channel[k + i + 0];
-				auto& ch3 = channel[k + i + 3];
-				// extended 4op ch#0 part 1 or 2op ch#0
-				ch0.chan_calc(lfo_am);
-				if (ch0.extended) {
-					// extended 4op ch#0 part 2
-					ch3.chan_calc_ext(lfo_am);
-				} else {
-					// standard 2op ch#3
-					ch3.chan_calc(lfo_am);
+		lfoAm[j] = lfo_am_depth ? tmp : tmp / 4;
+
+		// Vibrato: 8 output levels (triangle waveform);
+		// 1 level takes 1024 samples
+		lfo_pm_cnt.addQuantum();
+		lfoPm[j] = (lfo_pm_cnt.toInt() & 7) | lfo_pm_depth_range;
+	}
+
+	// channels 0,3 1,4 2,5  9,12 10,13 11,14
+	// in either 2op or 4op mode
+	for (unsigned k = 0; k <= 9; k += 9) {
+		for (unsigned i = 0; i < 3; ++i) {
+			unsigned ch0 = k + i + 0;
+			unsigned ch3 = k + i + 3;
+			if (channel[ch0].extended) {
+				// extended 4op ch#0 + ch#3
+				calcChannel<true>(ch0, bufs, lfoAm, lfoPm, num);
+			} else {
+				// standard 2op ch#0 and ch#3
+				calcChannel<false>(ch0, bufs, lfoAm, lfoPm, num);
+				calcChannel<false>(ch3, bufs, lfoAm, lfoPm, num);
+			}
+		}
+	}
+
+	// channels 6,7,8 rhythm or 2op mode
+	bool rhythmEnabled = (rhythm & 0x20) != 0;
+	if (!rhythmEnabled) {
+		calcChannel<false>(6, bufs, lfoAm, lfoPm, num);
+		calcChannel<false>(7, bufs, lfoAm, lfoPm, num);
+		calcChannel<false>(8, bufs, lfoAm, lfoPm, num);
+	} else {
+		// Rhythm part (also advances the noise generator)
+		calcRhythm(bufs, lfoAm, lfoPm, num);
+	}
+
+	// channels 15,16,17 are fixed 2-operator channels only
+	calcChannel<false>(15, bufs, lfoAm, lfoPm, num);
+	calcChannel<false>(16, bufs, lfoAm, lfoPm, num);
+	calcChannel<false>(17, bufs, lfoAm, lfoPm, num);
+
+	eg_cnt += num;
+	if (!rhythmEnabled) {
+		for (unsigned j = 0; j < num; ++j) {
+			advanceNoise();
+		}
+	}
+}
+
+// Calculate 'num' samples of a 2op channel, or when EXTENDED is true, of the
+// 4op channel formed by 'chan' and 'chan + 3'.
+template<bool EXTENDED>
+void YMF262::calcChannel(unsigned chan, int** bufs,
+                         const unsigned* lfoAm, const unsigned* lfoPm,
+                         unsigned num)
+{
+	const unsigned chan3 = EXTENDED ? chan + 3 : chan;
+	auto& ch0 = channel[chan];
+	auto& ch3 = channel[chan3];
+
+	if (ch0.slot[MOD].isSilent() && ch0.slot[CAR].isSilent() &&
+	    (!EXTENDED ||
+	     (ch3.slot[MOD].isSilent() && ch3.slot[CAR].isSilent()))) {
+		// The output stays zero, only the phase generators still run
+		// (the envelope generators are off).
+		for (unsigned j = 0; j < num; ++j) {
+			for (auto& op : ch0.slot) {
+				op.advancePhaseGenerator(ch0, lfoPm[j]);
+			}
+			if (EXTENDED) {
+				for (auto& op : ch3.slot) {
+					op.advancePhaseGenerator(ch3, lfoPm[j]);
 				}
 			}
 		}
+		// feedback history, op_calc() returned 0 for all samples
+		auto& mod = ch0.slot[MOD];
+		mod.op1_out[0] = (num == 1) ? mod.op1_out[1] : 0;
+		mod.op1_out[1] = 0;
+		chanout[chan] = chanout[chan3] = 0;
+		bufs[chan] = bufs[chan3] = nullptr;
+		return;
+	}
 
-		// channels 6,7,8 rhythm or 2op mode
-		if (!rhythmEnabled) {
-			channel[6].chan_calc(lfo_am);
-			channel[7].chan_calc(lfo_am);
-			channel[8].chan_calc(lfo_am);
-		} else {
-			// Rhythm part
-			chan_calc_rhythm(lfo_am);
+	int* buf0 = bufs[chan];
+	int* buf3 = bufs[chan3];
+	unsigned panL0 = pan[4 * chan  + 0];
+	unsigned panR0 = pan[4 * chan  + 1];
+	unsigned panL3 = pan[4 * chan3 + 0];
+	unsigned panR3 = pan[4 * chan3 + 1];
+	for (unsigned j = 0; j < num; ++j) {
+		chanout[chan] = chanout[chan3] = 0;
+		// 2op channel or extended 4op ch#0 part 1
+		ch0.chan_calc(lfoAm[j], phase_modulation, phase_modulation2);
+		if (EXTENDED) {
+			// extended 4op ch#0 part 2
+			ch3.chan_calc_ext(lfoAm[j], phase_modulation,
+			                  phase_modulation2);
+		}
+		buf0[2 * j + 0] += chanout[chan] & panL0;
+		buf0[2 * j + 1] += chanout[chan] & panR0;
+		// unused c     += chanout[chan] & pan[4 * chan + 2];
+		// unused d     += chanout[chan] & pan[4 * chan + 3];
+		if (EXTENDED) {
+			buf3[2 * j + 0] += chanout[chan3] & panL3;
+			buf3[2 * j + 1] += chanout[chan3] & panR3;
 		}
 
-		// channels 15,16,17 are fixed 2-operator channels only
-		channel[15].chan_calc(lfo_am);
-		channel[16].chan_calc(lfo_am);
-		channel[17].chan_calc(lfo_am);
+		unsigned egCnt = eg_cnt + j + 1;
+		ch0.advance(egCnt, lfoPm[j]);
+		if (EXTENDED) {
+			ch3.advance(egCnt, lfoPm[j]);
+		}
+	}
+}
 
-		for (int i = 0; i < 18; ++i) {
+// Calculate 'num' samples of the rhythm channels (6, 7 and 8).
+void YMF262::calcRhythm(int** bufs,
+                        const unsigned* lfoAm, const unsigned* lfoPm,
+                        unsigned num)
+{
+	for (unsigned j = 0; j < num; ++j) {
+		chanout[6] = chanout[7] = chanout[8] = 0;
+		chan_calc_rhythm(lfoAm[j]);
+		for (unsigned i = 6; i < 9; ++i) {
 			bufs[i][2 * j + 0] += chanout[i] & pan[4 * i + 0];
 			bufs[i][2 * j + 1] += chanout[i] & pan[4 * i + 1];
-			// unused c        += chanout[i] & pan[4 * i + 2];
-			// unused d        += chanout[i] & pan[4 * i + 3];
 		}
 
-		advance();
+		unsigned egCnt = eg_cnt + j + 1;
+		for (unsigned i = 6; i < 9; ++i) {
+			channel[i].advance(egCnt, lfoPm[j]);
+		}
+		advanceNoise();
 	}
 }
 
@@ -49,6 +49,7 @@ private:
 	public:
 		Slot();
 		inline int op_calc(unsigned phase, unsigned lfo_am) const;
+		inline bool isSilent() const;
 		inline void FM_KEYON(byte key_set);
 		inline void FM_KEYOFF(byte key_clr);
 		inline void advanceEnvelopeGenerator(unsigned eg_cnt);
@@ -113,8 +114,11 @@ private:
 	class Channel {
 	public:
 		Channel();
-		void chan_calc(unsigned lfo_am);
-		void chan_calc_ext(unsigned lfo_am);
+		void chan_calc(unsigned lfo_am,
+		               int& phase_modulation, int& phase_modulation2);
+		void chan_calc_ext(unsigned lfo_am,
+		                   int& phase_modulation, int& phase_modulation2);
+		inline void advance(unsigned egCnt, unsigned lfo_pm);
 
 		template<typename Archive>
 		void serialize(Archive& ar, unsigned version);
@@ -142,6 +146,7 @@ private:
 	// SoundDevice
 	int getAmplificationFactor() const override;
 	void generateChannels(int** bufs, unsigned num) override;
+	friend class YMF262Test; // calls generateChannels()
 
 	void callback(byte flag) override;
 
@@ -150,7 +155,13 @@ private:
 	void setStatus(byte flag);
 	void resetStatus(byte flag);
 	void changeStatusMask(byte flag);
-	void advance();
+	inline void advanceNoise();
+	template<bool EXTENDED>
+	void calcChannel(unsigned chan, int** bufs,
+	                 const unsigned* lfoAm, const unsigned* lfoPm,
+	                 unsigned num);
+	void calcRhythm(int** bufs, const unsigned* lfoAm, const unsigned* lfoPm,
+	                unsigned num);
 
 	inline int genPhaseHighHat();
 	inline int genPhaseSnare();
@@ -190,6 +201,9 @@ private:
 	IRQHelper irq;
 
 	int chanout[18]; // 18 channels
+	int phase_modulation;  // phase modulation input (SLOT 2)
+	int phase_modulation2; // phase modulation input (SLOT 3
+	                       // in 4 operator channels)
 
 	byte reg[512];
 	Channel channel[18];	// OPL3 chips have 18 channels
@@ -0,0 +1,422 @@
+#include "YMF262.hh"
+#include "Reactor.hh"
+#include "MSXMotherBoard.hh"
+#include "HardwareConfig.hh"
+#include "DeviceConfig.hh"
+#include "XMLElement.hh"
+#include "EmuTime.hh"
+#include "StringOp.hh"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace openmsx;
+
+// Plays a few register logs on YMF262 and compares the generated samples
+// against checksums of the output of the original implementation (which
+// calculated all channels together, sample by sample). Each log is played
+// with several chunk sizes, the output may not depend on it. The 'silent'
+// test also checks that channels without sound are skipped.
+
+
+// global vars
+string testName;
+unsigned chunkSize;
+
+
+static const unsigned CHANNELS = 18;
+
+
+struct RegWrite
+{
+	RegWrite(unsigned reg_, byte val_) : reg(reg_), val(val_) {}
+	unsigned reg;
+	byte val;
+};
+using RegWrites = vector<RegWrite>;
+struct LogEvent
+{
+	vector<RegWrite> regWrites;
+	unsigned samples; // number of samples between this and next event
+};
+using Log = vector<LogEvent>;
+using Samples = vector<int>;
+
+struct Expected
+{
+	unsigned channel;
+	uint64_t checksum;
+};
+using ExpectedList = vector<Expected>;
+
+// Per channel: was the channel skipped (reported as silent) in each chunk.
+using SkipLog = vector<vector<bool>>;
+
+
+namespace openmsx {
+class YMF262Test
+{
+public:
+	static void generateChannels(YMF262& ymf, int** bufs, unsigned num)
+	{
+		ymf.generateChannels(bufs, num);
+	}
+};
+}
+
+static void error(const string& message)
+{
+	cout << message << endl;
+}
+
+// 64-bit FNV-1a
+static uint64_t checksum(const Samples& samples)
+{
+	uint64_t result = 14695981039346656037ull;
+	for (int s : samples) {
+		uint32_t v = s;
+		for (int i = 0; i < 4; ++i) {
+			result = (result ^ (v & 0xFF)) * 1099511628211ull;
+			v >>= 8;
+		}
+	}
+	return result;
+}
+
+static SkipLog test(const DeviceConfig& config, const Log& log,
+                    const ExpectedList& expected)
+{
+	cout << " test " << testName << " (chunks of " << chunkSize
+	     << " samples) ..." << endl;
+
+	YMF262 ymf("YMF262", config, false);
+	Samples generatedSamples[CHANNELS];
+	SkipLog skipped(CHANNELS);
+
+	for (auto& l : log) {
+		// write registers
+		for (auto& w : l.regWrites) {
+			ymf.writeReg512(w.reg, w.val, EmuTime::zero);
+		}
+
+		for (unsigned done = 0; done < l.samples; done += chunkSize) {
+			unsigned samples = min(chunkSize, l.samples - done);
+
+			// setup buffers (stereo samples)
+			int* bufs[CHANNELS];
+			unsigned oldSize = generatedSamples[0].size();
+			for (unsigned i = 0; i < CHANNELS; ++i) {
+				generatedSamples[i].resize(oldSize + 2 * samples);
+				bufs[i] = &generatedSamples[i][oldSize];
+			}
+
+			// actually generate samples
+			YMF262Test::generateChannels(ymf, bufs, samples);
+
+			// a skipped channel must leave its buffer untouched
+			for (unsigned i = 0; i < CHANNELS; ++i) {
+				skipped[i].push_back(bufs[i] == nullptr);
+				if (bufs[i]) continue;
+				for (unsigned j = 0; j < 2 * samples; ++j) {
+					assert(generatedSamples[i][oldSize + j] == 0);
+				}
+			}
+		}
+	}
+
+	// verify generated samples, channels not in 'expected' must be silent
+	Samples silence(generatedSamples[0].size());
+	uint64_t silenceChecksum = checksum(silence);
+	for (unsigned i = 0; i < CHANNELS; ++i) {
+		uint64_t exp = silenceChecksum;
+		for (auto& e : expected) {
+			if (e.channel == i) exp = e.checksum;
+		}
+		uint64_t got = checksum(generatedSamples[i]);
+		if (got != exp) {
+			StringOp::Builder msg;
+			msg << "Error in channel " << i << ": wrong data, checksum 0x"
+			    << StringOp::toHexString(unsigned(got >> 32), 8)
+			    << StringOp::toHexString(unsigned(got), 8);
+			error(msg);
+		}
+	}
+	return skipped;
+}
+
+
+static void testMelodic(const DeviceConfig& config)
+{
+	testName = "melodic";
+	Log log;
+	{
+		LogEvent event;
+		event.regWrites.emplace_back(0x105, 0x01); // OPL3 mode
+		event.regWrites.emplace_back(0x0BD, 0xC0); // deep AM and vibrato
+		// channel 0: AM + vibrato on both operators, both speakers
+		event.regWrites.emplace_back(0x020, 0xE1); // AM/VIB/EG/mult
+		event.regWrites.emplace_back(0x023, 0xE1);
+		event.regWrites.emplace_back(0x040, 0x1A); // KSL/TL
+		event.regWrites.emplace_back(0x043, 0x00);
+		event.regWrites.emplace_back(0x060, 0xF4); // AR/DR
+		event.regWrites.emplace_back(0x063, 0xF3);
+		event.regWrites.emplace_back(0x080, 0x35); // SL/RR
+		event.regWrites.emplace_back(0x083, 0x36);
+		event.regWrites.emplace_back(0x0E3, 0x01); // waveform
+		event.regWrites.emplace_back(0x0C0, 0x3E); // pan/FB/connection
+		event.regWrites.emplace_back(0x0A0, 0x98); // frequency
+		event.regWrites.emplace_back(0x0B0, 0x31); // key-on/block/freq
+		// channel 10 (second register bank): left speaker, additive
+		event.regWrites.emplace_back(0x121, 0x22);
+		event.regWrites.emplace_back(0x124, 0x61);
+		event.regWrites.emplace_back(0x141, 0x10);
+		event.regWrites.emplace_back(0x144, 0x05);
+		event.regWrites.emplace_back(0x161, 0xC2);
+		event.regWrites.emplace_back(0x164, 0xA3);
+		event.regWrites.emplace_back(0x181, 0x24);
+		event.regWrites.emplace_back(0x184, 0x15);
+		event.regWrites.emplace_back(0x1E1, 0x06);
+		event.regWrites.emplace_back(0x1C1, 0x11);
+		event.regWrites.emplace_back(0x1A1, 0x45);
+		event.regWrites.emplace_back(0x1B1, 0x2A);
+		event.samples = 4000;
+		log.push_back(event);
+	}
+	{
+		LogEvent event;
+		event.regWrites.emplace_back(0x0A0, 0x20); // change freq
+		event.regWrites.emplace_back(0x0B0, 0x32);
+		event.samples = 3000;
+		log.push_back(event);
+	}
+	{
+		LogEvent event;
+		event.regWrites.emplace_back(0x0B0, 0x12); // key-off
+		event.regWrites.emplace_back(0x1B1, 0x0A);
+		event.samples = 5000;
+		log.push_back(event);
+	}
+	ExpectedList expected = {
+		{  0, 0x3501FE8B659ADD2Dull },
+		{ 10, 0x2AFFD6DCA8FB9498ull },
+	};
+	test(config, log, expected);
+}
+
+static void testRhythm(const DeviceConfig& config)
+{
+	testName = "rhythm";
+	Log log;
+	{
+		LogEvent event;
+		// channel 6: bass drum (both operators)
+		event.regWrites.emplace_back(0x030, 0x01);
+		event.regWrites.emplace_back(0x033, 0x01);
+		event.regWrites.emplace_back(0x050, 0x0A);
+		event.regWrites.emplace_back(0x053, 0x00);
+		event.regWrites.emplace_back(0x070, 0xF8);
+		event.regWrites.emplace_back(0x073, 0xF6);
+		event.regWrites.emplace_back(0x090, 0x47);
+		event.regWrites.emplace_back(0x093, 0x48);
+		event.regWrites.emplace_back(0x0C6, 0x34);
+		event.regWrites.emplace_back(0x0A6, 0x58);
+		event.regWrites.emplace_back(0x0B6, 0x09);
+		// channel 7: high hat (modulator) and snare drum (carrier)
+		event.regWrites.emplace_back(0x031, 0x01);
+		event.regWrites.emplace_back(0x034, 0x01);
+		event.regWrites.emplace_back(0x051, 0x00);
+		event.regWrites.emplace_back(0x054, 0x00);
+		event.regWrites.emplace_back(0x071, 0xF7);
+		event.regWrites.emplace_back(0x074, 0xF7);
+		event.regWrites.emplace_back(0x091, 0x58);
+		event.regWrites.emplace_back(0x094, 0x58);
+		event.regWrites.emplace_back(0x0C7, 0x30);
+		event.regWrites.emplace_back(0x0A7, 0x50);
+		event.regWrites.emplace_back(0x0B7, 0x09);
+		// channel 8: tom-tom (modulator) and top cymbal (carrier)
+		event.regWrites.emplace_back(0x032, 0x05);
+		event.regWrites.emplace_back(0x035, 0x01);
+		event.regWrites.emplace_back(0x052, 0x00);
+		event.regWrites.emplace_back(0x055, 0x00);
+		event.regWrites.emplace_back(0x072, 0xF8);
+		event.regWrites.emplace_back(0x075, 0xF5);
+		event.regWrites.emplace_back(0x092, 0x59);
+		event.regWrites.emplace_back(0x095, 0x55);
+		event.regWrites.emplace_back(0x0C8, 0x30);
+		event.regWrites.emplace_back(0x0A8, 0xC0);
+		event.regWrites.emplace_back(0x0B8, 0x05);
+		// rhythm mode, all drums on
+		event.regWrites.emplace_back(0x0BD, 0x3F);
+		event.samples = 3000;
+		log.push_back(event);
+	}
+	{
+		LogEvent event;
+		event.regWrites.emplace_back(0x0BD, 0x20); // all drums off
+		event.samples = 3000;
+		log.push_back(event);
+	}
+	{
+		LogEvent event;
+		event.regWrites.emplace_back(0x0BD, 0x2A); // snare and cymbal
+		event.samples = 2000;
+		log.push_back(event);
+	}
+	ExpectedList expected = {
+		{ 6, 0xC5463ED2871B8419ull },
+		{ 7, 0xF460D80201439611ull },
+		{ 8, 0x4726C61D36CC12E9ull },
+	};
+	test(config, log, expected);
+}
+
+static void testFourOp(const DeviceConfig& config)
+{
+	testName = "4-op";
+	Log log;
+	{
+		LogEvent event;
+		event.regWrites.emplace_back(0x105, 0x01); // OPL3 mode
+		event.regWrites.emplace_back(0x104, 0x03); // 4op: ch0+3, ch1+4
+		// channel 0+3: FM-FM
+		static const byte ops03[4] = { 0x00, 0x03, 0x08, 0x0B };
+		for (byte op : ops03) {
+			event.regWrites.emplace_back(0x020 + op, 0x01);
+			event.regWrites.emplace_back(0x040 + op, 0x08);
+			event.regWrites.emplace_back(0x060 + op, 0xE4);
+			event.regWrites.emplace_back(0x080 + op, 0x24);
+		}
+		event.regWrites.emplace_back(0x0C0, 0x3A);
+		event.regWrites.emplace_back(0x0C3, 0x30);
+		event.regWrites.emplace_back(0x0A0, 0x6B);
+		event.regWrites.emplace_back(0x0B0, 0x2D);
+		// channel 1+4: AM-AM
+		static const byte ops14[4] = { 0x01, 0x04, 0x09, 0x0C };
+		for (byte op : ops14) {
+			event.regWrites.emplace_back(0x020 + op, 0x42);
+			event.regWrites.emplace_back(0x040 + op, 0x10);
+			event.regWrites.emplace_back(0x060 + op, 0xD3);
+			event.regWrites.emplace_back(0x080 + op, 0x43);
+			event.regWrites.emplace_back(0x0E0 + op, 0x02);
+		}
+		event.regWrites.emplace_back(0x0C1, 0x27);
+		event.regWrites.emplace_back(0x0C4, 0x21);
+		event.regWrites.emplace_back(0x0A1, 0x81);
+		event.regWrites.emplace_back(0x0B1, 0x31);
+		event.samples = 5000;
+		log.push_back(event);
+	}
+	{
+		LogEvent event;
+		event.regWrites.emplace_back(0x0C3, 0x31); // FM-AM
+		event.regWrites.emplace_back(0x0C4, 0x20); // AM-FM
+		event.samples = 3000;
+		log.push_back(event);
+	}
+	{
+		LogEvent event;
+		event.regWrites.emplace_back(0x0B0, 0x0D); // key-off
+		event.regWrites.emplace_back(0x0B1, 0x11);
+		event.samples = 4000;
+		log.push_back(event);
+	}
+	ExpectedList expected = {
+		{ 0, 0xA4CE3D7093189E79ull },
+		{ 1, 0x0ABCBB0CA38FBD6Aull },
+		{ 3, 0xFD54BE9126DF02D1ull },
+		{ 4, 0xEE703636B7A6137Bull },
+	};
+	test(config, log, expected);
+}
+
+static void testSilent(const DeviceConfig& config)
+{
+	testName = "silent";
+	Log log;
+	{
+		LogEvent event;
+		// nothing playing yet
+		event.samples = 500;
+		log.push_back(event);
+	}
+	{
+		LogEvent event;
+		event.regWrites.emplace_back(0x105, 0x01); // OPL3 mode
+		// channel 2: fast attack and release
+		event.regWrites.emplace_back(0x022, 0x01);
+		event.regWrites.emplace_back(0x025, 0x01);
+		event.regWrites.emplace_back(0x042, 0x00);
+		event.regWrites.emplace_back(0x045, 0x00);
+		event.regWrites.emplace_back(0x062, 0xF0);
+		event.regWrites.emplace_back(0x065, 0xF0);
+		event.regWrites.emplace_back(0x082, 0x0F);
+		event.regWrites.emplace_back(0x085, 0x0F);
+		event.regWrites.emplace_back(0x0C2, 0x3E); // with feedback
+		event.regWrites.emplace_back(0x0A2, 0x41);
+		event.regWrites.emplace_back(0x0B2, 0x2D);
+		event.samples = 2000;
+		log.push_back(event);
+	}
+	{
+		LogEvent event;
+		event.regWrites.emplace_back(0x0B2, 0x0D); // key-off
+		event.samples = 3000;
+		log.push_back(event);
+	}
+	{
+		LogEvent event;
+		// key-on again after the channel was skipped
+		event.regWrites.emplace_back(0x0B2, 0x2D);
+		event.samples = 1000;
+		log.push_back(event);
+	}
+	{
+		LogEvent event;
+		event.regWrites.emplace_back(0x0B2, 0x0D); // key-off
+		event.samples = 3000;
+		log.push_back(event);
+	}
+	ExpectedList expected = {
+		{ 2, 0x4CC177DF4A3A807Dull },
+	};
+	SkipLog skipped = test(config, log, expected);
+
+	// all other channels never made a sound, so they're always skipped
+	for (unsigned i = 0; i < CHANNELS; ++i) {
+		if (i == 2) continue;
+		for (bool s : skipped[i]) assert(s);
+	}
+	// while playing channel 2 is calculated, once the release has ended
+	// it's skipped again
+	auto& skip2 = skipped[2];
+	unsigned firstPlaying = (500 + chunkSize - 1) / chunkSize;
+	assert(skip2[0]);
+	assert(!skip2[firstPlaying]);
+	assert(skip2.back());
+}
+
+
+int main()
+{
+	Reactor reactor;
+	reactor.init();
+	MSXMotherBoard motherBoard(reactor);
+	HardwareConfig hwConf(motherBoard, "YMF262Test");
+	XMLElement xml("YMF262");
+	DeviceConfig config(hwConf, xml);
+
+	cout << "Testing YMF262" << endl;
+	for (unsigned size : { 1, 7, 128, 1000, 4096 }) {
+		chunkSize = size;
+		testMelodic(config);
+		testRhythm(config);
+		testFourOp(config);
+		testSilent(config);
+	}
+	cout << endl;
+	return 0;
+}
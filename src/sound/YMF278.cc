@@ -772,6 +772,9 @@ YMF278::YMF278(const std::string& name_, int ramSize_,
 	setInputRate(44100);
 
 	reset(motherBoard.getCurrentTime());
+	// When no slot is active, generateChannels() doesn't update the
+	// internal state.
+	allowIdle();
 	registerSound(config);
 
 	// Volume table, 1 = -0.375dB, 8 = -3dB, 256 = -96dB
@@ -0,0 +1,55 @@
+#include "WorkerThread.hh"
+
+namespace openmsx {
+
+WorkerThread::WorkerThread()
+	: thread(this), busy(false), exitLoop(false)
+{
+	thread.start();
+}
+
+WorkerThread::~WorkerThread()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		tasks.clear();
+		exitLoop = true;
+	}
+	taskCondition.notify_one();
+	thread.join();
+}
+
+void WorkerThread::addTask(std::function<void()> task)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		tasks.push_back(std::move(task));
+	}
+	taskCondition.notify_one();
+}
+
+void WorkerThread::waitIdle()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	idleCondition.wait(lock, [&]() { return tasks.empty() && !busy; });
+}
+
+void WorkerThread::run()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true) {
+		taskCondition.wait(lock, [&]() { return exitLoop || !tasks.empty(); });
+		if (exitLoop) break;
+
+		auto task = std::move(tasks.front());
+		tasks.pop_front();
+		busy = true;
+		lock.unlock();
+		task();
+		lock.lock();
+		busy = false;
+		if (tasks.empty()) idleCondition.notify_all();
+	}
+}
+
+} // namespace openmsx
@@ -0,0 +1,49 @@
+#ifndef WORKERTHREAD_HH
+#define WORKERTHREAD_HH
+
+#include "Thread.hh"
+#include <functional>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+namespace openmsx {
+
+/** Executes tasks (in FIFO order) on a background thread.
+  *
+  * Meant for work that doesn't need to be finished immediately and that
+  * shouldn't delay the emulation thread (e.g. compression). Tasks must not
+  * throw exceptions. Tasks that are still pending when this object is
+  * destroyed are discarded (the task that's currently executing is
+  * finished first).
+  */
+class WorkerThread final : private Runnable
+{
+public:
+	WorkerThread();
+	~WorkerThread();
+
+	/** Queue a task for execution on the worker thread.
+	  */
+	void addTask(std::function<void()> task);
+
+	/** Wait until all queued tasks are finished.
+	  */
+	void waitIdle();
+
+private:
+	// Runnable
+	void run() override;
+
+	Thread thread;
+	std::mutex mutex; // protects all members below
+	std::condition_variable taskCondition; // a task got added or exit
+	std::condition_variable idleCondition; // all tasks are finished
+	std::deque<std::function<void()>> tasks;
+	bool busy;
+	bool exitLoop;
+};
+
+} // namespace openmsx
+
+#endif
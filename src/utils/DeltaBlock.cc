@@ -0,0 +1,275 @@
+#include "DeltaBlock.hh"
+#include "snappy.hh"
+#include "stl.hh"
+#include <algorithm>
+#include <cstring>
+#include <cassert>
+
+using std::vector;
+using std::shared_ptr;
+using std::make_shared;
+
+namespace openmsx {
+
+// A delta is stored as a sequence of
+//    <length of equal run> <length of different run> <new data>
+// triplets. The lengths are stored in a variable-length encoding (7 bits
+// per byte, high bit set means more bytes follow). The last triplet may be
+// truncated when the end of the block is reached.
+
+static void storeUleb(vector<uint8_t>& result, size_t value)
+{
+	while (value >= 0x80) {
+		result.push_back(uint8_t(value | 0x80));
+		value >>= 7;
+	}
+	result.push_back(uint8_t(value));
+}
+
+static size_t loadUleb(const uint8_t*& data)
+{
+	size_t result = 0;
+	unsigned shift = 0;
+	while (true) {
+		uint8_t b = *data++;
+		result |= size_t(b & 0x7F) << shift;
+		if (!(b & 0x80)) return result;
+		shift += 7;
+	}
+}
+
+// Returns the first position (starting at 'pos') where both blocks differ,
+// or 'size' if they are equal till the end.
+static size_t findDifference(const uint8_t* p, const uint8_t* q,
+                             size_t pos, size_t size)
+{
+	// compare one word at a time, this loop dominates the delta calculation
+	while ((size - pos) >= sizeof(uint64_t)) {
+		uint64_t a, b;
+		memcpy(&a, p + pos, sizeof(a));
+		memcpy(&b, q + pos, sizeof(b));
+		if (a != b) break;
+		pos += sizeof(uint64_t);
+	}
+	while ((pos != size) && (p[pos] == q[pos])) ++pos;
+	return pos;
+}
+
+// Returns the end of a run of different bytes that starts at 'pos'. Short
+// runs of equal bytes are included in the different run, because storing
+// them as a separate triplet would take more space than what we gain.
+static size_t findEqualRun(const uint8_t* p, const uint8_t* q,
+                           size_t pos, size_t size)
+{
+	static const size_t MIN_EQUAL_RUN = 8;
+	while (pos != size) {
+		if (p[pos] != q[pos]) {
+			++pos;
+			continue;
+		}
+		size_t n = 1;
+		while ((pos + n != size) && (n < MIN_EQUAL_RUN) &&
+		       (p[pos + n] == q[pos + n])) {
+			++n;
+		}
+		if ((n == MIN_EQUAL_RUN) || (pos + n == size)) return pos;
+		pos += n;
+	}
+	return size;
+}
+
+static vector<uint8_t> calcDelta(const uint8_t* oldBuf, const uint8_t* newBuf,
+                                 size_t size)
+{
+	vector<uint8_t> result;
+	size_t pos = 0;
+	while (true) {
+		size_t diffStart = findDifference(oldBuf, newBuf, pos, size);
+		storeUleb(result, diffStart - pos);
+		if (diffStart == size) break;
+
+		size_t diffEnd = findEqualRun(oldBuf, newBuf, diffStart, size);
+		storeUleb(result, diffEnd - diffStart);
+		result.insert(end(result), newBuf + diffStart, newBuf + diffEnd);
+		if (diffEnd == size) break;
+		pos = diffEnd;
+	}
+	result.shrink_to_fit();
+	return result;
+}
+
+static void applyDeltaInPlace(uint8_t* buf, size_t size, const uint8_t* delta)
+{
+	size_t pos = 0;
+	while (true) {
+		pos += loadUleb(delta);
+		assert(pos <= size);
+		if (pos == size) break;
+
+		size_t len = loadUleb(delta);
+		assert((pos + len) <= size);
+		memcpy(buf + pos, delta, len);
+		delta += len;
+		pos += len;
+		if (pos == size) break;
+	}
+}
+
+
+// class DeltaBlockCopy
+
+DeltaBlockCopy::DeltaBlockCopy(const uint8_t* data, size_t size_)
+	: block(size_)
+	, size(size_)
+	, compressedSize(0)
+{
+	memcpy(block.data(), data, size);
+}
+
+void DeltaBlockCopy::apply(uint8_t* dst, size_t size_) const
+{
+	assert(size_ == size); (void)size_;
+	std::lock_guard<std::mutex> lock(mutex);
+	if (compressed()) {
+		snappy::uncompress(
+			reinterpret_cast<const char*>(block.data()), compressedSize,
+			reinterpret_cast<char*>(dst), size);
+	} else {
+		memcpy(dst, block.data(), size);
+	}
+}
+
+size_t DeltaBlockCopy::getDeltaSize() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return compressed() ? compressedSize : size;
+}
+
+void DeltaBlockCopy::compress()
+{
+	// No need to lock while compressing: the content of the uncompressed
+	// block never changes, it only gets replaced (under the lock) below.
+	// And only one thread ever calls compress() on a given block.
+	assert(!compressed());
+	size_t dstLen = snappy::maxCompressedLength(size);
+	MemBuffer<uint8_t> buf(dstLen);
+	snappy::compress(reinterpret_cast<const char*>(block.data()), size,
+	                 reinterpret_cast<char*>(buf.data()), dstLen);
+	if (dstLen >= size) {
+		// incompressible data, keep the uncompressed copy
+		return;
+	}
+	buf.resize(dstLen); // shrink to actual size
+
+	std::lock_guard<std::mutex> lock(mutex);
+	block.swap(buf);
+	compressedSize = dstLen;
+}
+
+const uint8_t* DeltaBlockCopy::getData() const
+{
+	assert(!compressed());
+	return block.data();
+}
+
+
+// class DeltaBlockDiff
+
+DeltaBlockDiff::DeltaBlockDiff(
+		shared_ptr<DeltaBlockCopy> prev_,
+		const uint8_t* data, size_t size)
+	: prev(std::move(prev_))
+	, delta(calcDelta(prev->getData(), data, size))
+{
+}
+
+void DeltaBlockDiff::apply(uint8_t* dst, size_t size) const
+{
+	prev->apply(dst, size);
+	applyDeltaInPlace(dst, size, delta.data());
+}
+
+size_t DeltaBlockDiff::getDeltaSize() const
+{
+	return delta.size();
+}
+
+bool DeltaBlockDiff::sameDelta(const DeltaBlockDiff& other) const
+{
+	return (prev == other.prev) && (delta == other.delta);
+}
+
+bool DeltaBlockDiff::isEmpty() const
+{
+	// an empty delta consists of a single 'equal run' that spans the
+	// whole block
+	const uint8_t* p = delta.data();
+	loadUleb(p);
+	return p == (delta.data() + delta.size());
+}
+
+
+// class LastDeltaBlocks
+
+shared_ptr<DeltaBlock> LastDeltaBlocks::createNew(
+	const void* id, const uint8_t* data, size_t size)
+{
+	auto it = find_if(begin(infos), end(infos),
+		[&](const Info& info) {
+			return (info.id == id) && (info.size == size); });
+	if (it == end(infos)) {
+		// Drop information about blocks that are no longer referenced
+		// by any snapshot (e.g. belonging to a deleted machine).
+		infos.erase(remove_if(begin(infos), end(infos),
+			[](const Info& info) { return info.ref.expired(); }),
+			end(infos));
+		infos.emplace_back(id, size);
+		it = end(infos) - 1;
+	}
+	Info& info = *it;
+
+	auto ref = info.ref.lock();
+	if (!ref || (info.accSize >= size)) {
+		// No keyframe yet, or the deltas against the current keyframe
+		// became too big: start a new keyframe. The old keyframe is
+		// only still used to reconstruct older snapshots, so it can
+		// now be compressed.
+		if (ref) oldKeyframes.push_back(ref);
+		auto result = make_shared<DeltaBlockCopy>(data, size);
+		info.ref = result;
+		info.last.reset();
+		info.accSize = 0;
+		return result;
+	}
+
+	auto diff = make_shared<DeltaBlockDiff>(ref, data, size);
+	if (diff->isEmpty()) {
+		// unchanged since the keyframe, share the keyframe itself
+		return ref;
+	}
+	auto last = info.last.lock();
+	if (last && last->sameDelta(*diff)) {
+		// unchanged since the previous snapshot, share that delta
+		return last;
+	}
+	info.last = diff;
+	info.accSize += diff->getDeltaSize();
+	return diff;
+}
+
+void LastDeltaBlocks::clear()
+{
+	for (auto& info : infos) {
+		if (!info.ref.expired()) oldKeyframes.push_back(info.ref);
+	}
+	infos.clear();
+}
+
+vector<std::weak_ptr<DeltaBlockCopy>> LastDeltaBlocks::releaseOldKeyframes()
+{
+	vector<std::weak_ptr<DeltaBlockCopy>> result;
+	result.swap(oldKeyframes);
+	return result;
+}
+
+} // namespace openmsx
@@ -0,0 +1,143 @@
+#ifndef DELTABLOCK_HH
+#define DELTABLOCK_HH
+
+#include "MemBuffer.hh"
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+
+namespace openmsx {
+
+/** A block of memory as stored in an in-memory (reverse) snapshot.
+  *
+  * To reduce memory usage, snapshots don't store a full copy of every
+  * (large) memory block (e.g. RAM, VRAM, SRAM). Instead only some snapshots
+  * store a full copy (a 'keyframe'), the other snapshots store the difference
+  * relative to such a keyframe. Blocks that didn't change at all between two
+  * snapshots are shared between those snapshots.
+  */
+class DeltaBlock
+{
+public:
+	virtual ~DeltaBlock() {}
+
+	/** Reconstruct the content of this block in the given buffer.
+	  * @param dst Destination buffer.
+	  * @param size Size of the block, must be the same value as was used
+	  *             to create this block.
+	  */
+	virtual void apply(uint8_t* dst, size_t size) const = 0;
+
+	/** The amount of (heap) memory used by this block.
+	  * Only meant for statistics, not exact.
+	  */
+	virtual size_t getDeltaSize() const = 0;
+
+protected:
+	DeltaBlock() {}
+};
+
+
+/** Full copy of a memory block (a keyframe).
+  */
+class DeltaBlockCopy final : public DeltaBlock
+{
+public:
+	DeltaBlockCopy(const uint8_t* data, size_t size);
+	void apply(uint8_t* dst, size_t size) const override;
+	size_t getDeltaSize() const override;
+
+	/** Compress the stored copy (with snappy). This is done once this
+	  * block is no longer the most recent keyframe (as long as new deltas
+	  * are still calculated against this block we need fast access to
+	  * the uncompressed data).
+	  * This method may be called from a different thread than the other
+	  * methods in this class.
+	  */
+	void compress();
+
+	/** Access the uncompressed data, only allowed before compress().
+	  */
+	const uint8_t* getData() const;
+
+private:
+	bool compressed() const { return compressedSize != 0; }
+
+	mutable std::mutex mutex; // protects 'block' and 'compressedSize'
+	MemBuffer<uint8_t> block;
+	const size_t size;
+	size_t compressedSize;
+};
+
+
+/** Difference of a memory block relative to a keyframe.
+  */
+class DeltaBlockDiff final : public DeltaBlock
+{
+public:
+	DeltaBlockDiff(std::shared_ptr<DeltaBlockCopy> prev,
+	               const uint8_t* data, size_t size);
+	void apply(uint8_t* dst, size_t size) const override;
+	size_t getDeltaSize() const override;
+
+	/** Does this block describe the same changes (relative to the same
+	  * keyframe) as the given other block?
+	  */
+	bool sameDelta(const DeltaBlockDiff& other) const;
+
+	/** Returns true iff the block was identical to its keyframe.
+	  */
+	bool isEmpty() const;
+
+private:
+	const std::shared_ptr<DeltaBlockCopy> prev;
+	const std::vector<uint8_t> delta;
+};
+
+
+/** Keeps track of the most recent keyframe for each memory block that is
+  * (regularly) put in a snapshot. A memory block is identified by its
+  * address and size.
+  */
+class LastDeltaBlocks
+{
+public:
+	/** Create a new DeltaBlock for the given memory block.
+	  * Depending on the amount of changes since the last keyframe for this
+	  * block, this is either a new full copy or a delta. If the block
+	  * didn't change compared to the previous snapshot, the previous
+	  * DeltaBlock is returned again (and thus shared).
+	  */
+	std::shared_ptr<DeltaBlock> createNew(
+		const void* id, const uint8_t* data, size_t size);
+
+	/** Forget all keyframes. Existing snapshots remain valid, but new
+	  * snapshots will no longer calculate deltas against old keyframes.
+	  */
+	void clear();
+
+	/** Returns (and forgets) the keyframes that were replaced by a newer
+	  * keyframe since the previous call. These are no longer used to
+	  * calculate new deltas, so they can be compressed.
+	  */
+	std::vector<std::weak_ptr<DeltaBlockCopy>> releaseOldKeyframes();
+
+private:
+	struct Info {
+		Info(const void* id_, size_t size_)
+			: id(id_), size(size_), accSize(0) {}
+
+		const void* id;
+		size_t size;
+		std::weak_ptr<DeltaBlockCopy> ref;  // last keyframe
+		std::weak_ptr<DeltaBlockDiff> last; // last delta
+		size_t accSize; // total size of deltas against 'ref'
+	};
+	std::vector<Info> infos;
+	std::vector<std::weak_ptr<DeltaBlockCopy>> oldKeyframes;
+};
+
+} // namespace openmsx
+
+#endif
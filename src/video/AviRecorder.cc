@@ -1,5 +1,6 @@
 #include "AviRecorder.hh"
 #include "AviWriter.hh"
+#include "RawVideoWriter.hh"
 #include "WavWriter.hh"
 #include "Reactor.hh"
 #include "MSXMotherBoard.hh"
@@ -34,12 +35,13 @@ AviRecorder::AviRecorder(Reactor& reactor_)
 
 AviRecorder::~AviRecorder()
 {
-	assert(!aviWriter);
+	assert(!videoWriter);
 	assert(!wavWriter);
 }
 
 void AviRecorder::start(bool recordAudio, bool recordVideo, bool recordMono,
-                        bool recordStereo, const Filename& filename)
+                        bool recordStereo, bool recordRaw,
+                        const Filename& filename)
 {
 	stop();
 	MSXMotherBoard* motherBoard = reactor.getMotherBoard();
@@ -81,9 +83,16 @@ void AviRecorder::start(bool recordAudio, bool recordVideo, bool recordMono,
 		prevTime = EmuTime::infinity;
 
 		try {
-			aviWriter = make_unique<AviWriter>(
-				filename, frameWidth, frameHeight, bpp,
-				(recordAudio && stereo) ? 2 : 1, sampleRate);
+			unsigned channels = (recordAudio && stereo) ? 2 : 1;
+			if (recordRaw) {
+				videoWriter = make_unique<RawVideoWriter>(
+					filename, frameWidth, frameHeight, bpp,
+					channels, sampleRate);
+			} else {
+				videoWriter = make_unique<AviWriter>(
+					filename, frameWidth, frameHeight, bpp,
+					channels, sampleRate);
+			}
 		} catch (MSXException& e) {
 			throw CommandException("Can't start recording: " +
 			                       e.getMessage());
@@ -111,7 +120,7 @@ void AviRecorder::stop()
 		mixer = nullptr;
 	}
 	sampleRate = 0;
-	aviWriter.reset();
+	videoWriter.reset();
 	wavWriter.reset();
 }
 
@@ -128,7 +137,7 @@ void AviRecorder::addWave(unsigned num, int16_t* data)
 		if (wavWriter) {
 			wavWriter->write(data, 2, num);
 		} else {
-			assert(aviWriter);
+			assert(videoWriter);
 			audioBuf.insert(end(audioBuf), data, data + 2 * num);
 		}
 	} else {
@@ -153,7 +162,7 @@ void AviRecorder::addWave(unsigned num, int16_t* data)
 		if (wavWriter) {
 			wavWriter->write(buf, 1, num);
 		} else {
-			assert(aviWriter);
+			assert(videoWriter);
 			audioBuf.insert(end(audioBuf), buf, buf + num);
 		}
 	}
@@ -172,14 +181,14 @@ void AviRecorder::addImage(FrameSource* frame, EmuTime::param time)
 		}
 	} else if (prevTime != EmuTime::infinity) {
 		duration = time - prevTime;
-		aviWriter->setFps(1.0 / duration.toDouble());
+		videoWriter->setFps(1.0 / duration.toDouble());
 	}
 	prevTime = time;
 
 	if (mixer) {
 		mixer->updateStream(time);
 	}
-	aviWriter->addFrame(frame, unsigned(audioBuf.size()), audioBuf.data());
+	videoWriter->addFrame(frame, unsigned(audioBuf.size()), audioBuf.data());
 	audioBuf.clear();
 }
 
@@ -197,6 +206,7 @@ void AviRecorder::processStart(array_ref<TclObject> tokens, TclObject& result)
 	bool recordVideo = true;
 	bool recordMono = false;
 	bool recordStereo = false;
+	bool recordRaw = false;
 	frameWidth = 320;
 	frameHeight = 240;
 
@@ -230,6 +240,8 @@ void AviRecorder::processStart(array_ref<TclObject> tokens, TclObject& result)
 			} else if (token == "-triplesize") {
 				frameWidth = 960;
 				frameHeight = 720;
+			} else if (token == "-raw") {
+				recordRaw = true;
 			} else {
 				throw CommandException("Invalid option: " + token);
 			}
@@ -246,6 +258,9 @@ void AviRecorder::processStart(array_ref<TclObject> tokens, TclObject& result)
 	if (!recordAudio && (recordStereo || recordMono)) {
 		throw CommandException("Can't have both -videoonly and -stereo or -mono.");
 	}
+	if (!recordVideo && recordRaw) {
+		throw CommandException("Can't have both -audioonly and -raw.");
+	}
 	switch (arguments.size()) {
 	case 0:
 		// nothing
@@ -258,15 +273,17 @@ void AviRecorder::processStart(array_ref<TclObject> tokens, TclObject& result)
 	}
 
 	string directory = recordVideo ? "videos" : "soundlogs";
-	string extension = recordVideo ? ".avi"   : ".wav";
+	string extension = !recordVideo ? ".wav"
+	                 : recordRaw    ? ".omv"
+	                 :                ".avi";
 	filename = FileOperations::parseCommandFileArgument(
 		filename, directory, prefix, extension);
 
-	if (aviWriter || wavWriter) {
+	if (videoWriter || wavWriter) {
 		result.setString("Already recording.");
 	} else {
 		start(recordAudio, recordVideo, recordMono, recordStereo,
-				Filename(filename));
+		      recordRaw, Filename(filename));
 		result.setString("Recording to " + filename);
 	}
 }
@@ -281,7 +298,7 @@ void AviRecorder::processStop(array_ref<TclObject> tokens)
 
 void AviRecorder::processToggle(array_ref<TclObject> tokens, TclObject& result)
 {
-	if (aviWriter || wavWriter) {
+	if (videoWriter || wavWriter) {
 		// drop extra tokens
 		processStop(make_array_ref(tokens.data(), 2));
 	} else {
@@ -295,7 +312,7 @@ void AviRecorder::status(array_ref<TclObject> tokens, TclObject& result) const
 		throw SyntaxError();
 	}
 	result.addListElement("status");
-	if (aviWriter || wavWriter) {
+	if (videoWriter || wavWriter) {
 		result.addListElement("recording");
 	} else {
 		result.addListElement("idle");
@@ -341,9 +358,12 @@ string AviRecorder::Cmd::help(const vector<string>& /*tokens*/) const
 	       "record status             Query recording state\n"
 	       "\n"
 	       "The start subcommand also accepts an optional -audioonly, -videoonly, "
-	       " -mono, -stereo, -doublesize flag.\n"
+	       " -mono, -stereo, -doublesize, -raw flag.\n"
 	       "Videos are recorded in a 320x240 size by default, at 640x480 when the "
-	       "-doublesize flag is used and at 960x720 when the -triplesize flag is used.";
+	       "-doublesize flag is used and at 960x720 when the -triplesize flag is used.\n"
+	       "With -raw the frames are written (losslessly, only lightly compressed) "
+	       "to a .omv file instead of being encoded as .avi. That's much faster, "
+	       "see Contrib/omv2raw.py to convert it to a regular video later.";
 }
 
 void AviRecorder::Cmd::tabCompletion(vector<string>& tokens) const
@@ -356,7 +376,7 @@ void AviRecorder::Cmd::tabCompletion(vector<string>& tokens) const
 	} else if ((tokens.size() >= 3) && (tokens[1] == "start")) {
 		static const char* const options[] = {
 			"-prefix", "-videoonly", "-audioonly", "-doublesize", "-triplesize",
-			"-mono", "-stereo",
+			"-mono", "-stereo", "-raw",
 		};
 		completeFileName(tokens, userFileContext(), options);
 	}
@@ -11,7 +11,7 @@
 namespace openmsx {
 
 class Reactor;
-class AviWriter;
+class VideoWriter;
 class Wav16Writer;
 class Filename;
 class PostProcessor;
@@ -32,7 +32,7 @@ public:
 
 private:
 	void start(bool recordAudio, bool recordVideo, bool recordMono,
-		   bool recordStereo, const Filename& filename);
+		   bool recordStereo, bool recordRaw, const Filename& filename);
 	void status(array_ref<TclObject> tokens, TclObject& result) const;
 
 	void processStart (array_ref<TclObject> tokens, TclObject& result);
@@ -49,7 +49,7 @@ private:
 	} recordCommand;
 
 	std::vector<int16_t> audioBuf;
-	std::unique_ptr<AviWriter>   aviWriter; // can be nullptr
+	std::unique_ptr<VideoWriter> videoWriter; // can be nullptr
 	std::unique_ptr<Wav16Writer> wavWriter; // can be nullptr
 	std::vector<PostProcessor*> postProcessors;
 	MSXMixer* mixer;
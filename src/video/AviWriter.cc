@@ -39,6 +39,8 @@ AviWriter::AviWriter(const Filename& filename, unsigned width_,
 
 AviWriter::~AviWriter()
 {
+	worker.waitIdle();
+
 	if (written == 0) {
 		// no data written yet (a recording less than one video frame)
 		std::string filename = file.getURL();
@@ -246,12 +248,35 @@ void AviWriter::addAviChunk(const char* tag, unsigned size, void* data, unsigned
 
 void AviWriter::addFrame(FrameSource* frame, unsigned samples, int16_t* sampleData)
 {
+	// Wait till the previous frame is written. So (at most) one frame is
+	// being compressed while the emulation continues.
+	worker.waitIdle();
+	if (!error.empty()) {
+		throw MSXException(error);
+	}
+
 	bool keyFrame = (frames++ % 300 == 0);
+	codec.captureFrame(frame);
+	audioBuf.assign(sampleData, sampleData + samples);
+
+	worker.addTask([this, keyFrame]() {
+		try {
+			writeFrame(keyFrame);
+		} catch (MSXException& e) {
+			error = e.getMessage();
+		}
+	});
+}
+
+void AviWriter::writeFrame(bool keyFrame)
+{
+	// Note: this runs on the worker thread.
 	void* buffer;
 	unsigned size;
-	codec.compressFrame(keyFrame, frame, buffer, size);
+	codec.compressFrame(keyFrame, buffer, size);
 	addAviChunk("00dc", size, buffer, keyFrame ? 0x10 : 0x0);
 
+	unsigned samples = unsigned(audioBuf.size());
 	if (samples) {
 		assert((samples % channels) == 0);
 		assert(audiorate != 0);
@@ -261,11 +286,11 @@ void AviWriter::addFrame(FrameSource* frame, unsigned samples, int16_t* sampleDa
 			//std::vector<Endian::L16> buf(sampleData, sampleData + samples); // needs c++11
 			std::vector<Endian::L16> buf(samples);
 			for (unsigned i = 0; i < samples; ++i) {
-				buf[i] = sampleData[i];
+				buf[i] = audioBuf[i];
 			}
 			addAviChunk("01wb", samples * sizeof(int16_t), buf.data(), 0);
 		} else {
-			addAviChunk("01wb", samples * sizeof(int16_t), sampleData, 0);
+			addAviChunk("01wb", samples * sizeof(int16_t), audioBuf.data(), 0);
 		}
 		audiowritten += samples;
 	}
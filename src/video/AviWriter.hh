@@ -3,10 +3,13 @@
 #ifndef AVIWRITER_HH
 #define AVIWRITER_HH
 
+#include "VideoWriter.hh"
 #include "ZMBVEncoder.hh"
 #include "File.hh"
+#include "WorkerThread.hh"
 #include "endian.hh"
 #include <cstdint>
+#include <string>
 #include <vector>
 #include <memory>
 
@@ -15,16 +18,24 @@ namespace openmsx {
 class Filename;
 class FrameSource;
 
-class AviWriter
+class AviWriter final : public VideoWriter
 {
 public:
 	AviWriter(const Filename& filename, unsigned width, unsigned height,
 	          unsigned bpp, unsigned channels, unsigned freq);
 	~AviWriter();
-	void addFrame(FrameSource* frame, unsigned samples, int16_t* sampleData);
-	void setFps(float fps_) { fps = fps_; }
+
+	/** Add a video frame and the audio samples for that frame. The frame
+	  * is only copied, compressing and writing it to the file happens on
+	  * a background thread. Errors (e.g. disk full) are reported by
+	  * throwing an MSXException from the next call to this method.
+	  */
+	void addFrame(FrameSource* frame, unsigned samples,
+	              int16_t* sampleData) override;
+	void setFps(float fps_) override { fps = fps_; }
 
 private:
+	void writeFrame(bool keyFrame);
 	void addAviChunk(const char* tag, unsigned size, void* data, unsigned flags);
 
 	File file;
@@ -40,6 +51,13 @@ private:
 	unsigned frames;
 	unsigned audiowritten;
 	unsigned written;
+
+	std::vector<int16_t> audioBuf; // audio for the frame being written
+	std::string error; // error message from the worker thread
+
+	// Compresses and writes the frames. Must be destroyed first, it uses
+	// the members above.
+	WorkerThread worker;
 };
 
 } // namespace openmsx
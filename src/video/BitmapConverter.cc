@@ -6,6 +6,10 @@
 #include "components.hh"
 #include <cstdint>
 
+#ifdef __SSE2__
+#include "emmintrin.h" // SSE2
+#endif
+
 namespace openmsx {
 
 template <class Pixel>
@@ -314,12 +318,82 @@ void BitmapConverter<Pixel>::renderGraphic7(
 	}
 }
 
+#ifdef __SSE2__
+// Calculates the (15-bit) YJK color index of 32 pixels (16 bytes from both
+// VRAM planes) at once. Also returns the VRAM bytes in pixel order (only
+// needed for YAE).
+static inline void calcYJK(
+	const byte* __restrict vramPtr0, const byte* __restrict vramPtr1,
+	uint16_t* __restrict col, byte* __restrict data)
+{
+	__m128i in0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(vramPtr0));
+	__m128i in1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(vramPtr1));
+	// Interleaving both planes gives the pixels in the right order:
+	// p[0] p[1] p[2] p[3] of the first group of 4 pixels, and so on.
+	__m128i pix8[2] = { _mm_unpacklo_epi8(in0, in1),
+	                    _mm_unpackhi_epi8(in0, in1) };
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(data +  0), pix8[0]);
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(data + 16), pix8[1]);
+
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i c7   = _mm_set1_epi16(7);
+	const __m128i c31  = _mm_set1_epi16(31);
+	for (int n = 0; n < 4; ++n) {
+		// 8 pixels (2 groups) in 16-bit lanes
+		__m128i p = (n & 1) ? _mm_unpackhi_epi8(pix8[n / 2], zero)
+		                    : _mm_unpacklo_epi8(pix8[n / 2], zero);
+		__m128i y = _mm_srli_epi16(p, 3);
+
+		// In each 32-bit lane combine the lower 3 bits of p[0] and p[1]
+		// (that's k) or of p[2] and p[3] (that's j) to a signed 6-bit
+		// value. Then copy k and j to all 4 pixels of the group.
+		__m128i low = _mm_and_si128(p, c7);
+		__m128i kj = _mm_or_si128(low, _mm_srli_epi32(low, 13));
+		kj = _mm_srai_epi32(_mm_slli_epi32(kj, 26), 26);
+		kj = _mm_packs_epi32(kj, kj);    // k0 j0 k1 j1 k0 j0 k1 j1
+		kj = _mm_unpacklo_epi16(kj, kj); // k0 k0 j0 j0 k1 k1 j1 j1
+		__m128i k = _mm_shuffle_epi32(kj, _MM_SHUFFLE(2, 2, 0, 0));
+		__m128i j = _mm_shuffle_epi32(kj, _MM_SHUFFLE(3, 3, 1, 1));
+
+		// The division by 4 is done with a shift, that rounds negative
+		// values differently, but those are clipped to 0 anyway.
+		__m128i r = _mm_add_epi16(y, j);
+		__m128i g = _mm_add_epi16(y, k);
+		__m128i b = _mm_add_epi16(_mm_slli_epi16(y, 2), y);
+		b = _mm_sub_epi16(b, _mm_add_epi16(_mm_add_epi16(j, j), k));
+		b = _mm_srai_epi16(b, 2);
+		r = _mm_max_epi16(_mm_min_epi16(r, c31), zero);
+		g = _mm_max_epi16(_mm_min_epi16(g, c31), zero);
+		b = _mm_max_epi16(_mm_min_epi16(b, c31), zero);
+		__m128i c = _mm_or_si128(_mm_or_si128(_mm_slli_epi16(r, 10),
+		                                      _mm_slli_epi16(g, 5)),
+		                         b);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(col + 8 * n), c);
+	}
+}
+#endif
+
 template <class Pixel>
 void BitmapConverter<Pixel>::renderYJK(
 	Pixel*      __restrict pixelPtr,
 	const byte* __restrict vramPtr0,
 	const byte* __restrict vramPtr1)
 {
+#ifdef __SSE2__
+	// SSE2 version: calculate the color indices of 32 pixels at once, only
+	// the palette lookups are done per pixel.
+	for (unsigned i = 0; i < 128; i += 16) {
+		uint16_t col[32];
+		byte data[32];
+		calcYJK(vramPtr0 + i, vramPtr1 + i, col, data);
+		for (unsigned n = 0; n < 32; ++n) {
+			pixelPtr[2 * i + n] = palette32768[col[n]];
+		}
+	}
+	return;
+#endif
+
+	// C++ version
 	for (unsigned i = 0; i < 64; ++i) {
 		unsigned p[4];
 		p[0] = vramPtr0[2 * i + 0];
@@ -347,6 +421,22 @@ void BitmapConverter<Pixel>::renderYAE(
 	const byte* __restrict vramPtr0,
 	const byte* __restrict vramPtr1)
 {
+#ifdef __SSE2__
+	// SSE2 version, see renderYJK()
+	for (unsigned i = 0; i < 128; i += 16) {
+		uint16_t col[32];
+		byte data[32];
+		calcYJK(vramPtr0 + i, vramPtr1 + i, col, data);
+		for (unsigned n = 0; n < 32; ++n) {
+			pixelPtr[2 * i + n] = (data[n] & 0x08)
+			                    ? palette16[data[n] >> 4] // YAE
+			                    : palette32768[col[n]];   // YJK
+		}
+	}
+	return;
+#endif
+
+	// C++ version
 	for (unsigned i = 0; i < 64; ++i) {
 		unsigned p[4];
 		p[0] = vramPtr0[2 * i + 0];
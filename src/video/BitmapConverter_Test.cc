@@ -0,0 +1,122 @@
+#include "BitmapConverter.hh"
+#include "Math.hh"
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace openmsx;
+
+// Renders random VRAM contents with BitmapConverter and compares the result
+// against straightforward scalar implementations, pixel-for-pixel. Build once
+// with and once without SSE2 (e.g. add -U__SSE2__) to check both
+// code paths.
+
+static std::mt19937 rng(1234);
+
+template<typename Pixel> struct Palettes
+{
+	Palettes()
+		: palette16(32), palette256(256), palette32768(32768)
+	{
+		for (auto& p : palette16)    p = Pixel(rng());
+		for (auto& p : palette256)   p = Pixel(rng());
+		for (auto& p : palette32768) p = Pixel(rng());
+	}
+	std::vector<Pixel> palette16;
+	std::vector<Pixel> palette256;
+	std::vector<Pixel> palette32768;
+};
+
+template<typename Pixel>
+static Pixel refYJK(const Palettes<Pixel>& pal, const byte* p, int n, bool yae)
+{
+	if (yae && (p[n] & 0x08)) {
+		return pal.palette16[p[n] >> 4];
+	}
+	int j = (p[2] & 7) + ((p[3] & 3) << 3) - ((p[3] & 4) << 3);
+	int k = (p[0] & 7) + ((p[1] & 3) << 3) - ((p[1] & 4) << 3);
+	int y = p[n] >> 3;
+	int r = Math::clip<0, 31>(y + j);
+	int g = Math::clip<0, 31>(y + k);
+	int b = Math::clip<0, 31>((5 * y - 2 * j - k) / 4);
+	return pal.palette32768[(r << 10) + (g << 5) + b];
+}
+
+template<typename Pixel> static void test()
+{
+	Palettes<Pixel> pal;
+	BitmapConverter<Pixel> converter(pal.palette16.data(),
+	                                 pal.palette256.data(),
+	                                 pal.palette32768.data());
+	byte vram0[128];
+	byte vram1[128];
+	alignas(8) Pixel out[512];
+
+	for (int iter = 0; iter < 100; ++iter) {
+		for (auto& v : vram0) v = byte(rng());
+		for (auto& v : vram1) v = byte(rng());
+		if (iter == 0) {
+			// extreme values
+			for (auto& v : vram0) v = 0xFF;
+			for (auto& v : vram1) v = 0x00;
+		}
+
+		// Graphic 4
+		converter.setDisplayMode(DisplayMode(0x06, 0x00, 0x00));
+		converter.convertLine(out, vram0);
+		for (int i = 0; i < 256; ++i) {
+			byte data = vram0[i / 2];
+			int c = (i & 1) ? (data & 15) : (data >> 4);
+			assert(out[i] == pal.palette16[c]);
+		}
+
+		// Graphic 5
+		converter.setDisplayMode(DisplayMode(0x08, 0x00, 0x00));
+		converter.convertLine(out, vram0);
+		for (int i = 0; i < 512; ++i) {
+			byte data = vram0[i / 4];
+			int c = (data >> (6 - 2 * (i & 3))) & 3;
+			assert(out[i] == pal.palette16[c + ((i & 1) ? 16 : 0)]);
+		}
+
+		// Graphic 6
+		converter.setDisplayMode(DisplayMode(0x0A, 0x00, 0x00));
+		converter.convertLinePlanar(out, vram0, vram1);
+		for (int i = 0; i < 512; ++i) {
+			byte data = (i & 2) ? vram1[i / 4] : vram0[i / 4];
+			int c = (i & 1) ? (data & 15) : (data >> 4);
+			assert(out[i] == pal.palette16[c]);
+		}
+
+		// Graphic 7
+		converter.setDisplayMode(DisplayMode(0x0E, 0x00, 0x00));
+		converter.convertLinePlanar(out, vram0, vram1);
+		for (int i = 0; i < 256; ++i) {
+			byte data = (i & 1) ? vram1[i / 2] : vram0[i / 2];
+			assert(out[i] == pal.palette256[data]);
+		}
+
+		// YJK (screen 12) and YAE (screen 11)
+		for (bool yae : { false, true }) {
+			converter.setDisplayMode(DisplayMode(
+				0x0E, 0x00, yae ? 0x18 : 0x08));
+			converter.convertLinePlanar(out, vram0, vram1);
+			for (int i = 0; i < 256; i += 4) {
+				byte p[4] = { vram0[i / 2 + 0], vram1[i / 2 + 0],
+				              vram0[i / 2 + 1], vram1[i / 2 + 1] };
+				for (int n = 0; n < 4; ++n) {
+					assert(out[i + n] == refYJK(pal, p, n, yae));
+				}
+			}
+		}
+	}
+}
+
+int main()
+{
+	test<uint16_t>();
+	test<uint32_t>();
+	std::cout << "All tests passed" << std::endl;
+}
@@ -9,6 +9,9 @@
 #ifdef __SSE2__
 #include <emmintrin.h>
 #endif
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
 namespace openmsx {
 
@@ -73,6 +76,14 @@ DeflickerImpl<Pixel>::DeflickerImpl(const SDL_PixelFormat& format,
 }
 
 #ifdef __SSE2__
+// Per pixel compare, all bits set where x == y.
+template<typename Pixel>
+static inline __m128i isEqual(__m128i x, __m128i y)
+{
+	return (sizeof(Pixel) == 4) ? _mm_cmpeq_epi32(x, y)
+	                            : _mm_cmpeq_epi16(x, y);
+}
+
 template<typename Pixel>
 static inline __m128i blend(__m128i x, __m128i y, Pixel mask)
 {
@@ -90,6 +101,31 @@ static inline __m128i blend(__m128i x, __m128i y, Pixel mask)
 	}
 }
 #endif
+#ifdef __AVX2__
+template<typename Pixel>
+static inline __m256i isEqual(__m256i x, __m256i y)
+{
+	return (sizeof(Pixel) == 4) ? _mm256_cmpeq_epi32(x, y)
+	                            : _mm256_cmpeq_epi16(x, y);
+}
+
+template<typename Pixel>
+static inline __m256i blend(__m256i x, __m256i y, Pixel mask)
+{
+	if (sizeof(Pixel) == 4) {
+		// 32bpp
+		return _mm256_avg_epu8(x, y);
+	} else {
+		// 16bpp,  (x & y) + (((x ^ y) & mask) >> 1)
+		__m256i m = _mm256_set1_epi16(mask);
+		__m256i a = _mm256_and_si256(x, y);
+		__m256i b = _mm256_xor_si256(x, y);
+		__m256i c = _mm256_and_si256(b, m);
+		__m256i d = _mm256_srli_epi16(c, 1);
+		return _mm256_add_epi16(a, d);
+	}
+}
+#endif
 
 template<typename Pixel>
 const void* DeflickerImpl<Pixel>::getLineInfo(
@@ -108,6 +144,14 @@ const void* DeflickerImpl<Pixel>::getLineInfo(
 		width = width0;
 		return line0;
 	}
+	if (lastFrames[0]->isLineUnchanged(line) &&
+	    lastFrames[1]->isLineUnchanged(line) &&
+	    lastFrames[2]->isLineUnchanged(line)) {
+		// Same line in all 4 frames, the result is that same line.
+		// (lastFrames[i + 1] is the frame right before lastFrames[i].)
+		width = width0;
+		return line0;
+	}
 
 	// Prefer to write directly to the output buffer, if that's not
 	// possible store the intermediate result in a temp buffer.
@@ -139,14 +183,36 @@ const void* DeflickerImpl<Pixel>::getLineInfo(
 
 		Pixel mask = pixelOps.getBlendMask();
 		auto x = -ptrdiff_t(numBytes);
-		do {
+#ifdef __AVX2__
+		// Same as the loop below, 32 bytes at a time. The loop below
+		// handles the (possibly) remaining 16 bytes.
+		while (x <= -ptrdiff_t(sizeof(__m256i))) {
+			__m256i a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in0 + x));
+			__m256i a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in1 + x));
+			__m256i a2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in2 + x));
+			__m256i a3 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in3 + x));
+
+			__m256i e02 = isEqual<Pixel>(a0, a2);
+			__m256i e13 = isEqual<Pixel>(a1, a3);
+			__m256i cnd = _mm256_and_si256(e02, e13);
+
+			__m256i a01 = blend(a0, a1, mask);
+			__m256i p = _mm256_xor_si256(a0, a01);
+			__m256i q = _mm256_and_si256(p, cnd);
+			__m256i r = _mm256_xor_si256(q, a0);
+
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x), r);
+			x += sizeof(__m256i);
+		}
+#endif
+		while (x < 0) {
 			__m128i a0 = _mm_load_si128(reinterpret_cast<const __m128i*>(in0 + x));
 			__m128i a1 = _mm_load_si128(reinterpret_cast<const __m128i*>(in1 + x));
 			__m128i a2 = _mm_load_si128(reinterpret_cast<const __m128i*>(in2 + x));
 			__m128i a3 = _mm_load_si128(reinterpret_cast<const __m128i*>(in3 + x));
 
-			__m128i e02 = _mm_cmpeq_epi32(a0, a2); // a0 == a2
-			__m128i e13 = _mm_cmpeq_epi32(a1, a3); // a1 == a3
+			__m128i e02 = isEqual<Pixel>(a0, a2); // a0 == a2
+			__m128i e13 = isEqual<Pixel>(a1, a3); // a1 == a3
 			__m128i cnd = _mm_and_si128(e02, e13); // (a0==a2) && (a1==a3)
 
 			__m128i a01 = blend(a0, a1, mask);
@@ -156,7 +222,7 @@ const void* DeflickerImpl<Pixel>::getLineInfo(
 
 			_mm_store_si128(reinterpret_cast<__m128i*>(dst + x), r);
 			x += sizeof(__m128i);
-		} while (x < 0);
+		}
 		goto end;
 	}
 #endif
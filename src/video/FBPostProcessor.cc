@@ -6,18 +6,23 @@
 #include "Scaler.hh"
 #include "ScalerFactory.hh"
 #include "OutputSurface.hh"
+#include "SDLOffScreenSurface.hh"
+#include "SDLSurfacePtr.hh"
+#include "WorkerThread.hh"
 #include "IntegerSetting.hh"
 #include "FloatSetting.hh"
 #include "BooleanSetting.hh"
 #include "EnumSetting.hh"
 #include "Math.hh"
 #include "aligned.hh"
+#include "memory.hh"
 #include "random.hh"
 #include "xrange.hh"
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <cstddef>
+#include <cstring>
 #ifdef __SSE2__
 #include <emmintrin.h>
 #endif
@@ -240,6 +245,10 @@ FBPostProcessor<Pixel>::FBPostProcessor(MSXMotherBoard& motherBoard_,
 		canDoInterlace_)
 	, noiseShift(screen.getHeight())
 	, pixelOps(screen.getSDLFormat())
+	, readySurface(-1)
+	, busySurface(-1)
+	, frameNum(0)
+	, linesTracked(false)
 {
 	scaleAlgorithm = RenderSettings::NO_SCALER;
 	scaleFactor = unsigned(-1);
@@ -257,18 +266,20 @@ FBPostProcessor<Pixel>::~FBPostProcessor()
 }
 
 template <class Pixel>
-void FBPostProcessor<Pixel>::paint(OutputSurface& output)
+FBPostProcessor<Pixel>::ScaledSurface::ScaledSurface()
+	: frameNum(0)
+	, scaleAlgorithm(RenderSettings::NO_SCALER)
+	, scaleFactor(unsigned(-1))
+	, horStretch(0.0f)
+	, blurFactor(0)
+	, scanlineFactor(0)
+	, valid(false)
 {
-	if (renderSettings.getInterleaveBlackFrame()) {
-		interleaveCount ^= 1;
-		if (interleaveCount) {
-			output.clearScreen();
-			return;
-		}
-	}
-
-	if (!paintFrame) return;
+}
 
+template <class Pixel>
+void FBPostProcessor<Pixel>::updateScaler(OutputSurface& output)
+{
 	// New scaler algorithm selected?
 	auto algo = renderSettings.getScaleAlgorithm();
 	unsigned factor = renderSettings.getScaleFactor();
@@ -278,15 +289,70 @@ void FBPostProcessor<Pixel>::paint(OutputSurface& output)
 		currScaler = ScalerFactory<Pixel>::createScaler(
 			PixelOperations<Pixel>(output.getSDLFormat()),
 			renderSettings);
+		bandScalers.clear();
+		invalidateSurfaces();
+	}
+
+	// Scaler objects have internal state, so each band needs its own.
+	unsigned numBands = currScaler->canScaleInBands()
+	                  ? renderSettings.getScaleThreads() : 1;
+	while (bandScalers.size() < (numBands - 1)) {
+		bandScalers.push_back(ScalerFactory<Pixel>::createScaler(
+			PixelOperations<Pixel>(output.getSDLFormat()),
+			renderSettings));
+	}
+	bandScalers.resize(numBands - 1);
+	while (bandWorkers.size() < bandScalers.size()) {
+		bandWorkers.push_back(make_unique<WorkerThread>());
 	}
+	bandWorkers.resize(bandScalers.size());
+}
 
-	// Scale image.
+template <class Pixel>
+void FBPostProcessor<Pixel>::scaleBand(
+	Scaler<Pixel>& scaler, OutputSurface& output, unsigned inWidth,
+	unsigned srcStartY, unsigned srcEndY, unsigned lineWidth,
+	unsigned dstStartY, unsigned dstEndY)
+{
+	std::unique_ptr<ScalerOutput<Pixel>> dst(
+		StretchScalerOutputFactory<Pixel>::create(
+			output, pixelOps, inWidth));
+	scaler.scaleImage(
+		*paintFrame, superImposeVideoFrame,
+		srcStartY, srcEndY, lineWidth, // source
+		*dst, dstStartY, dstEndY); // dest
+}
+
+template <class Pixel>
+bool FBPostProcessor<Pixel>::isStepChanged(
+	unsigned srcY, unsigned srcStep, uint64_t sinceFrameNum) const
+{
+	// Scalers also look at the neighbouring lines, so include the
+	// previous and next step.
+	unsigned begin = (srcY >= srcStep) ? (srcY - srcStep) : 0;
+	unsigned end = std::min<unsigned>(srcY + 2 * srcStep, lineChange.size());
+	for (unsigned y = begin; y < end; ++y) {
+		if (lineChange[y] > sinceFrameNum) return true;
+	}
+	return false;
+}
+
+template <class Pixel>
+void FBPostProcessor<Pixel>::scaleFrame(
+	OutputSurface& output, float horStretch,
+	bool onlyChanged, uint64_t sinceFrameNum)
+{
+	// Note: this can run on the worker thread, so it should not access
+	// any settings (other than the ones that are explicitly documented
+	// as thread-safe).
 	const unsigned srcHeight = paintFrame->getHeight();
 	const unsigned dstHeight = output.getHeight();
+	assert(!onlyChanged || (lineChange.size() == srcHeight));
 
 	unsigned g = Math::gcd(srcHeight, dstHeight);
 	unsigned srcStep = srcHeight / g;
 	unsigned dstStep = dstHeight / g;
+	unsigned inWidth = unsigned(horStretch + 0.5f);
 
 	// TODO: Store all MSX lines in RawFrame and only scale the ones that fit
 	//       on the PC screen, as a preparation for resizable output window.
@@ -311,20 +377,228 @@ void FBPostProcessor<Pixel>::paint(OutputSurface& output)
 		//fprintf(stderr, "post processing lines %d-%d: %d\n",
 		//	srcStartY, srcEndY, lineWidth );
 		output.lock();
-		float horStretch = renderSettings.getHorizontalStretch();
-		unsigned inWidth = unsigned(horStretch + 0.5f);
-		std::unique_ptr<ScalerOutput<Pixel>> dst(
-			StretchScalerOutputFactory<Pixel>::create(
-				output, pixelOps, inWidth));
-		currScaler->scaleImage(
-			*paintFrame, superImposeVideoFrame,
-			srcStartY, srcEndY, lineWidth, // source
-			*dst, dstStartY, dstEndY); // dest
+		if (!onlyChanged) {
+			scaleRegion(output, inWidth, lineWidth, srcStep, dstStep,
+			            srcStartY, srcEndY, dstStartY, dstEndY);
+		} else {
+			// Only scale the (runs of) steps that changed, the
+			// output already contains the other ones.
+			unsigned sy = srcStartY;
+			unsigned dy = dstStartY;
+			while (sy < srcEndY) {
+				if (!isStepChanged(sy, srcStep, sinceFrameNum)) {
+					sy += srcStep;
+					dy += dstStep;
+					continue;
+				}
+				unsigned sy2 = sy + srcStep;
+				unsigned dy2 = dy + dstStep;
+				while ((sy2 < srcEndY) &&
+				       isStepChanged(sy2, srcStep, sinceFrameNum)) {
+					sy2 += srcStep;
+					dy2 += dstStep;
+				}
+				scaleRegion(output, inWidth, lineWidth,
+				            srcStep, dstStep, sy, sy2, dy, dy2);
+				sy = sy2;
+				dy = dy2;
+			}
+		}
 
 		// next region
 		srcStartY = srcEndY;
 		dstStartY = dstEndY;
 	}
+}
+
+template <class Pixel>
+void FBPostProcessor<Pixel>::scaleRegion(
+	OutputSurface& output, unsigned inWidth,
+	unsigned lineWidth, unsigned srcStep, unsigned dstStep,
+	unsigned srcStartY, unsigned srcEndY,
+	unsigned dstStartY, unsigned dstEndY)
+{
+	// Split the region in bands (at multiples of srcStep/dstStep).
+	// The first band is scaled on this thread, the others (if any) on
+	// the band worker threads.
+	unsigned numSteps = (srcEndY - srcStartY) / srcStep;
+	unsigned numBands = std::min<unsigned>(
+		unsigned(bandScalers.size()) + 1, numSteps);
+	for (unsigned band = numBands; band-- != 0; ) {
+		unsigned begin = (numSteps * (band + 0)) / numBands;
+		unsigned end   = (numSteps * (band + 1)) / numBands;
+		unsigned bandSrcStartY = srcStartY + begin * srcStep;
+		unsigned bandSrcEndY   = srcStartY + end   * srcStep;
+		unsigned bandDstStartY = dstStartY + begin * dstStep;
+		unsigned bandDstEndY   = dstStartY + end   * dstStep;
+		if (band == 0) {
+			scaleBand(*currScaler, output, inWidth,
+			          bandSrcStartY, bandSrcEndY, lineWidth,
+			          bandDstStartY, bandDstEndY);
+		} else {
+			auto& scaler = *bandScalers[band - 1];
+			bandWorkers[band - 1]->addTask([=, &scaler, &output]() {
+				scaleBand(scaler, output, inWidth,
+				          bandSrcStartY, bandSrcEndY, lineWidth,
+				          bandDstStartY, bandDstEndY);
+			});
+		}
+	}
+	for (unsigned band = 1; band < numBands; ++band) {
+		bandWorkers[band - 1]->waitIdle();
+	}
+}
+
+template <class Pixel>
+void FBPostProcessor<Pixel>::allocSurface(ScaledSurface& s)
+{
+	if (s.surface) return;
+	const SDL_PixelFormat& format = screen.getSDLFormat();
+	SDLSurfacePtr prototype(
+		screen.getWidth(), screen.getHeight(),
+		format.BitsPerPixel, format.Rmask, format.Gmask,
+		format.Bmask, format.Amask);
+	s.surface = make_unique<SDLOffScreenSurface>(*prototype);
+}
+
+template <class Pixel>
+bool FBPostProcessor<Pixel>::prepareSurface(
+	ScaledSurface& s, float horStretch, uint64_t& sinceFrameNum)
+{
+	// Must run on the main thread (it reads settings), and before the
+	// scaler is used to (re)scale this surface.
+	int blurFactor = renderSettings.getBlurFactor();
+	int scanlineFactor = renderSettings.getScanlineFactor();
+	bool onlyChanged = s.valid && linesTracked &&
+	                   currScaler->canScaleInBands() &&
+	                   (s.horStretch == horStretch) &&
+	                   (s.blurFactor == blurFactor) &&
+	                   (s.scanlineFactor == scanlineFactor);
+	sinceFrameNum = s.frameNum;
+
+	// Describe the content after the upcoming scale operation.
+	s.frameNum = frameNum;
+	s.scaleAlgorithm = scaleAlgorithm;
+	s.scaleFactor = scaleFactor;
+	s.horStretch = horStretch;
+	s.blurFactor = blurFactor;
+	s.scanlineFactor = scanlineFactor;
+	s.valid = linesTracked;
+	return onlyChanged;
+}
+
+template <class Pixel>
+bool FBPostProcessor<Pixel>::isUpToDate(const ScaledSurface& s) const
+{
+	// Does the surface contain the current frame, scaled with the current
+	// settings? The settings can change while no new frames are produced
+	// (e.g. when paused).
+	return (s.frameNum       == frameNum) &&
+	       (s.scaleAlgorithm == renderSettings.getScaleAlgorithm()) &&
+	       (s.scaleFactor    == unsigned(renderSettings.getScaleFactor())) &&
+	       (s.horStretch     == renderSettings.getHorizontalStretch()) &&
+	       (s.blurFactor     == renderSettings.getBlurFactor()) &&
+	       (s.scanlineFactor == renderSettings.getScanlineFactor());
+}
+
+template <class Pixel>
+void FBPostProcessor<Pixel>::invalidateSurfaces()
+{
+	for (auto& s : workSurfaces) s.valid = false;
+	cacheSurface.valid = false;
+}
+
+template <class Pixel>
+void FBPostProcessor<Pixel>::startThreadedScale()
+{
+	assert(busySurface == -1);
+	if (!worker) worker = make_unique<WorkerThread>();
+
+	// Don't overwrite the surface that's currently being shown.
+	int idx = (readySurface == 0) ? 1 : 0;
+	auto& work = workSurfaces[idx];
+	allocSurface(work);
+
+	// Settings can only be accessed from the main thread.
+	updateScaler(*work.surface);
+	float horStretch = renderSettings.getHorizontalStretch();
+	uint64_t since;
+	bool onlyChanged = prepareSurface(work, horStretch, since);
+
+	busySurface = idx;
+	worker->addTask([this, idx, horStretch, onlyChanged, since]() {
+		scaleFrame(*workSurfaces[idx].surface, horStretch,
+		           onlyChanged, since);
+	});
+}
+
+template <class Pixel>
+void FBPostProcessor<Pixel>::finishThreadedScale()
+{
+	if (busySurface == -1) return;
+	worker->waitIdle();
+	readySurface = busySurface;
+	busySurface = -1;
+}
+
+template <class Pixel>
+static void copySurface(OutputSurface& src, OutputSurface& dst)
+{
+	src.lock();
+	dst.lock();
+	unsigned width = dst.getWidth() * sizeof(Pixel);
+	for (unsigned y = 0; y < dst.getHeight(); ++y) {
+		memcpy(dst.getLinePtrDirect<Pixel>(y),
+		       src.getLinePtrDirect<Pixel>(y), width);
+	}
+}
+
+template <class Pixel>
+void FBPostProcessor<Pixel>::paint(OutputSurface& output)
+{
+	if (renderSettings.getInterleaveBlackFrame()) {
+		interleaveCount ^= 1;
+		if (interleaveCount) {
+			output.clearScreen();
+			return;
+		}
+	}
+
+	if (!paintFrame) return;
+
+	// The worker thread started scaling the current frame in
+	// rotateFrames(), wait till it's done. This also makes sure the
+	// scaler and 'paintFrame' are no longer in use on that thread.
+	finishThreadedScale();
+	if ((readySurface != -1) && !isUpToDate(workSurfaces[readySurface])) {
+		// Settings changed since the frame was scaled (and no new
+		// frame was produced, e.g. paused), scale it again below.
+		readySurface = -1;
+	}
+
+	bool sameSize = (output.getWidth()  == screen.getWidth()) &&
+	                (output.getHeight() == screen.getHeight());
+	if ((readySurface != -1) && sameSize) {
+		// Show the frame that was scaled on the worker thread.
+		copySurface<Pixel>(*workSurfaces[readySurface].surface, output);
+	} else {
+		updateScaler(output);
+		float horStretch = renderSettings.getHorizontalStretch();
+		if (linesTracked && sameSize &&
+		    (lastFrames[0]->getNumChangedLines() < lineChange.size())) {
+			// (Part of) the frame didn't change, only scale the
+			// changed lines to the cache surface.
+			allocSurface(cacheSurface);
+			uint64_t since;
+			bool onlyChanged = prepareSurface(
+				cacheSurface, horStretch, since);
+			scaleFrame(*cacheSurface.surface, horStretch,
+			           onlyChanged, since);
+			copySurface<Pixel>(*cacheSurface.surface, output);
+		} else {
+			scaleFrame(output, horStretch, false, 0);
+		}
+	}
 
 	drawNoise(output);
 
@@ -341,7 +615,45 @@ std::unique_ptr<RawFrame> FBPostProcessor<Pixel>::rotateFrames(
 		noiseShift[y] = distribution(generator) * 16;
 	}
 
-	return PostProcessor::rotateFrames(std::move(finishedFrame), time);
+	// The worker thread (if active) reads from the frames that are about
+	// to be rotated, so first wait till it's finished.
+	finishThreadedScale();
+
+	auto result = PostProcessor::rotateFrames(std::move(finishedFrame), time);
+
+	// Keep track of the lines that changed. This is only possible if
+	// the painted frame is the RawFrame itself (not e.g. deinterlaced).
+	// For laserdisc lastFrames[0] is empty, that frame is returned.
+	++frameNum;
+	linesTracked = canDoInterlace && !superImposeVideoFrame &&
+	               (paintFrame == lastFrames[0].get());
+	if (linesTracked) {
+		auto& frame = *lastFrames[0];
+		unsigned numLines = frame.getHeight();
+		if (lineChange.size() != numLines) {
+			lineChange.assign(numLines, frameNum);
+		} else if (frame.getNumChangedLines() != 0) {
+			for (unsigned y = 0; y < numLines; ++y) {
+				if (!frame.isLineUnchanged(y)) {
+					lineChange[y] = frameNum;
+				}
+			}
+		}
+	} else {
+		// 'lineChange' isn't updated for this frame.
+		invalidateSurfaces();
+	}
+
+	// Superimposed frames and (for laserdisc) the frame that is returned
+	// are modified while the emulation continues, so in those cases we
+	// can only scale synchronously (in paint()).
+	if (renderSettings.getThreadedScaling() && canDoInterlace &&
+	    !superImposeVideoFrame && !superImposeVdpFrame) {
+		startThreadedScale();
+	} else {
+		readySurface = -1;
+	}
+	return result;
 }
 
 
@@ -4,12 +4,15 @@
 #include "PostProcessor.hh"
 #include "RenderSettings.hh"
 #include "PixelOperations.hh"
+#include <cstdint>
 #include <vector>
 
 namespace openmsx {
 
 class MSXMotherBoard;
 class Display;
+class SDLOffScreenSurface;
+class WorkerThread;
 template<typename Pixel> class Scaler;
 
 /** Rasterizer using SDL.
@@ -31,6 +34,43 @@ public:
 		std::unique_ptr<RawFrame> finishedFrame, EmuTime::param time) override;
 
 private:
+	/** An off-screen surface that holds a scaled frame. It remembers how
+	  * that frame was scaled, so that (as long as those parameters don't
+	  * change) only the lines that changed since then need to be scaled
+	  * again.
+	  */
+	struct ScaledSurface {
+		ScaledSurface();
+		std::unique_ptr<SDLOffScreenSurface> surface;
+		uint64_t frameNum; // value of 'frameNum' when it was scaled
+		RenderSettings::ScaleAlgorithm scaleAlgorithm;
+		unsigned scaleFactor;
+		float horStretch;
+		int blurFactor;
+		int scanlineFactor;
+		bool valid; // are the above values meaningful?
+	};
+
+	void updateScaler(OutputSurface& output);
+	void scaleFrame(OutputSurface& output, float horStretch,
+	                bool onlyChanged, uint64_t sinceFrameNum);
+	void scaleRegion(OutputSurface& output, unsigned inWidth,
+	                 unsigned lineWidth, unsigned srcStep, unsigned dstStep,
+	                 unsigned srcStartY, unsigned srcEndY,
+	                 unsigned dstStartY, unsigned dstEndY);
+	void scaleBand(Scaler<Pixel>& scaler, OutputSurface& output,
+	               unsigned inWidth, unsigned srcStartY, unsigned srcEndY,
+	               unsigned lineWidth, unsigned dstStartY, unsigned dstEndY);
+	bool isStepChanged(unsigned srcY, unsigned srcStep,
+	                   uint64_t sinceFrameNum) const;
+	void allocSurface(ScaledSurface& s);
+	bool prepareSurface(ScaledSurface& s, float horStretch,
+	                    uint64_t& sinceFrameNum);
+	bool isUpToDate(const ScaledSurface& s) const;
+	void invalidateSurfaces();
+	void startThreadedScale();
+	void finishThreadedScale();
+
 	void preCalcNoise(float factor);
 	void drawNoise(OutputSurface& output);
 	void drawNoiseLine(Pixel* buf, signed char* noise,
@@ -43,6 +83,12 @@ private:
 	  */
 	std::unique_ptr<Scaler<Pixel>> currScaler;
 
+	/** Additional scalers (same type as currScaler) and threads to scale
+	  * the frame in horizontal bands, see 'scale_threads' setting.
+	  */
+	std::vector<std::unique_ptr<Scaler<Pixel>>> bandScalers;
+	std::vector<std::unique_ptr<WorkerThread>> bandWorkers;
+
 	/** Currently active scale algorithm, used to detect scaler changes.
 	  */
 	RenderSettings::ScaleAlgorithm scaleAlgorithm;
@@ -56,6 +102,35 @@ private:
 	std::vector<unsigned> noiseShift;
 
 	PixelOperations<Pixel> pixelOps;
+
+	/** Used when the 'threaded_scaling' setting is enabled: the frame
+	  * is scaled on the worker thread to one of these surfaces, in
+	  * parallel with the emulation until paint() needs the result.
+	  */
+	ScaledSurface workSurfaces[2];
+	int readySurface; // index in workSurfaces[] or -1
+	int busySurface;  // index in workSurfaces[] or -1
+
+	/** Used when scaling in paint(), only when (part of) the frame
+	  * didn't change. The changed lines are scaled to this surface, and
+	  * then the whole surface is copied to the output.
+	  */
+	ScaledSurface cacheSurface;
+
+	/** For each line of 'paintFrame', the value of 'frameNum' at the
+	  * time that line last changed. Only meaningful when 'linesTracked'
+	  * is true.
+	  */
+	std::vector<uint64_t> lineChange;
+	uint64_t frameNum; // incremented for each new frame
+
+	/** Is 'paintFrame' a plain RawFrame for which the changed lines are
+	  * known (so not e.g. a deinterlaced or superimposed frame)?
+	  */
+	bool linesTracked;
+
+	// Must be destroyed first, it uses the members above.
+	std::unique_ptr<WorkerThread> worker;
 };
 
 } // namespace openmsx
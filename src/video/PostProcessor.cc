@@ -41,8 +41,8 @@ PostProcessor::PostProcessor(MSXMotherBoard& motherBoard_,
 	, lastFramesCount(0)
 	, maxWidth(maxWidth_)
 	, height(height_)
-	, display(display_)
 	, canDoInterlace(canDoInterlace_)
+	, display(display_)
 	, lastRotate(motherBoard_.getCurrentTime())
 	, eventDistributor(motherBoard_.getReactor().getEventDistributor())
 {
@@ -101,6 +101,10 @@ std::unique_ptr<RawFrame> PostProcessor::rotateFrames(
 	}
 	lastRotate = time;
 
+	// Later stages (e.g. Deflicker, FBPostProcessor) can skip the lines
+	// that didn't change since the previous frame.
+	finishedFrame->compareLines(lastFrames[0].get());
+
 	// Figure out how many past frames we want to use.
 	int numRequired = 1;
 	bool doDeinterlace = false;
@@ -143,18 +143,18 @@ protected:
 	int maxWidth; // we lazily create RawFrame objects in lastFrames[]
 	int height;   // these two vars remember how big those should be
 
-private:
-	// Schedulable
-	void executeUntil(EmuTime::param time) override;
-
-	Display& display;
-
 	/** Laserdisc cannot do interlace (better: the current implementation
 	  * is not interlaced). In that case some internal stuff can be done
 	  * with less buffers.
 	  */
 	const bool canDoInterlace;
 
+private:
+	// Schedulable
+	void executeUntil(EmuTime::param time) override;
+
+	Display& display;
+
 	EmuTime lastRotate;
 	EventDistributor& eventDistributor;
 };
@@ -1,5 +1,7 @@
 #include "RawFrame.hh"
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <SDL.h>
 
 namespace openmsx {
@@ -8,6 +10,7 @@ RawFrame::RawFrame(
 		const SDL_PixelFormat& format, unsigned maxWidth_, unsigned height_)
 	: FrameSource(format)
 	, lineWidths(height_)
+	, unchanged(height_)
 	, maxWidth(maxWidth_)
 {
 	setHeight(height_);
@@ -30,6 +33,7 @@ RawFrame::RawFrame(
 			setBlank(line, static_cast<uint32_t>(0));
 		}
 	}
+	compareLines(nullptr);
 }
 
 unsigned RawFrame::getLineWidth(unsigned line) const
@@ -52,6 +56,27 @@ unsigned RawFrame::getRowLength() const
 	return maxWidth; // in pixels (not in bytes)
 }
 
+void RawFrame::compareLines(const RawFrame* prev)
+{
+	unsigned numLines = getHeight();
+	if (!prev || (prev->getHeight() != numLines) || (prev->pitch != pitch)) {
+		std::fill(unchanged.data(), unchanged.data() + numLines, false);
+		numChanged = numLines;
+		return;
+	}
+	unsigned bytesPerPixel = getSDLPixelFormat().BytesPerPixel;
+	numChanged = 0;
+	for (unsigned line = 0; line < numLines; ++line) {
+		unsigned width = lineWidths[line];
+		bool same = (width == prev->lineWidths[line]) &&
+			(memcmp(data.data()       + line * pitch,
+			        prev->data.data() + line * pitch,
+			        width * bytesPerPixel) == 0);
+		unchanged[line] = same;
+		if (!same) ++numChanged;
+	}
+}
+
 bool RawFrame::hasContiguousStorage() const
 {
 	return true;
@@ -52,6 +52,28 @@ public:
 
 	unsigned getRowLength() const override;
 
+	/** Compare each line of this frame with the same line in the given
+	  * frame, which should be the frame that was finished right before
+	  * this one. The result can be queried with isLineUnchanged(). When
+	  * 'prev' is nullptr all lines are marked as changed.
+	  * This should only be called on a completely rendered frame.
+	  */
+	void compareLines(const RawFrame* prev);
+
+	/** Is the given line identical (both width and content) to the same
+	  * line in the previous frame? See compareLines(), the result is
+	  * undefined when the frame was modified after that call.
+	  */
+	bool isLineUnchanged(unsigned line) const {
+		assert(line < getHeight());
+		return unchanged[line];
+	}
+
+	/** Returns the number of lines for which isLineUnchanged() returns
+	  * false.
+	  */
+	unsigned getNumChangedLines() const { return numChanged; }
+
 	// RawFrame is mostly agnostic of the border info struct. The only
 	// thing it does is store the information and give access to it.
 	V9958RasterizerBorderInfo& getBorderInfo() { return borderInfo; }
@@ -66,8 +88,10 @@ protected:
 private:
 	MemBuffer<char, 64> data;
 	MemBuffer<unsigned> lineWidths;
+	MemBuffer<bool> unchanged;
 	unsigned maxWidth;
 	unsigned pitch;
+	unsigned numChanged;
 
 	V9958RasterizerBorderInfo borderInfo;
 };
@@ -0,0 +1,205 @@
+#include "RawVideoWriter.hh"
+#include "FrameSource.hh"
+#include "FileOperations.hh"
+#include "MSXException.hh"
+#include "snappy.hh"
+#include "unreachable.hh"
+#include "build-info.hh"
+#include <SDL.h>
+#include <cassert>
+#include <cstring>
+
+namespace openmsx {
+
+static const unsigned HEADER_SIZE = 64;
+static const unsigned VERSION = 1;
+
+RawVideoWriter::RawVideoWriter(
+		const Filename& filename, unsigned width_, unsigned height_,
+		unsigned bpp, unsigned channels_, unsigned freq_)
+	: file(filename, "wb")
+	, fps(0.0f) // will be filled in later
+	, width(width_)
+	, height(height_)
+	, bytesPerPixel((bpp == 32) ? 4 : 2)
+	, channels(channels_)
+	, audiorate(freq_)
+	, frames(0)
+{
+	masks[0] = masks[1] = masks[2] = 0;
+
+	unsigned frameSize = width * height * bytesPerPixel;
+	frameBuf.resize(frameSize);
+	size_t maxSize = snappy::maxCompressedLength(frameSize);
+	compressBuf.resize(maxSize);
+	memset(compressBuf.data(), 0, maxSize); // also the unused padding bytes
+
+	// The header is written when the recording is stopped.
+	char dummy[HEADER_SIZE];
+	memset(dummy, 0, sizeof(dummy));
+	file.write(dummy, sizeof(dummy));
+}
+
+RawVideoWriter::~RawVideoWriter()
+{
+	worker.waitIdle();
+
+	if (frames == 0) {
+		// no data written yet (a recording less than one video frame)
+		std::string filename = file.getURL();
+		file.close(); // close file (needed for windows?)
+		FileOperations::unlink(filename);
+		return;
+	}
+
+	try {
+		// First add the index to the end, then fill in the header.
+		size_t indexOffset = file.getPos();
+		addChunk("idx ", index.data(),
+		         unsigned(index.size() * sizeof(IndexEntry)));
+		writeHeader();
+		char offset[8];
+		Endian::write_UA_L64(offset, indexOffset);
+		file.seek(56);
+		file.write(offset, sizeof(offset));
+	} catch (MSXException&) {
+		// can't throw from destructor
+	}
+}
+
+void RawVideoWriter::writeHeader()
+{
+	char header[56];
+	memcpy(&header[0], "openMSXv", 8);
+	Endian::write_UA_L32(&header[ 8], VERSION);
+	Endian::write_UA_L32(&header[12], width);
+	Endian::write_UA_L32(&header[16], height);
+	Endian::write_UA_L32(&header[20], bytesPerPixel);
+	Endian::write_UA_L32(&header[24], masks[0]);
+	Endian::write_UA_L32(&header[28], masks[1]);
+	Endian::write_UA_L32(&header[32], masks[2]);
+	Endian::write_UA_L32(&header[36], audiorate ? channels : 0);
+	Endian::write_UA_L32(&header[40], audiorate);
+	Endian::write_UA_L32(&header[44], unsigned(fps * 1000.0f + 0.5f));
+	Endian::write_UA_L32(&header[48], frames);
+	Endian::write_UA_L32(&header[52], 0);
+	file.seek(0);
+	file.write(header, sizeof(header));
+}
+
+template<typename Pixel>
+static const Pixel* getScaledLine(
+	FrameSource* frame, unsigned height, unsigned y, Pixel* buf)
+{
+	switch (height) {
+	case 240:
+		return frame->getLinePtr320_240(y, buf);
+	case 480:
+		return frame->getLinePtr640_480(y, buf);
+	case 720:
+		return frame->getLinePtr960_720(y, buf);
+	default:
+		UNREACHABLE; return nullptr;
+	}
+}
+
+template<typename Pixel>
+void RawVideoWriter::captureFrame(FrameSource* frame)
+{
+	using LE_P = typename Endian::Little<Pixel>::type;
+
+	auto* dest = reinterpret_cast<Pixel*>(frameBuf.data());
+	for (unsigned y = 0; y < height; ++y) {
+		auto* line = getScaledLine(frame, height, y, dest);
+		if (line != dest) memcpy(dest, line, width * sizeof(Pixel));
+		if (OPENMSX_BIGENDIAN) {
+			auto* le = reinterpret_cast<LE_P*>(dest);
+			for (unsigned x = 0; x < width; ++x) {
+				le[x] = dest[x];
+			}
+		}
+		dest += width;
+	}
+}
+
+void RawVideoWriter::addFrame(
+	FrameSource* frame, unsigned samples, int16_t* sampleData)
+{
+	// Wait till the previous frame is written (usually that's already
+	// the case, writing is fast).
+	worker.waitIdle();
+	if (!error.empty()) {
+		throw MSXException(error);
+	}
+
+	if (frames++ == 0) {
+		const SDL_PixelFormat& format = frame->getSDLPixelFormat();
+		masks[0] = format.Rmask;
+		masks[1] = format.Gmask;
+		masks[2] = format.Bmask;
+	}
+	if (bytesPerPixel == 4) {
+#if HAVE_32BPP
+		captureFrame<uint32_t>(frame);
+#endif
+	} else {
+#if HAVE_16BPP
+		captureFrame<uint16_t>(frame);
+#endif
+	}
+	assert((samples % (channels ? channels : 1)) == 0);
+	audioBuf.assign(sampleData, sampleData + samples);
+
+	worker.addTask([this]() {
+		try {
+			writeFrame();
+		} catch (MSXException& e) {
+			error = e.getMessage();
+		}
+	});
+}
+
+void RawVideoWriter::writeFrame()
+{
+	// Note: this runs on the worker thread.
+	size_t size;
+	snappy::compress(frameBuf.data(), width * height * bytesPerPixel,
+	                 compressBuf.data(), size);
+	addChunk("vid ", compressBuf.data(), unsigned(size));
+
+	unsigned samples = unsigned(audioBuf.size());
+	if (samples) {
+		assert(audiorate != 0);
+		if (OPENMSX_BIGENDIAN) {
+			std::vector<Endian::L16> buf(samples);
+			for (unsigned i = 0; i < samples; ++i) {
+				buf[i] = audioBuf[i];
+			}
+			addChunk("aud ", buf.data(), samples * sizeof(int16_t));
+		} else {
+			addChunk("aud ", audioBuf.data(), samples * sizeof(int16_t));
+		}
+	}
+}
+
+void RawVideoWriter::addChunk(const char* tag, const void* data, unsigned size)
+{
+	uint64_t offset = file.getPos();
+	struct {
+		char t[4];
+		Endian::L32 s;
+	} chunk;
+	memcpy(chunk.t, tag, sizeof(chunk.t));
+	chunk.s = size;
+	file.write(&chunk, sizeof(chunk));
+	file.write(data, size);
+
+	IndexEntry entry;
+	memcpy(entry.tag, tag, sizeof(entry.tag));
+	entry.size = size;
+	entry.offsetLow  = uint32_t(offset);
+	entry.offsetHigh = uint32_t(offset >> 32);
+	index.push_back(entry);
+}
+
+} // namespace openmsx
@@ -0,0 +1,98 @@
+#ifndef RAWVIDEOWRITER_HH
+#define RAWVIDEOWRITER_HH
+
+#include "VideoWriter.hh"
+#include "File.hh"
+#include "MemBuffer.hh"
+#include "WorkerThread.hh"
+#include "endian.hh"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace openmsx {
+
+class Filename;
+
+/** Alternative for AviWriter: writes the frames (only compressed with
+  * snappy) and the audio samples to a file. This is much cheaper than
+  * encoding a video while recording, the file can be converted to a real
+  * video format later (e.g. with Contrib/omv2raw.py and ffmpeg).
+  *
+  * File format (all values are little endian):
+  *  header (64 bytes)
+  *     0  char[8]  "openMSXv"
+  *     8  uint32   version (1)
+  *    12  uint32   width
+  *    16  uint32   height
+  *    20  uint32   bytes per pixel (2 or 4)
+  *    24  uint32   red mask
+  *    28  uint32   green mask
+  *    32  uint32   blue mask
+  *    36  uint32   number of audio channels (0 = no audio)
+  *    40  uint32   audio sample rate
+  *    44  uint32   frame rate, in frames per 1000 seconds
+  *    48  uint32   number of video frames
+  *    52  uint32   reserved (0)
+  *    56  uint64   offset of the index
+  *  chunks, each chunk is
+  *     char[4] tag, uint32 size, followed by 'size' bytes of data
+  *   "vid " a frame, compressed with the openMSX variant of snappy (see
+  *          src/utils/snappy.cc), the uncompressed data has 'height'
+  *          lines of 'width' pixels
+  *   "aud " signed 16-bit samples (interleaved when stereo) for the
+  *          preceding video frame
+  *  index (at the end of the file)
+  *   a "idx " chunk containing, per chunk, its tag (char[4]), size
+  *   (uint32) and file offset (uint64)
+  * The header is only completed when the recording is stopped. If
+  * the index offset is 0, the chunks can still be read sequentially.
+  */
+class RawVideoWriter final : public VideoWriter
+{
+public:
+	RawVideoWriter(const Filename& filename, unsigned width, unsigned height,
+	               unsigned bpp, unsigned channels, unsigned freq);
+	~RawVideoWriter();
+
+	void addFrame(FrameSource* frame, unsigned samples,
+	              int16_t* sampleData) override;
+	void setFps(float fps_) override { fps = fps_; }
+
+private:
+	struct IndexEntry {
+		char tag[4];
+		Endian::L32 size;
+		Endian::L32 offsetLow;
+		Endian::L32 offsetHigh;
+	};
+
+	template<typename Pixel> void captureFrame(FrameSource* frame);
+	void writeFrame();
+	void addChunk(const char* tag, const void* data, unsigned size);
+	void writeHeader();
+
+	File file;
+	std::vector<IndexEntry> index;
+	MemBuffer<char, SSE2_ALIGNMENT> frameBuf; // copy of the current frame
+	MemBuffer<char> compressBuf;
+	std::vector<int16_t> audioBuf; // audio for the frame being written
+	std::string error; // error message from the worker thread
+
+	float fps;
+	const unsigned width;
+	const unsigned height;
+	const unsigned bytesPerPixel;
+	const unsigned channels;
+	const unsigned audiorate;
+	uint32_t masks[3]; // red, green, blue, taken from the first frame
+	unsigned frames;
+
+	// Compresses and writes the frames. Must be destroyed first, it uses
+	// the members above.
+	WorkerThread worker;
+};
+
+} // namespace openmsx
+
+#endif
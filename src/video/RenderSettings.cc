@@ -181,11 +181,31 @@ RenderSettings::RenderSettings(CommandController& commandController)
 		"Useful on (100Hz+) lightboost enabled monitors to reduce "
 		"motion blur and double frame artifacts.",
 		false)
+
+	, threadedScalingSetting(commandController,
+		"threaded_scaling",
+		"Perform scaling and post processing on a separate thread, so "
+		"that expensive scale algorithms don't slow down the emulation. "
+		"This adds one frame of display latency.\n"
+		"This setting has no effect when using the SDLGL-PP renderer.",
+		false)
+
+	, scaleThreadsSetting(commandController,
+		"scale_threads",
+		"Number of threads used to scale the frame: the frame is split "
+		"in horizontal bands that are scaled in parallel. Has no effect "
+		"for the MLAA scale algorithm.\n"
+		"This setting has no effect when using the SDLGL-PP renderer.",
+		1, 1, 16)
 {
 	brightnessSetting.attach(*this);
 	contrastSetting  .attach(*this);
 	updateBrightnessAndContrast();
 
+	horizontalBlurSetting.attach(*this);
+	scanlineAlphaSetting .attach(*this);
+	updateBlurAndScanline();
+
 	auto& interp = commandController.getInterpreter();
 	colorMatrixSetting.setChecker([this, &interp](TclObject& newValue) {
 		try {
@@ -228,6 +248,8 @@ RenderSettings::~RenderSettings()
 {
 	brightnessSetting.detach(*this);
 	contrastSetting  .detach(*this);
+	horizontalBlurSetting.detach(*this);
+	scanlineAlphaSetting .detach(*this);
 }
 
 void RenderSettings::update(const Setting& setting)
@@ -236,6 +258,10 @@ void RenderSettings::update(const Setting& setting)
 		updateBrightnessAndContrast();
 	} else if (&setting == &contrastSetting) {
 		updateBrightnessAndContrast();
+	} else if (&setting == &horizontalBlurSetting) {
+		updateBlurAndScanline();
+	} else if (&setting == &scanlineAlphaSetting) {
+		updateBlurAndScanline();
 	} else {
 		UNREACHABLE;
 	}
@@ -249,6 +275,12 @@ void RenderSettings::updateBrightnessAndContrast()
 	brightness = (getBrightness() / 100.0f - 0.5f) * contrast + 0.5f;
 }
 
+void RenderSettings::updateBlurAndScanline()
+{
+	blurFactor = (horizontalBlurSetting.getInt()) * 256 / 100;
+	scanlineFactor = 255 - ((scanlineAlphaSetting.getInt() * 255) / 100);
+}
+
 static float conv2(float x, float gamma)
 {
 	return ::powf(std::min(std::max(0.0f, x), 1.0f), gamma);
@@ -8,6 +8,7 @@
 #include "StringSetting.hh"
 #include "Observer.hh"
 #include "gl_mat.hh"
+#include <atomic>
 
 namespace openmsx {
 
@@ -92,15 +93,13 @@ public:
 	FloatSetting& getNoiseSetting() { return noiseSetting; }
 	float getNoise() const { return noiseSetting.getDouble(); }
 
-	/** The amount of horizontal blur [0..256]. */
-	int getBlurFactor() const {
-		return (horizontalBlurSetting.getInt()) * 256 / 100;
-	}
+	/** The amount of horizontal blur [0..256].
+	  * Can be called from any thread. */
+	int getBlurFactor() const { return blurFactor; }
 
-	/** The alpha value [0..255] of the gap between scanlines. */
-	int getScanlineFactor() const {
-		return 255 - ((scanlineAlphaSetting.getInt() * 255) / 100);
-	}
+	/** The alpha value [0..255] of the gap between scanlines.
+	  * Can be called from any thread. */
+	int getScanlineFactor() const { return scanlineFactor; }
 
 	/** The amount of space [0..1] between scanlines. */
 	float getScanlineGap() const {
@@ -169,6 +168,14 @@ public:
 		return interleaveBlackFrameSetting.getBoolean();
 	}
 
+	/** Number of threads used by the software scalers. */
+	int getScaleThreads() const { return scaleThreadsSetting.getInt(); }
+
+	/** Should scaling and post processing run on a separate thread? */
+	bool getThreadedScaling() const {
+		return threadedScalingSetting.getBoolean();
+	}
+
 	/** Apply brightness, contrast and gamma transformation on the input
 	  * color component. The component is expected to be in the range
 	  * [0.0 .. 1.0] but it's not an error if it lays outside of this range.
@@ -198,6 +205,11 @@ private:
 	  */
 	void updateBrightnessAndContrast();
 
+	/** Sets the "blurFactor" and "scanlineFactor" fields according to
+	  * the setting values.
+	  */
+	void updateBlurAndScanline();
+
 	void parseColorMatrix(Interpreter& interp, const TclObject& value);
 
 	EnumSetting<Accuracy> accuracySetting;
@@ -225,10 +237,18 @@ private:
 	FloatSetting horizontalStretchSetting;
 	FloatSetting pointerHideDelaySetting;
 	BooleanSetting interleaveBlackFrameSetting;
+	BooleanSetting threadedScalingSetting;
+	IntegerSetting scaleThreadsSetting;
 
 	float brightness;
 	float contrast;
 
+	// Derived from the blur and scanline settings. These are read by the
+	// scalers, possibly from a different thread than the one that changes
+	// the settings (see threadedScalingSetting).
+	std::atomic<int> blurFactor;
+	std::atomic<int> scanlineFactor;
+
 	/** Parsed color matrix, kept in sync with colorMatrix setting. */
 	gl::mat3 colorMatrix;
 	/** True iff color matrix is identity matrix. */
@@ -12,8 +12,10 @@ TODO:
 #include "RenderSettings.hh"
 #include "BooleanSetting.hh"
 #include "serialize.hh"
+#include "inline.hh"
 #include <algorithm>
 #include <cassert>
+#include <cstring>
 
 namespace openmsx {
 
@@ -22,9 +24,13 @@ SpriteChecker::SpriteChecker(VDP& vdp_, RenderSettings& renderSettings,
 	: vdp(vdp_), vram(vdp.getVRAM())
 	, limitSpritesSetting(renderSettings.getLimitSpritesSetting())
 	, frameStartTime(time)
+	, patternObserver(*this)
 {
 	vram.spriteAttribTable.setObserver(this);
-	vram.spritePatternTable.setObserver(this);
+	vram.spritePatternTable.setObserver(&patternObserver);
+	cacheEnabled = true;
+	attributeWrites = 0;
+	invalidateCache();
 }
 
 void SpriteChecker::reset(EmuTime::param time)
@@ -34,10 +40,205 @@ void SpriteChecker::reset(EmuTime::param time)
 	collisionY = 0;
 
 	frameStart(time);
+	invalidateCache();
 
 	updateSpritesMethod = &SpriteChecker::updateSprites1;
 }
 
+void SpriteChecker::invalidateCache()
+{
+	// This makes the next updateCache() call recalculate all lines.
+	cacheMode = 0;
+	cacheDirty = true;
+	dirtySprites = 0;
+	for (auto& d : dirtyPatterns) d = 0;
+	anyDirtyPattern = false;
+}
+
+int SpriteChecker::countSprites(int mode, bool planarMode) const
+{
+	// Sprites after the one with the 'end' Y-coordinate are not checked.
+	const byte* yPtr;
+	int stride;
+	if (mode == 1) {
+		yPtr = vram.spriteAttribTable.getReadArea(0, 32 * 4);
+		stride = 4;
+	} else if (planarMode) {
+		const byte* attributePtr1;
+		vram.spriteAttribTable.getReadAreaPlanar(
+			512, 32 * 4, yPtr, attributePtr1);
+		stride = 2;
+	} else {
+		yPtr = vram.spriteAttribTable.getReadArea(512, 32 * 4);
+		stride = 4;
+	}
+	int endY = (mode == 1) ? 208 : 216;
+	int count = 0;
+	while ((count < 32) && (yPtr[stride * count] != endY)) {
+		++count;
+	}
+	return count;
+}
+
+void SpriteChecker::updateCache(int mode, int displayDelta, int size, bool mag,
+                                bool limitSprites)
+{
+	bool planarMode = (mode == 2) && planar;
+	if (!cacheDirty &&
+	    (mode         == cacheMode) &&
+	    (displayDelta == cacheDisplayDelta) &&
+	    (size         == cacheSize) &&
+	    (mag          == cacheMag) &&
+	    (planarMode   == cachePlanar) &&
+	    (limitSprites == cacheLimitSprites)) {
+		if (!dirtySprites && !anyDirtyPattern) return;
+		if (!dirtySprites || (countSprites(mode, planarMode) == numSprites)) {
+			// Invalidate the lines where the changed sprites (and
+			// the sprites with a changed pattern) are visible now.
+			const byte* attributePtr = getAttributes();
+			unsigned patternBits = (size == 16) ? 0xF : 0x1;
+			for (int sprite = 0; sprite < numSprites; ++sprite) {
+				bool changed = (dirtySprites >> sprite) & 1;
+				if (!changed && anyDirtyPattern) {
+					unsigned pattern = attributePtr[4 * sprite + 2] &
+					                   ((size == 16) ? 0xFC : 0xFF);
+					changed = (dirtyPatterns[pattern / 32] >>
+					           (pattern % 32)) & patternBits;
+				}
+				if (changed) {
+					invalidateLines(attributePtr[4 * sprite + 0]);
+				}
+			}
+			dirtySprites = 0;
+			for (auto& d : dirtyPatterns) d = 0;
+			anyDirtyPattern = false;
+			return;
+		}
+		// The number of sprites changed, this affects all lines.
+	}
+	cacheDirty = false;
+	cacheMode = mode;
+	cacheDisplayDelta = displayDelta;
+	cacheSize = size;
+	cacheMag = mag;
+	cachePlanar = planarMode;
+	cacheLimitSprites = limitSprites;
+	dirtySprites = 0;
+	for (auto& d : dirtyPatterns) d = 0;
+	anyDirtyPattern = false;
+
+	invalidateLines(0, 313);
+	numSprites = countSprites(mode, planarMode);
+}
+
+void SpriteChecker::invalidateLines(int begin, int end)
+{
+	// An invalidated line starts without sprites, so (for all lines)
+	// cachedCount[] is the value spriteCount[] must start with.
+	std::fill(lineCached     + begin, lineCached     + end, false);
+	std::fill(cachedCount    + begin, cachedCount    + end, 0);
+	std::fill(overflowSprite + begin, overflowSprite + end, -1);
+}
+
+inline void SpriteChecker::loadCachedLines(int minLine, int maxLine)
+{
+	memcpy(spriteCount + minLine, cachedCount + minLine, maxLine - minLine);
+}
+
+template<bool CACHED>
+inline bool SpriteChecker::nextInvalidLines(int& begin, int& end, int maxLine) const
+{
+	if (!CACHED) {
+		// Without the cache all lines are (re)calculated.
+		begin = end;
+		end = maxLine;
+		return begin != maxLine;
+	}
+	begin = std::find(lineCached + end, lineCached + maxLine, false) - lineCached;
+	if (begin == maxLine) return false;
+	end = std::find(lineCached + begin, lineCached + maxLine, true) - lineCached;
+	return true;
+}
+
+inline void SpriteChecker::storeCachedLines(int minLine, int maxLine)
+{
+	memcpy(cachedCount + minLine, spriteCount + minLine, maxLine - minLine);
+	std::fill(lineCached + minLine, lineCached + maxLine, true);
+}
+
+inline int SpriteChecker::findOverflowSprite(int minLine, int maxLine) const
+{
+	auto it = std::find_if(overflowSprite + minLine, overflowSprite + maxLine,
+	                       [](int8_t s) { return s != -1; });
+	return (it != (overflowSprite + maxLine)) ? *it : -1;
+}
+
+void SpriteChecker::invalidateLines(int y)
+{
+	// A sprite is visible on the lines where
+	//   ((line + displayDelta - y) & 0xFF) < magSize
+	// see checkSprites1().
+	int magSize = (cacheMag + 1) * cacheSize;
+	int first = (y - cacheDisplayDelta) & 0xFF;
+	for (int start = first - 256; start < 313; start += 256) {
+		int begin = std::max(start, 0);
+		int end = std::min(start + magSize, 313);
+		if (begin < end) invalidateLines(begin, end);
+	}
+}
+
+NEVER_INLINE void SpriteChecker::updateAttribute(unsigned offset)
+{
+	// Nothing to do when all lines get recalculated anyway, see
+	// updateVRAM().
+	assert(!cacheDirty);
+	if (cachePlanar) {
+		cacheDirty = true;
+		return;
+	}
+
+	// In sprite mode 2 the attribute table window also contains the
+	// color table (16 bytes per sprite) in front of the attributes.
+	unsigned sprite;
+	bool isY;
+	if (cacheMode == 1) {
+		sprite = offset / 4;
+		isY = (offset % 4) == 0;
+	} else if (offset < 512) {
+		sprite = offset / 16;
+		isY = false;
+	} else {
+		sprite = (offset - 512) / 4;
+		isY = (offset % 4) == 0;
+	}
+	if (sprite >= unsigned(numSprites)) {
+		// Sprites after the 'end' sprite are not checked, but changing
+		// the Y-coordinate of the 'end' sprite itself matters.
+		if ((sprite == unsigned(numSprites)) && isY) cacheDirty = true;
+		return;
+	}
+
+	// On the first change, VRAM still contains the position the sprite
+	// had when the lines were checked. The position after the change(s)
+	// is handled in updateCache().
+	uint32_t bit = 1u << sprite;
+	if (dirtySprites & bit) return;
+	dirtySprites |= bit;
+	invalidateLines(getAttributes()[4 * sprite + 0]);
+}
+
+void SpriteChecker::updatePattern(unsigned offset)
+{
+	if (cacheDirty) return;
+	if (cachePlanar) {
+		cacheDirty = true;
+		return;
+	}
+	unsigned pattern = (offset / 8) & 0xFF;
+	dirtyPatterns[pattern / 32] |= 1u << (pattern % 32);
+	anyDirtyPattern = true;
+}
+
 static inline SpriteChecker::SpritePattern doublePattern(SpriteChecker::SpritePattern a)
 {
 	// bit-pattern "abcd...." gets expanded to "aabbccdd"
@@ -95,6 +296,17 @@ void SpriteChecker::updateSprites1(int limit)
 	currentLine = limit;
 }
 
+inline void SpriteChecker::checkSprites1(int minLine, int maxLine)
+{
+	// See frameStart() about when the line cache is used.
+	if (cacheEnabled) {
+		checkSprites1<true>(minLine, maxLine);
+	} else {
+		checkSprites1<false>(minLine, maxLine);
+	}
+}
+
+template<bool CACHED>
 inline void SpriteChecker::checkSprites1(int minLine, int maxLine)
 {
 	// This implementation contains a double for-loop. The outer loop goes
@@ -128,57 +340,82 @@ inline void SpriteChecker::checkSprites1(int minLine, int maxLine)
 	int fifthSpriteNum  = -1;  // no 5th sprite detected yet
 	int fifthSpriteLine = 999; // larger than any possible valid line
 
-	int sprite = 0;
-	for (/**/; sprite < 32; ++sprite) {
-		int y = attributePtr[4 * sprite + 0];
-		if (y == 208) break;
-
-		for (int line = minLine; line < maxLine; ++line) {
-			// Calculate line number within the sprite.
-			int displayLine = line + displayDelta;
-			int spriteLine = (displayLine - y) & 0xFF;
-			if (spriteLine >= magSize) {
-				// Skip ahead till sprite becomes visible.
-				line += 256 - spriteLine - 1; // -1 because of for-loop
-				continue;
-			}
+	// Lines that didn't change since they were last checked (usually in
+	// the previous frame) are taken from the cache, only the other lines
+	// are (re)calculated.
+	if (CACHED) {
+		updateCache(1, displayDelta, size, mag, limitSprites);
+		loadCachedLines(minLine, maxLine);
+	}
 
-			int visibleIndex = spriteCount[line];
-			if (visibleIndex == 4) {
-				// Find earliest line where this condition occurs.
-				if (line < fifthSpriteLine) {
-					fifthSpriteLine = line;
-					fifthSpriteNum = sprite;
+	for (int begin, end = minLine;
+	     nextInvalidLines<CACHED>(begin, end, maxLine); /**/) {
+		int sprite = 0;
+		for (/**/; sprite < 32; ++sprite) {
+			int y = attributePtr[4 * sprite + 0];
+			if (y == 208) break;
+
+			for (int line = begin; line < end; ++line) {
+				// Calculate line number within the sprite.
+				int displayLine = line + displayDelta;
+				int spriteLine = (displayLine - y) & 0xFF;
+				if (spriteLine >= magSize) {
+					// Skip ahead till sprite becomes visible.
+					line += 256 - spriteLine - 1; // -1 because of for-loop
+					continue;
 				}
-				if (limitSprites) continue;
-			}
 
-			SpriteInfo& sip = spriteBuffer[line][visibleIndex];
-			int patternIndex = attributePtr[4 * sprite + 2] & patternIndexMask;
-			if (mag) spriteLine /= 2;
-			sip.pattern = calculatePatternNP(patternIndex, spriteLine);
-			sip.x = attributePtr[4 * sprite + 1];
-			byte colorAttrib = attributePtr[4 * sprite + 3];
-			if (colorAttrib & 0x80) sip.x -= 32;
-			sip.colorAttrib = colorAttrib;
+				int visibleIndex = spriteCount[line];
+				if (visibleIndex == 4) {
+					if (CACHED) {
+						if (overflowSprite[line] == -1) {
+							overflowSprite[line] = sprite;
+						}
+					} else if (line < fifthSpriteLine) {
+						// Find earliest line where this
+						// condition occurs.
+						fifthSpriteLine = line;
+						fifthSpriteNum = sprite;
+					}
+					if (limitSprites) continue;
+				}
+
+				SpriteInfo& sip = spriteBuffer[line][visibleIndex];
+				int patternIndex = attributePtr[4 * sprite + 2] & patternIndexMask;
+				if (mag) spriteLine /= 2;
+				sip.pattern = calculatePatternNP(patternIndex, spriteLine);
+				sip.x = attributePtr[4 * sprite + 1];
+				byte colorAttrib = attributePtr[4 * sprite + 3];
+				if (colorAttrib & 0x80) sip.x -= 32;
+				sip.colorAttrib = colorAttrib;
 
-			spriteCount[line] = visibleIndex + 1;
+				spriteCount[line] = visibleIndex + 1;
+			}
 		}
+		// Without the cache there's only one range (all lines), in
+		// which all sprites were counted.
+		if (!CACHED) numSprites = sprite;
 	}
+	if (CACHED) storeCachedLines(minLine, maxLine);
 
 	// Update status register.
 	byte status = vdp.getStatusReg0();
-	if (fifthSpriteNum != -1) {
-		// Five sprites on a line.
-		// According to TMS9918.pdf 5th sprite detection is only
-		// active when F flag is zero.
-		if ((status & 0xC0) == 0) {
+	// According to TMS9918.pdf 5th sprite detection is only
+	// active when F flag is zero.
+	if ((status & 0xC0) == 0) {
+		if (CACHED) {
+			// Find earliest line where the 5th sprite condition
+			// occurs, this includes the cached lines.
+			fifthSpriteNum = findOverflowSprite(minLine, maxLine);
+		}
+		if (fifthSpriteNum != -1) {
+			// Five sprites on a line.
 			status = 0x40 | (status & 0x20) | fifthSpriteNum;
 		}
 	}
 	if (~status & 0x40) {
 		// No 5th sprite detected, store number of latest sprite processed.
-		status = (status & 0x20) | std::min(sprite, 31);
+		status = (status & 0x20) | std::min(numSprites, 31);
 	}
 	vdp.setSpriteStatus(status);
 
@@ -265,6 +502,17 @@ void SpriteChecker::updateSprites2(int limit)
 	currentLine = limit;
 }
 
+inline void SpriteChecker::checkSprites2(int minLine, int maxLine)
+{
+	// See frameStart() about when the line cache is used.
+	if (cacheEnabled) {
+		checkSprites2<true>(minLine, maxLine);
+	} else {
+		checkSprites2<false>(minLine, maxLine);
+	}
+}
+
+template<bool CACHED>
 inline void SpriteChecker::checkSprites2(int minLine, int maxLine)
 {
 	// See comment in checkSprites1() about order of inner and outer loops.
@@ -280,133 +528,161 @@ inline void SpriteChecker::checkSprites2(int minLine, int maxLine)
 	bool mag = vdp.isSpriteMag();
 	int magSize = (mag + 1) * size;
 	int patternIndexMask = (size == 16) ? 0xFC : 0xFF;
+
 	int ninthSpriteNum  = -1;  // no 9th sprite detected yet
 	int ninthSpriteLine = 999; // larger than any possible valid line
 
+	// See checkSprites1() about the line cache.
+	if (CACHED) {
+		updateCache(2, displayDelta, size, mag, limitSprites);
+		loadCachedLines(minLine, maxLine);
+	}
+
 	// Because it gave a measurable performance boost, we duplicated the
 	// code for planar and non-planar modes.
-	int sprite = 0;
-	if (planar) {
-		const byte* attributePtr0;
-		const byte* attributePtr1;
-		vram.spriteAttribTable.getReadAreaPlanar(
-			512, 32 * 4, attributePtr0, attributePtr1);
-		// TODO: Verify CC implementation.
-		for (/**/; sprite < 32; ++sprite) {
-			int y = attributePtr0[2 * sprite + 0];
-			if (y == 216) break;
-
-			for (int line = minLine; line < maxLine; ++line) {
-				// Calculate line number within the sprite.
-				int displayLine = line + displayDelta;
-				int spriteLine = (displayLine - y) & 0xFF;
-				if (spriteLine >= magSize) {
-					// Skip ahead till sprite is visible.
-					line += 256 - spriteLine - 1;
-					continue;
-				}
-
-				int visibleIndex = spriteCount[line];
-				if (visibleIndex == 8) {
-					// Find earliest line where this condition occurs.
-					if (line < ninthSpriteLine) {
-						ninthSpriteLine = line;
-						ninthSpriteNum = sprite;
+	for (int begin, end = minLine;
+	     nextInvalidLines<CACHED>(begin, end, maxLine); /**/) {
+		int sprite = 0;
+		if (planar) {
+			const byte* attributePtr0;
+			const byte* attributePtr1;
+			vram.spriteAttribTable.getReadAreaPlanar(
+				512, 32 * 4, attributePtr0, attributePtr1);
+			// TODO: Verify CC implementation.
+			for (/**/; sprite < 32; ++sprite) {
+				int y = attributePtr0[2 * sprite + 0];
+				if (y == 216) break;
+
+				for (int line = begin; line < end; ++line) {
+					// Calculate line number within the sprite.
+					int displayLine = line + displayDelta;
+					int spriteLine = (displayLine - y) & 0xFF;
+					if (spriteLine >= magSize) {
+						// Skip ahead till sprite is visible.
+						line += 256 - spriteLine - 1;
+						continue;
 					}
-					if (limitSprites) continue;
-				}
-
-				if (mag) spriteLine /= 2;
-				int colorIndex = (~0u << 10) | (sprite * 16 + spriteLine);
-				byte colorAttrib =
-					vram.spriteAttribTable.readPlanar(colorIndex);
-				// Sprites with CC=1 are only visible if preceded by
-				// a sprite with CC=0.
-				if ((colorAttrib & 0x40) && visibleIndex == 0) continue;
 
-				SpriteInfo& sip = spriteBuffer[line][visibleIndex];
-				int patternIndex = attributePtr0[2 * sprite + 1] & patternIndexMask;
-				sip.pattern = calculatePatternPlanar(patternIndex, spriteLine);
-				sip.x = attributePtr1[2 * sprite + 0];
-				if (colorAttrib & 0x80) sip.x -= 32;
-				sip.colorAttrib = colorAttrib;
-
-				// set sentinel (see below)
-				spriteBuffer[line][visibleIndex + 1].colorAttrib = 0;
-				spriteCount[line] = visibleIndex + 1;
-			}
-		}
-	} else {
-		const byte* attributePtr0 =
-			vram.spriteAttribTable.getReadArea(512, 32 * 4);
-		// TODO: Verify CC implementation.
-		for (/**/; sprite < 32; ++sprite) {
-			int y = attributePtr0[4 * sprite + 0];
-			if (y == 216) break;
+					int visibleIndex = spriteCount[line];
+					if (visibleIndex == 8) {
+						if (CACHED) {
+							if (overflowSprite[line] == -1) {
+								overflowSprite[line] = sprite;
+							}
+						} else if (line < ninthSpriteLine) {
+							// Find earliest line where this
+							// condition occurs.
+							ninthSpriteLine = line;
+							ninthSpriteNum = sprite;
+						}
+						if (limitSprites) continue;
+					}
 
-			for (int line = minLine; line < maxLine; ++line) {
-				// Calculate line number within the sprite.
-				int displayLine = line + displayDelta;
-				int spriteLine = (displayLine - y) & 0xFF;
-				if (spriteLine >= magSize) {
-					// Skip ahead till sprite is visible.
-					line += 256 - spriteLine - 1;
-					continue;
+					if (mag) spriteLine /= 2;
+					int colorIndex = (~0u << 10) | (sprite * 16 + spriteLine);
+					byte colorAttrib =
+						vram.spriteAttribTable.readPlanar(colorIndex);
+					// Sprites with CC=1 are only visible if preceded by
+					// a sprite with CC=0.
+					if ((colorAttrib & 0x40) && visibleIndex == 0) continue;
+
+					SpriteInfo& sip = spriteBuffer[line][visibleIndex];
+					int patternIndex = attributePtr0[2 * sprite + 1] & patternIndexMask;
+					sip.pattern = calculatePatternPlanar(patternIndex, spriteLine);
+					sip.x = attributePtr1[2 * sprite + 0];
+					if (colorAttrib & 0x80) sip.x -= 32;
+					sip.colorAttrib = colorAttrib;
+
+					// set sentinel (see below)
+					spriteBuffer[line][visibleIndex + 1].colorAttrib = 0;
+					spriteCount[line] = visibleIndex + 1;
 				}
-
-				int visibleIndex = spriteCount[line];
-				if (visibleIndex == 8) {
-					// Find earliest line where this condition occurs.
-					if (line < ninthSpriteLine) {
-						ninthSpriteLine = line;
-						ninthSpriteNum = sprite;
+			}
+		} else {
+			const byte* attributePtr0 =
+				vram.spriteAttribTable.getReadArea(512, 32 * 4);
+			// TODO: Verify CC implementation.
+			for (/**/; sprite < 32; ++sprite) {
+				int y = attributePtr0[4 * sprite + 0];
+				if (y == 216) break;
+
+				for (int line = begin; line < end; ++line) {
+					// Calculate line number within the sprite.
+					int displayLine = line + displayDelta;
+					int spriteLine = (displayLine - y) & 0xFF;
+					if (spriteLine >= magSize) {
+						// Skip ahead till sprite is visible.
+						line += 256 - spriteLine - 1;
+						continue;
 					}
-					if (limitSprites) continue;
-				}
-
-				if (mag) spriteLine /= 2;
-				int colorIndex = (~0u << 10) | (sprite * 16 + spriteLine);
-				byte colorAttrib =
-					vram.spriteAttribTable.readNP(colorIndex);
-				// Sprites with CC=1 are only visible if preceded by
-				// a sprite with CC=0.
-				if ((colorAttrib & 0x40) && visibleIndex == 0) continue;
 
-				SpriteInfo& sip = spriteBuffer[line][visibleIndex];
-				int patternIndex = attributePtr0[4 * sprite + 2] & patternIndexMask;
-				sip.pattern = calculatePatternNP(patternIndex, spriteLine);
-				sip.x = attributePtr0[4 * sprite + 1];
-				if (colorAttrib & 0x80) sip.x -= 32;
-				sip.colorAttrib = colorAttrib;
+					int visibleIndex = spriteCount[line];
+					if (visibleIndex == 8) {
+						if (CACHED) {
+							if (overflowSprite[line] == -1) {
+								overflowSprite[line] = sprite;
+							}
+						} else if (line < ninthSpriteLine) {
+							// Find earliest line where this
+							// condition occurs.
+							ninthSpriteLine = line;
+							ninthSpriteNum = sprite;
+						}
+						if (limitSprites) continue;
+					}
 
-				// Set sentinel. Sentinel is actually only
-				// needed for sprites with CC=1.
-				// In the past we set the sentinel (for all
-				// lines) at the end. But it's slightly faster
-				// to do it only for lines that actually
-				// contain sprites (even if sentinel gets
-				// overwritten a couple of times for lines with
-				// many sprites).
-				spriteBuffer[line][visibleIndex + 1].colorAttrib = 0;
-				spriteCount[line] = visibleIndex + 1;
+					if (mag) spriteLine /= 2;
+					int colorIndex = (~0u << 10) | (sprite * 16 + spriteLine);
+					byte colorAttrib =
+						vram.spriteAttribTable.readNP(colorIndex);
+					// Sprites with CC=1 are only visible if preceded by
+					// a sprite with CC=0.
+					if ((colorAttrib & 0x40) && visibleIndex == 0) continue;
+
+					SpriteInfo& sip = spriteBuffer[line][visibleIndex];
+					int patternIndex = attributePtr0[4 * sprite + 2] & patternIndexMask;
+					sip.pattern = calculatePatternNP(patternIndex, spriteLine);
+					sip.x = attributePtr0[4 * sprite + 1];
+					if (colorAttrib & 0x80) sip.x -= 32;
+					sip.colorAttrib = colorAttrib;
+
+					// Set sentinel. Sentinel is actually only
+					// needed for sprites with CC=1.
+					// In the past we set the sentinel (for all
+					// lines) at the end. But it's slightly faster
+					// to do it only for lines that actually
+					// contain sprites (even if sentinel gets
+					// overwritten a couple of times for lines with
+					// many sprites).
+					spriteBuffer[line][visibleIndex + 1].colorAttrib = 0;
+					spriteCount[line] = visibleIndex + 1;
+				}
 			}
 		}
+		// See checkSprites1().
+		if (!CACHED) numSprites = sprite;
 	}
+	if (CACHED) storeCachedLines(minLine, maxLine);
 
 	// Update status register.
 	byte status = vdp.getStatusReg0();
-	if (ninthSpriteNum != -1) {
-		// Nine sprites on a line.
-		// According to TMS9918.pdf 5th sprite detection is only
-		// active when F flag is zero. Stuck to this for V9938.
-		// Dragon Quest 2 needs this.
-		if ((status & 0xC0) == 0) {
+	// According to TMS9918.pdf 5th sprite detection is only
+	// active when F flag is zero. Stuck to this for V9938.
+	// Dragon Quest 2 needs this.
+	if ((status & 0xC0) == 0) {
+		if (CACHED) {
+			// Find earliest line where the 9th sprite condition
+			// occurs, this includes the cached lines.
+			ninthSpriteNum = findOverflowSprite(minLine, maxLine);
+		}
+		if (ninthSpriteNum != -1) {
+			// Nine sprites on a line.
 			status = 0x40 | (status & 0x20) | ninthSpriteNum;
 		}
 	}
 	if (~status & 0x40) {
 		// No 9th sprite detected, store number of latest sprite processed.
-		status = (status & 0x20) | std::min(sprite, 31);
+		status = (status & 0x20) | std::min(numSprites, 31);
 	}
 	vdp.setSpriteStatus(status);
 
@@ -501,6 +777,7 @@ void SpriteChecker::serialize(Archive& ar, unsigned version)
 		// first (partial) frame after loadstate.
 		for (auto& c : spriteCount) c = 0;
 		// content of spriteBuffer[] doesn't matter if spriteCount[] is 0
+		invalidateCache();
 	}
 	ar.serialize("collisionX", collisionX);
 	ar.serialize("collisionY", collisionY);
@@ -200,6 +200,19 @@ public:
 		currentLine = 0;
 		for (auto& c : spriteCount) c = 0;
 		// TODO: Reset anything else? Does the real VDP?
+
+		// When (almost) all sprites change every frame, all lines must
+		// be recalculated anyway and maintaining the line cache is pure
+		// overhead. So only use it when the previous frame had few
+		// writes to the sprite attribute table.
+		bool enable = attributeWrites <= MAX_CACHED_WRITES;
+		if (enable != cacheEnabled) {
+			// Recalculate all lines once the cache is enabled again,
+			// till then VRAM writes don't need to be tracked.
+			cacheEnabled = enable;
+			cacheDirty = true;
+		}
+		attributeWrites = 0;
 	}
 
 	/** Signals the end of the current frame.
@@ -235,20 +248,50 @@ public:
 		return spriteCount[line];
 	}
 
+	/** Informs the sprite checker that the VRAM contents were rearranged
+	  * without going through the VRAM windows (see
+	  * VDPVRAM::updateVRMode() and VDPVRAM::change4k8kMapping()).
+	  */
+	inline void updateVRAMMapping() {
+		cacheDirty = true;
+	}
+
 	// VRAMObserver implementation:
 
-	void updateVRAM(unsigned /*offset*/, EmuTime::param time) override {
+	void updateVRAM(unsigned offset, EmuTime::param time) override {
 		checkUntil(time);
+		++attributeWrites;
+		if (!cacheDirty) updateAttribute(offset);
 	}
 
 	void updateWindow(bool /*enabled*/, EmuTime::param time) override {
 		sync(time);
+		cacheDirty = true;
 	}
 
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
 
 private:
+	/** Observes the sprite pattern table (the SpriteChecker itself
+	  * observes the sprite attribute table).
+	  */
+	class PatternObserver final : public VRAMObserver
+	{
+	public:
+		explicit PatternObserver(SpriteChecker& checker_)
+			: checker(checker_) {}
+		void updateVRAM(unsigned offset, EmuTime::param time) override {
+			checker.checkUntil(time);
+			checker.updatePattern(offset);
+		}
+		void updateWindow(bool enabled, EmuTime::param time) override {
+			checker.updateWindow(enabled, time);
+		}
+	private:
+		SpriteChecker& checker;
+	};
+
 	/** Calculate 'updateSpritesMethod' and 'planar'.
 	  */
 	inline void setDisplayMode(DisplayMode mode) {
@@ -300,6 +343,7 @@ private:
 	  * @effect Fills in the spriteBuffer and spriteCount arrays.
 	  */
 	inline void checkSprites1(int minLine, int maxLine);
+	template<bool CACHED> inline void checkSprites1(int minLine, int maxLine);
 
 	/** Check sprite collision and number of sprites per line.
 	  * This routine implements sprite mode 2 (MSX2).
@@ -312,6 +356,78 @@ private:
 	  * @effect Fills in the spriteBuffer and spriteCount arrays.
 	  */
 	inline void checkSprites2(int minLine, int maxLine);
+	template<bool CACHED> inline void checkSprites2(int minLine, int maxLine);
+
+	/** Brings the line cache up to date: the lines where a changed sprite
+	  * (or a sprite using a changed pattern) is visible now are marked for
+	  * recalculation. When the VDP settings or the number of sprites
+	  * changed since the cached lines were checked, all lines are marked.
+	  * @param mode The current sprite mode (1 or 2).
+	  * @param displayDelta Difference between display and check line.
+	  * @param size The current sprite size (8 or 16).
+	  * @param mag Are sprites magnified?
+	  * @param limitSprites Is the number of sprites per line limited?
+	  */
+	void updateCache(int mode, int displayDelta, int size, bool mag,
+	                 bool limitSprites);
+
+	/** Mark all lines for recalculation.
+	  */
+	void invalidateCache();
+
+	/** Count the sprites before the one with the 'end' Y-coordinate.
+	  */
+	int countSprites(int mode, bool planarMode) const;
+
+	/** Get the (non-planar) sprite attribute table in the cached mode.
+	  */
+	const byte* getAttributes() const {
+		return vram.spriteAttribTable.getReadArea(
+			(cacheMode == 1) ? 0 : 512, 32 * 4);
+	}
+
+	/** Called right before a byte in the sprite attribute table (which
+	  * in sprite mode 2 includes the sprite color table) changes. Marks
+	  * the lines where the corresponding sprite is visible for
+	  * recalculation. Only called while not all lines are marked already.
+	  */
+	void updateAttribute(unsigned offset);
+
+	/** Called right before a byte in the sprite pattern table changes.
+	  */
+	void updatePattern(unsigned offset);
+
+	/** Mark the lines where a sprite with the given Y-coordinate is
+	  * visible (with the cached settings) for recalculation.
+	  */
+	void invalidateLines(int y);
+
+	/** Mark the lines in the range [begin, end) for recalculation.
+	  */
+	void invalidateLines(int begin, int end);
+
+	/** Initialize spriteCount[] for the given lines from the cache.
+	  */
+	inline void loadCachedLines(int minLine, int maxLine);
+
+	/** Find the next range of lines that must be recalculated.
+	  * @param begin Output: first line of the range.
+	  * @param end Input: line to start searching at,
+	  *            output: end (exclusive) of the range.
+	  * @param maxLine Search up to (but not including) this line.
+	  * @return False iff there are no more such lines.
+	  */
+	template<bool CACHED>
+	inline bool nextInvalidLines(int& begin, int& end, int maxLine) const;
+
+	/** Store the (recalculated) given lines in the cache.
+	  */
+	inline void storeCachedLines(int minLine, int maxLine);
+
+	/** Get the first sprite that exceeded the per-line limit on the given
+	  * lines (looking at the lines top to bottom), or -1.
+	  */
+	inline int findOverflowSprite(int minLine, int maxLine) const;
 
 	using UpdateSpritesMethod = void (SpriteChecker::*)(int limit);
 	UpdateSpritesMethod updateSpritesMethod;
@@ -368,6 +484,73 @@ private:
 	  * TODO: Introduce separate update methods for planar/nonplanar modes.
 	  */
 	bool planar;
+
+	PatternObserver patternObserver;
+
+	// Line cache:
+	// Often the sprite tables don't change (much) from one frame to the
+	// next. Then the result of checking a line in the previous frame can
+	// be reused. A VRAM write to the sprite tables only invalidates the
+	// lines where the affected sprites were or are visible. A change of
+	// the relevant VDP settings invalidates all lines. In planar modes
+	// any write invalidates all lines.
+
+	/** Number of sprites before the sprite with the 'end' Y-coordinate
+	  * (208 or 216), or 32 if there is no such sprite.
+	  */
+	int numSprites;
+
+	/** The settings the cached lines were checked with, if any of these
+	  * change all lines must be recalculated.
+	  */
+	int cacheMode; // 0 means there is no valid cache
+	int cacheDisplayDelta;
+	int cacheSize;
+	bool cacheMag;
+	bool cachePlanar;
+	bool cacheLimitSprites;
+
+	/** Must all lines be recalculated on the next check?
+	  */
+	bool cacheDirty;
+
+	/** Is the line cache used in the current frame? If not, all lines
+	  * are calculated and the cache isn't maintained.
+	  */
+	bool cacheEnabled;
+
+	/** Number of writes to the sprite attribute table window (in sprite
+	  * mode 2 this includes the color table) in the current frame.
+	  */
+	unsigned attributeWrites;
+	static const unsigned MAX_CACHED_WRITES = 32;
+
+	/** Sprites of which an attribute or color changed since the last
+	  * check (one bit per sprite). The lines where these sprites were
+	  * visible are already invalidated, the lines where they are visible
+	  * now are invalidated on the next check.
+	  */
+	uint32_t dirtySprites;
+
+	/** Patterns that changed since the last check (one bit per pattern).
+	  */
+	uint32_t dirtyPatterns[256 / 32];
+	bool anyDirtyPattern;
+
+	/** Is the result of the last check of a line still valid?
+	  */
+	bool lineCached[313];
+
+	/** The number of visible sprites on each line, as it was calculated by
+	  * the last check of that line. spriteBuffer[] still contains these
+	  * sprites (spriteCount[] is cleared at the start of each frame).
+	  */
+	uint8_t cachedCount[313];
+
+	/** Per line, the first sprite that didn't fit on that line (number
+	  * of sprites per line limit exceeded), or -1.
+	  */
+	int8_t overflowSprite[313];
 };
 SERIALIZE_CLASS_VERSION(SpriteChecker, 2);
 
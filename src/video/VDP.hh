@@ -578,8 +578,14 @@ private:
 	};
 
 	struct SyncBase : public Schedulable {
-		explicit SyncBase(VDP& vdp_) : Schedulable(vdp_.getScheduler()) {}
+		explicit SyncBase(VDP& vdp_)
+			: Schedulable(vdp_.getScheduler()), device(vdp_) {}
+		std::string getStatsDeviceName() const override {
+			return device.getName();
+		}
 		friend class VDP;
+	private:
+		const VDP& device;
 	};
 
 	struct SyncVSync : public SyncBase {
@@ -0,0 +1,36 @@
+#ifndef VIDEOWRITER_HH
+#define VIDEOWRITER_HH
+
+#include <cstdint>
+
+namespace openmsx {
+
+class FrameSource;
+
+/** Interface for classes that write a video (plus audio) stream to a file,
+  * see AviRecorder.
+  */
+class VideoWriter
+{
+public:
+	virtual ~VideoWriter() {}
+
+	/** Add a video frame and the audio samples for that frame.
+	  * @throws MSXException on write errors (possibly only on a later
+	  *         call, when the actual writing is done asynchronously)
+	  */
+	virtual void addFrame(FrameSource* frame, unsigned samples,
+	                      int16_t* sampleData) = 0;
+
+	/** Set the frame rate, called (once) after the first frames are
+	  * added.
+	  */
+	virtual void setFps(float fps) = 0;
+
+protected:
+	VideoWriter() {}
+};
+
+} // namespace openmsx
+
+#endif
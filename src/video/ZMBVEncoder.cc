@@ -3,14 +3,17 @@
 #include "ZMBVEncoder.hh"
 #include "FrameSource.hh"
 #include "PixelOperations.hh"
+#include "WorkerThread.hh"
 #include "unreachable.hh"
 #include "endian.hh"
+#include "memory.hh"
 #include <algorithm>
 #include <iterator>
 #include <cassert>
 #include <cstdlib>
 #include <cstring>
 #include <cmath>
+#include <thread>
 
 namespace openmsx {
 
@@ -120,9 +123,18 @@ static void createVectorTable()
 ZMBVEncoder::ZMBVEncoder(unsigned width_, unsigned height_, unsigned bpp)
 	: width(width_)
 	, height(height_)
+	, capturedFormat()
 {
 	setupBuffers(bpp);
 	createVectorTable();
+
+	// Use all cores for the motion search (but not more than 8, then
+	// the ranges of block rows become too small).
+	unsigned numThreads = std::min(
+		std::max(std::thread::hardware_concurrency(), 1u), 8u);
+	for (unsigned i = 1; i < numThreads; ++i) {
+		searchWorkers.push_back(make_unique<WorkerThread>());
+	}
 	memset(&zstream, 0, sizeof(zstream));
 	deflateInit(&zstream, 6); // compression level
 
@@ -147,6 +159,7 @@ ZMBVEncoder::ZMBVEncoder(unsigned width_, unsigned height_, unsigned bpp)
 
 ZMBVEncoder::~ZMBVEncoder()
 {
+	deflateEnd(&zstream);
 }
 
 void ZMBVEncoder::setupBuffers(unsigned bpp)
@@ -174,8 +187,10 @@ void ZMBVEncoder::setupBuffers(unsigned bpp)
 
 	oldframe.resize(bufsize);
 	newframe.resize(bufsize);
+	nextframe.resize(bufsize);
 	memset(oldframe.data(), 0, bufsize);
 	memset(newframe.data(), 0, bufsize);
+	memset(nextframe.data(), 0, bufsize);
 	work.resize(bufsize);
 	outputSize = neededSize();
 	output.resize(outputSize);
@@ -185,6 +200,7 @@ void ZMBVEncoder::setupBuffers(unsigned bpp)
 	unsigned xblocks = width / BLOCK_WIDTH;
 	unsigned yblocks = height / BLOCK_HEIGHT;
 	blockOffsets.resize(xblocks * yblocks);
+	blockVectors.resize(xblocks * yblocks);
 	for (unsigned y = 0; y < yblocks; ++y) {
 		for (unsigned x = 0; x < xblocks; ++x) {
 			blockOffsets[y * xblocks + x] =
@@ -252,6 +268,42 @@ void ZMBVEncoder::addXorBlock(
 	}
 }
 
+template<class P>
+void ZMBVEncoder::searchVectors(unsigned firstRow, unsigned lastRow)
+{
+	// The search starts over at the beginning of each row, so the result
+	// doesn't depend on how the rows are divided over the threads.
+	unsigned xblocks = width / BLOCK_WIDTH;
+	for (unsigned row = firstRow; row < lastRow; ++row) {
+		int bestvx = 0;
+		int bestvy = 0;
+		for (unsigned b = row * xblocks; b < (row + 1) * xblocks; ++b) {
+			unsigned offset = blockOffsets[b];
+			// first try best vector of previous block
+			unsigned bestchange = compareBlock<P>(bestvx, bestvy, offset);
+			if (bestchange >= 4) {
+				int possibles = 64;
+				for (auto& v : vectorTable) {
+					if (possibleBlock<P>(v.x, v.y, offset) < 4) {
+						unsigned testchange = compareBlock<P>(v.x, v.y, offset);
+						if (testchange < bestchange) {
+							bestchange = testchange;
+							bestvx = v.x;
+							bestvy = v.y;
+							if (bestchange < 4) break;
+						}
+						--possibles;
+						if (possibles == 0) break;
+					}
+				}
+			}
+			blockVectors[b].x = bestvx;
+			blockVectors[b].y = bestvy;
+			blockVectors[b].changed = bestchange != 0;
+		}
+	}
+}
+
 template<class P>
 void ZMBVEncoder::addXorFrame(const SDL_PixelFormat& pixelFormat, unsigned& workUsed)
 {
@@ -265,33 +317,33 @@ void ZMBVEncoder::addXorFrame(const SDL_PixelFormat& pixelFormat, unsigned& work
 	// Align the following xor data on 4 byte boundary
 	workUsed = (workUsed + blockcount * 2 + 3) & ~3;
 
-	int bestvx = 0;
-	int bestvy = 0;
-	for (unsigned b = 0; b < blockcount; ++b) {
-		unsigned offset = blockOffsets[b];
-		// first try best vector of previous block
-		unsigned bestchange = compareBlock<P>(bestvx, bestvy, offset);
-		if (bestchange >= 4) {
-			int possibles = 64;
-			for (auto& v : vectorTable) {
-				if (possibleBlock<P>(v.x, v.y, offset) < 4) {
-					unsigned testchange = compareBlock<P>(v.x, v.y, offset);
-					if (testchange < bestchange) {
-						bestchange = testchange;
-						bestvx = v.x;
-						bestvy = v.y;
-						if (bestchange < 4) break;
-					}
-					--possibles;
-					if (possibles == 0) break;
-				}
-			}
+	// Motion search: divide the block rows over this thread and the
+	// helper threads.
+	unsigned numTasks = std::min<unsigned>(
+		unsigned(searchWorkers.size()) + 1, yblocks);
+	for (unsigned t = numTasks; t-- != 0; ) {
+		unsigned firstRow = (yblocks * (t + 0)) / numTasks;
+		unsigned lastRow  = (yblocks * (t + 1)) / numTasks;
+		if (t == 0) {
+			searchVectors<P>(firstRow, lastRow);
+		} else {
+			searchWorkers[t - 1]->addTask([this, firstRow, lastRow]() {
+				searchVectors<P>(firstRow, lastRow);
+			});
 		}
-		vectors[b * 2 + 0] = (bestvx << 1);
-		vectors[b * 2 + 1] = (bestvy << 1);
-		if (bestchange) {
+	}
+	for (unsigned t = 1; t < numTasks; ++t) {
+		searchWorkers[t - 1]->waitIdle();
+	}
+
+	// Output the vectors and the xor data.
+	for (unsigned b = 0; b < blockcount; ++b) {
+		const auto& v = blockVectors[b];
+		vectors[b * 2 + 0] = (v.x << 1);
+		vectors[b * 2 + 1] = (v.y << 1);
+		if (v.changed) {
 			vectors[b * 2 + 0] |= 1;
-			addXorBlock<P>(pixelOps, bestvx, bestvy, offset, workUsed);
+			addXorBlock<P>(pixelOps, v.x, v.y, blockOffsets[b], workUsed);
 		}
 	}
 }
@@ -351,10 +403,27 @@ const void* ZMBVEncoder::getScaledLine(FrameSource* frame, unsigned y, void* buf
 	return nullptr; // avoid warning
 }
 
-void ZMBVEncoder::compressFrame(bool keyFrame, FrameSource* frame,
-                                void*& buffer, unsigned& written)
+void ZMBVEncoder::captureFrame(FrameSource* frame)
+{
+	// copy lines (to add black border)
+	unsigned linePitch = pitch * pixelSize;
+	unsigned lineWidth = width * pixelSize;
+	uint8_t* dest =
+		&nextframe[pixelSize * (MAX_VECTOR + MAX_VECTOR * pitch)];
+	for (unsigned i = 0; i < height; ++i) {
+		auto* scaled = getScaledLine(frame, i, dest);
+		if (scaled != dest) memcpy(dest, scaled, lineWidth);
+		dest += linePitch;
+	}
+	capturedFormat = frame->getSDLPixelFormat();
+}
+
+void ZMBVEncoder::compressFrame(bool keyFrame, void*& buffer, unsigned& written)
 {
+	// captureFrame() must be called first
+	assert(capturedFormat.BytesPerPixel != 0);
 	std::swap(newframe, oldframe); // replace oldframe with newframe
+	std::swap(newframe, nextframe); // and newframe with the captured one
 
 	// Reset the work buffer
 	unsigned workUsed = 0;
@@ -376,29 +445,18 @@ void ZMBVEncoder::compressFrame(bool keyFrame, FrameSource* frame,
 		deflateReset(&zstream); // restart deflate
 	}
 
-	// copy lines (to add black border)
-	unsigned linePitch = pitch * pixelSize;
-	unsigned lineWidth = width * pixelSize;
-	uint8_t* dest =
-		&newframe[pixelSize * (MAX_VECTOR + MAX_VECTOR * pitch)];
-	for (unsigned i = 0; i < height; ++i) {
-		auto* scaled = getScaledLine(frame, i, dest);
-		if (scaled != dest) memcpy(dest, scaled, lineWidth);
-		dest += linePitch;
-	}
-
 	// Add the frame data.
 	if (keyFrame) {
 		// Key frame: full frame data.
 		switch (pixelSize) {
 #if HAVE_16BPP
 		case 2:
-			addFullFrame<uint16_t>(frame->getSDLPixelFormat(), workUsed);
+			addFullFrame<uint16_t>(capturedFormat, workUsed);
 			break;
 #endif
 #if HAVE_32BPP
 		case 4:
-			addFullFrame<uint32_t>(frame->getSDLPixelFormat(), workUsed);
+			addFullFrame<uint32_t>(capturedFormat, workUsed);
 			break;
 #endif
 		default:
@@ -409,12 +467,12 @@ void ZMBVEncoder::compressFrame(bool keyFrame, FrameSource* frame,
 		switch (pixelSize) {
 #if HAVE_16BPP
 		case 2:
-			addXorFrame<uint16_t>(frame->getSDLPixelFormat(), workUsed);
+			addXorFrame<uint16_t>(capturedFormat, workUsed);
 			break;
 #endif
 #if HAVE_32BPP
 		case 4:
-			addXorFrame<uint32_t>(frame->getSDLPixelFormat(), workUsed);
+			addXorFrame<uint32_t>(capturedFormat, workUsed);
 			break;
 #endif
 		default:
@@ -5,13 +5,15 @@
 
 #include "MemBuffer.hh"
 #include <cstdint>
+#include <memory>
+#include <vector>
 #include <zlib.h>
-
-struct SDL_PixelFormat;
+#include <SDL.h>
 
 namespace openmsx {
 
 class FrameSource;
+class WorkerThread;
 template<class P> class PixelOperations;
 
 class ZMBVEncoder
@@ -22,8 +24,16 @@ public:
 	ZMBVEncoder(unsigned width, unsigned height, unsigned bpp);
 	~ZMBVEncoder();
 
-	void compressFrame(bool keyFrame, FrameSource* frame,
-	                   void*& buffer, unsigned& written);
+	/** Copy the given frame to an internal buffer. After this call the
+	  * frame is no longer accessed, so the actual compression can run on
+	  * a different thread (while the emulation continues).
+	  */
+	void captureFrame(FrameSource* frame);
+
+	/** Compress the frame that was passed to the last captureFrame()
+	  * call. The result remains valid till the next call.
+	  */
+	void compressFrame(bool keyFrame, void*& buffer, unsigned& written);
 
 private:
 	enum Format {
@@ -37,16 +47,25 @@ private:
 	template<class P> void addXorFrame (const SDL_PixelFormat& pixelFormat, unsigned& workUsed);
 	template<class P> unsigned possibleBlock(int vx, int vy, unsigned offset);
 	template<class P> unsigned compareBlock(int vx, int vy, unsigned offset);
+	template<class P> void searchVectors(unsigned firstRow, unsigned lastRow);
 	template<class P> void addXorBlock(
 		const PixelOperations<P>& pixelOps, int vx, int vy,
 		unsigned offset, unsigned& workUsed);
 	const void* getScaledLine(FrameSource* frame, unsigned y, void* workBuf);
 
+	/** Result of the motion search for one block. */
+	struct BlockVector {
+		int8_t x, y;
+		bool changed; // is the block different after motion compensation
+	};
+
 	MemBuffer<uint8_t, SSE2_ALIGNMENT> oldframe;
 	MemBuffer<uint8_t, SSE2_ALIGNMENT> newframe;
+	MemBuffer<uint8_t, SSE2_ALIGNMENT> nextframe; // see captureFrame()
 	MemBuffer<uint8_t, SSE2_ALIGNMENT> work;
 	MemBuffer<uint8_t> output;
 	MemBuffer<unsigned> blockOffsets;
+	MemBuffer<BlockVector> blockVectors;
 	unsigned outputSize;
 
 	z_stream zstream;
@@ -56,6 +75,14 @@ private:
 	unsigned pitch;
 	unsigned pixelSize;
 	Format format;
+	// Copy (not a pointer) because it's used on the AviWriter thread,
+	// after the frame was handed back to the emulation.
+	SDL_PixelFormat capturedFormat; // see captureFrame()
+
+	/** Helper threads for the motion search, it runs in parallel for
+	  * ranges of block rows.
+	  */
+	std::vector<std::unique_ptr<WorkerThread>> searchWorkers;
 };
 
 } // namespace openmsx
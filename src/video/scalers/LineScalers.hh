@@ -4,6 +4,7 @@
 #include "PixelOperations.hh"
 #include "likely.hh"
 #include <type_traits>
+#include <cstddef>
 #include <cstring>
 #include <cassert>
 #ifdef __SSE2__
@@ -12,6 +13,9 @@
 #ifdef __SSSE3__
 #include "tmmintrin.h"
 #endif
+#ifdef __AVX2__
+#include "immintrin.h"
+#endif
 
 namespace openmsx {
 
@@ -452,6 +456,44 @@ static inline void scale_1on2_SSE(const Pixel* in_, Pixel* out_, size_t srcWidth
 }
 #endif
 
+#ifdef __AVX2__
+// Same as scale_1on2_SSE(), but processes twice as many pixels per
+// instruction. There are no alignment requirements (unaligned loads/stores
+// are cheap on all AVX2 capable CPUs).
+template<typename Pixel>
+static inline void scale_1on2_AVX2(const Pixel* in_, Pixel* out_, size_t srcWidth)
+{
+	size_t bytes = srcWidth * sizeof(Pixel);
+	assert((bytes % (4 * sizeof(__m256i))) == 0);
+	assert(bytes != 0);
+
+	auto* in  = reinterpret_cast<const char*>(in_)  +     bytes;
+	auto* out = reinterpret_cast<      char*>(out_) + 2 * bytes;
+
+	auto x = -ptrdiff_t(bytes);
+	do {
+		for (int i = 0; i < 4; ++i) {
+			__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + x + 32 * i));
+			// unpack works within each 128-bit lane, so afterwards
+			// the lanes must be put back in the right order
+			__m256i l, h;
+			if (sizeof(Pixel) == 4) {
+				l = _mm256_unpacklo_epi32(a, a);
+				h = _mm256_unpackhi_epi32(a, a);
+			} else {
+				l = _mm256_unpacklo_epi16(a, a);
+				h = _mm256_unpackhi_epi16(a, a);
+			}
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 2*x + 64 * i +  0),
+			                    _mm256_permute2x128_si256(l, h, 0x20));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 2*x + 64 * i + 32),
+			                    _mm256_permute2x128_si256(l, h, 0x31));
+		}
+		x += 4 * sizeof(__m256i);
+	} while (x < 0);
+}
+#endif
+
 template <typename Pixel>
 void Scale_1on2<Pixel>::operator()(
 	const Pixel* __restrict in, Pixel* __restrict out, size_t dstWidth)
@@ -470,13 +512,25 @@ void Scale_1on2<Pixel>::operator()(
 	// the instrinsic version is no longer needed.
 	size_t srcWidth = dstWidth / 2;
 
+#ifdef __AVX2__
+	size_t chunk256 = 4 * sizeof(__m256i) / sizeof(Pixel);
+	size_t srcWidth256 = srcWidth & ~(chunk256 - 1);
+	if (srcWidth256) {
+		scale_1on2_AVX2(in, out, srcWidth256);
+		in  +=      srcWidth256;
+		out +=  2 * srcWidth256;
+		srcWidth -= srcWidth256;
+	}
+#endif
 #ifdef __SSE2__
 	size_t chunk = 4 * sizeof(__m128i) / sizeof(Pixel);
 	size_t srcWidth2 = srcWidth & ~(chunk - 1);
-	scale_1on2_SSE(in, out, srcWidth2);
-	in  +=      srcWidth2;
-	out +=  2 * srcWidth2;
-	srcWidth -= srcWidth2;
+	if (srcWidth2) {
+		scale_1on2_SSE(in, out, srcWidth2);
+		in  +=      srcWidth2;
+		out +=  2 * srcWidth2;
+		srcWidth -= srcWidth2;
+	}
 #endif
 
 	// C++ version. Used both on non-x86 machines and (possibly) on x86 for
@@ -516,6 +570,33 @@ static inline void memcpy_SSE_128(
 }
 #endif
 
+#ifdef __AVX2__
+// Same as memcpy_SSE_128() but with 32-byte registers, and without alignment
+// requirements.
+static inline void memcpy_AVX2_128(
+	const void* __restrict in_, void* __restrict out_, size_t size)
+{
+	assert((size % 128) == 0);
+	assert(size != 0);
+
+	auto* in  = reinterpret_cast<const __m256i*>(in_);
+	auto* out = reinterpret_cast<      __m256i*>(out_);
+	auto* end = in + (size / sizeof(__m256i));
+	do {
+		__m256i a0 = _mm256_loadu_si256(in + 0);
+		__m256i a1 = _mm256_loadu_si256(in + 1);
+		__m256i a2 = _mm256_loadu_si256(in + 2);
+		__m256i a3 = _mm256_loadu_si256(in + 3);
+		_mm256_storeu_si256(out + 0, a0);
+		_mm256_storeu_si256(out + 1, a1);
+		_mm256_storeu_si256(out + 2, a2);
+		_mm256_storeu_si256(out + 3, a3);
+		in += 4;
+		out += 4;
+	} while (in != end);
+}
+#endif
+
 template <typename Pixel>
 void Scale_1on1<Pixel>::operator()(
 	const Pixel* __restrict in, Pixel* __restrict out, size_t width)
@@ -527,7 +608,11 @@ void Scale_1on1<Pixel>::operator()(
 	// 10% faster than a simple memcpy(). When using gcc-4.6 (still the
 	// default on many systems), it's still about 66% faster.
 	size_t n128 = nBytes & ~127;
+#ifdef __AVX2__
+	memcpy_AVX2_128(in, out, n128); // copy 128 byte chunks
+#else
 	memcpy_SSE_128(in, out, n128); // copy 128 byte chunks
+#endif
 	nBytes &= 127; // remaning bytes (if any)
 	if (likely(nBytes == 0)) return;
 	in  += n128 / sizeof(Pixel);
@@ -666,6 +751,85 @@ static inline void scale_2on1_SSE(
 }
 #endif
 
+#ifdef __AVX2__
+// Same as blend() above, but on 32-byte registers.
+template<typename Pixel>
+static inline __m256i blend256(__m256i x, __m256i y, Pixel mask)
+{
+	// Both versions below first produce (in each 128-bit lane) the even
+	// and odd pixels of 'x' followed by those of 'y'. A final permute puts
+	// the 64-bit quarters back in the right order.
+	__m256i r;
+	if (sizeof(Pixel) == 4) {
+		// 32bpp
+		__m256 xf = _mm256_castsi256_ps(x);
+		__m256 yf = _mm256_castsi256_ps(y);
+		__m256i p = _mm256_castps_si256(_mm256_shuffle_ps(xf, yf, 0x88));
+		__m256i q = _mm256_castps_si256(_mm256_shuffle_ps(xf, yf, 0xDD));
+		r = _mm256_avg_epu8(p, q);
+	} else {
+		// 16bpp
+		const __m256i LL = _mm256_setr_epi8(
+			0x00, 0x01, 0x04, 0x05, 0x08, 0x09, 0x0C, 0x0D,
+			-128, -128, -128, -128, -128, -128, -128, -128,
+			0x00, 0x01, 0x04, 0x05, 0x08, 0x09, 0x0C, 0x0D,
+			-128, -128, -128, -128, -128, -128, -128, -128);
+		const __m256i HL = _mm256_setr_epi8(
+			-128, -128, -128, -128, -128, -128, -128, -128,
+			0x00, 0x01, 0x04, 0x05, 0x08, 0x09, 0x0C, 0x0D,
+			-128, -128, -128, -128, -128, -128, -128, -128,
+			0x00, 0x01, 0x04, 0x05, 0x08, 0x09, 0x0C, 0x0D);
+		const __m256i LH = _mm256_setr_epi8(
+			0x02, 0x03, 0x06, 0x07, 0x0A, 0x0B, 0x0E, 0x0F,
+			-128, -128, -128, -128, -128, -128, -128, -128,
+			0x02, 0x03, 0x06, 0x07, 0x0A, 0x0B, 0x0E, 0x0F,
+			-128, -128, -128, -128, -128, -128, -128, -128);
+		const __m256i HH = _mm256_setr_epi8(
+			-128, -128, -128, -128, -128, -128, -128, -128,
+			0x02, 0x03, 0x06, 0x07, 0x0A, 0x0B, 0x0E, 0x0F,
+			-128, -128, -128, -128, -128, -128, -128, -128,
+			0x02, 0x03, 0x06, 0x07, 0x0A, 0x0B, 0x0E, 0x0F);
+		__m256i p = _mm256_or_si256(_mm256_shuffle_epi8(x, LL),
+		                            _mm256_shuffle_epi8(y, HL));
+		__m256i q = _mm256_or_si256(_mm256_shuffle_epi8(x, LH),
+		                            _mm256_shuffle_epi8(y, HH));
+		// (p & q) + (((p ^ q) & mask) >> 1)
+		__m256i m = _mm256_set1_epi16(mask);
+		__m256i a = _mm256_and_si256(p, q);
+		__m256i b = _mm256_xor_si256(p, q);
+		__m256i c = _mm256_and_si256(b, m);
+		__m256i d = _mm256_srli_epi16(c, 1);
+		r = _mm256_add_epi16(a, d);
+	}
+	return _mm256_permute4x64_epi64(r, 0xD8);
+}
+
+template<typename Pixel>
+static inline void scale_2on1_AVX2(
+	const Pixel* __restrict in_, Pixel* __restrict out_, size_t dstBytes,
+	Pixel mask)
+{
+	assert((dstBytes % (2 * sizeof(__m256i))) == 0);
+	assert(dstBytes != 0);
+
+	auto* in  = reinterpret_cast<const char*>(in_)  + 2 * dstBytes;
+	auto* out = reinterpret_cast<      char*>(out_) +     dstBytes;
+
+	auto x = -ptrdiff_t(dstBytes);
+	do {
+		__m256i a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 2*x +   0));
+		__m256i a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 2*x +  32));
+		__m256i a2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 2*x +  64));
+		__m256i a3 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 2*x +  96));
+		__m256i b0 = blend256(a0, a1, mask);
+		__m256i b1 = blend256(a2, a3, mask);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x +  0), b0);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x + 32), b1);
+		x += 2 * sizeof(__m256i);
+	} while (x < 0);
+}
+#endif
+
 template <typename Pixel>
 void Scale_2on1<Pixel>::operator()(
 	const Pixel* __restrict in, Pixel* __restrict out, size_t dstWidth)
@@ -673,7 +837,11 @@ void Scale_2on1<Pixel>::operator()(
 #ifdef __SSE2__
 	size_t n64 = (dstWidth * sizeof(Pixel)) & ~63;
 	Pixel mask = pixelOps.getBlendMask();
+#ifdef __AVX2__
+	scale_2on1_AVX2(in, out, n64, mask); // process 64 byte chunks
+#else
 	scale_2on1_SSE(in, out, n64, mask); // process 64 byte chunks
+#endif
 	dstWidth &= ((64 / sizeof(Pixel)) - 1); // remaning pixels (if any)
 	if (likely(dstWidth == 0)) return;
 	in  += (2 * n64) / sizeof(Pixel);
@@ -0,0 +1,253 @@
+#include "LineScalers.hh"
+#include "Scanline.hh"
+#include "Scale2xScaler.hh"
+#include "Deflicker.hh"
+#include "RawFrame.hh"
+#include "PixelOperations.hh"
+#include "MemBuffer.hh"
+#include "memory.hh"
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <random>
+
+using namespace openmsx;
+
+// Compare the (SSE2 or AVX2, depending on the compiler flags) line scalers,
+// the Scale2x line routines and Deflicker against straightforward scalar
+// implementations, pixel-for-pixel. Build once with and once without e.g.
+// -mavx2 to check all code paths.
+//
+// Note: for 32bpp the SIMD routines average by rounding up (that's what the
+// pavgb instruction does), the reference implementations below mimic that.
+
+static std::mt19937 rng(1234);
+
+template<typename Pixel> static void fillRandom(Pixel* buf, size_t num)
+{
+	for (size_t i = 0; i < num; ++i) buf[i] = Pixel(rng());
+}
+
+// Per component average, rounding up for 32bpp, rounding down for 16bpp.
+template<typename Pixel>
+static Pixel avg(const PixelOperations<Pixel>& pixelOps, Pixel p, Pixel q)
+{
+	if (sizeof(Pixel) == 4) {
+		Pixel r = 0;
+		for (int s = 0; s < 32; s += 8) {
+			unsigned a = (p >> s) & 0xFF;
+			unsigned b = (q >> s) & 0xFF;
+			r |= Pixel((a + b + 1) >> 1) << s;
+		}
+		return r;
+	} else {
+		Pixel m = pixelOps.getBlendMask();
+		return (p & q) + (((p ^ q) & m) >> 1);
+	}
+}
+
+template<typename Pixel>
+static void test(const PixelOperations<Pixel>& pixelOps)
+{
+	// Sizes that are not a multiple of the SIMD chunk size are included to
+	// test the code paths for the remaining pixels.
+	for (size_t width : { 64, 66, 96, 100, 256, 320, 322, 512, 640 }) {
+		MemBuffer<Pixel, SSE2_ALIGNMENT> in (2 * width);
+		MemBuffer<Pixel, SSE2_ALIGNMENT> in2(2 * width);
+		MemBuffer<Pixel, SSE2_ALIGNMENT> out(2 * width);
+		fillRandom(in .data(), 2 * width);
+		fillRandom(in2.data(), 2 * width);
+
+		// Scale_1on1
+		Scale_1on1<Pixel> copy;
+		copy(in.data(), out.data(), width);
+		for (size_t i = 0; i < width; ++i) {
+			assert(out[i] == in[i]);
+		}
+
+		// Scale_1on2
+		Scale_1on2<Pixel> scale12;
+		scale12(in.data(), out.data(), 2 * width);
+		for (size_t i = 0; i < width; ++i) {
+			assert(out[2 * i + 0] == in[i]);
+			assert(out[2 * i + 1] == in[i]);
+		}
+
+		// Scale_2on1
+		// The last few pixels (less than 64 bytes) are handled by the
+		// C++ code, for 32bpp that one rounds down.
+		Scale_2on1<Pixel> scale21(pixelOps);
+		scale21(in.data(), out.data(), width);
+		size_t simdWidth = ((width * sizeof(Pixel)) & ~63) / sizeof(Pixel);
+		for (size_t i = 0; i < width; ++i) {
+			Pixel p = in[2 * i + 0];
+			Pixel q = in[2 * i + 1];
+			assert(out[i] == ((i < simdWidth)
+				? avg(pixelOps, p, q)
+				: pixelOps.template blend<1, 1>(p, q)));
+		}
+
+		// Scanline (only 32bpp, the 16bpp version uses a lookup table)
+		// The SIMD versions require a multiple of 64 bytes.
+		if ((sizeof(Pixel) == 4) && ((width % 16) == 0)) {
+			Scanline<Pixel> scanline(pixelOps);
+			for (unsigned factor : { 0, 1, 100, 200, 255 }) {
+				scanline.draw(in.data(), in2.data(), out.data(),
+				              factor, width);
+				for (size_t i = 0; i < width; ++i) {
+					Pixel a = avg(pixelOps, in[i], in2[i]);
+					Pixel e = 0;
+					for (int s = 0; s < 32; s += 8) {
+						unsigned c = (a >> s) & 0xFF;
+						e |= Pixel((c * factor) >> 8) << s;
+					}
+					assert(out[i] == e);
+				}
+			}
+		}
+	}
+}
+
+namespace openmsx {
+
+struct Scale2xScalerTest
+{
+	// Compare the SIMD routines (AVX2 when the line is a multiple of 32
+	// bytes, otherwise SSE2) with the C++ routines.
+	template<typename Pixel>
+	static void test(const PixelOperations<Pixel>& pixelOps)
+	{
+		Scale2xScaler<Pixel> scaler(pixelOps);
+		for (size_t width : { 8, 12, 16, 20, 24, 40, 256, 260, 264,
+		                      320, 324, 328, 512, 640 }) {
+			// The SIMD routines require a multiple of 16 bytes,
+			// and at least 32 bytes.
+			size_t bytes = width * sizeof(Pixel);
+			if ((bytes % 16) || (bytes < 32)) continue;
+
+			MemBuffer<Pixel, SSE2_ALIGNMENT> in0(width);
+			MemBuffer<Pixel, SSE2_ALIGNMENT> in1(width);
+			MemBuffer<Pixel, SSE2_ALIGNMENT> in2(width);
+			MemBuffer<Pixel, SSE2_ALIGNMENT> out0(2 * width);
+			MemBuffer<Pixel, SSE2_ALIGNMENT> out1(2 * width);
+			MemBuffer<Pixel, SSE2_ALIGNMENT> ref0(2 * width);
+			MemBuffer<Pixel, SSE2_ALIGNMENT> ref1(2 * width);
+			for (int iter = 0; iter < 20; ++iter) {
+				// Only a few different colors, otherwise
+				// neighbouring pixels are (almost) never equal.
+				Pixel colors[3] = { Pixel(rng()), Pixel(rng()), Pixel(rng()) };
+				for (size_t i = 0; i < width; ++i) {
+					in0[i] = colors[rng() % 3];
+					in1[i] = colors[rng() % 3];
+					in2[i] = colors[rng() % 3];
+				}
+
+				// DOUBLE_X = true
+				scaler.scaleLine_1on2(out0.data(), out1.data(),
+					in0.data(), in1.data(), in2.data(), width);
+				scaler.scaleLineHalf_1on2(ref0.data(),
+					in0.data(), in1.data(), in2.data(), width);
+				scaler.scaleLineHalf_1on2(ref1.data(),
+					in2.data(), in1.data(), in0.data(), width);
+				for (size_t i = 0; i < 2 * width; ++i) {
+					assert(out0[i] == ref0[i]);
+					assert(out1[i] == ref1[i]);
+				}
+
+				// DOUBLE_X = false
+				scaler.scaleLine_1on1(out0.data(), out1.data(),
+					in0.data(), in1.data(), in2.data(), width);
+				scaler.scaleLineHalf_1on1(ref0.data(),
+					in0.data(), in1.data(), in2.data(), width);
+				scaler.scaleLineHalf_1on1(ref1.data(),
+					in2.data(), in1.data(), in0.data(), width);
+				for (size_t i = 0; i < width; ++i) {
+					assert(out0[i] == ref0[i]);
+					assert(out1[i] == ref1[i]);
+				}
+			}
+		}
+	}
+};
+
+} // namespace openmsx
+
+// Deflicker replaces pixels that alternate between two values (A B A B in the
+// last 4 frames) by the average of those two values.
+template<typename Pixel>
+static void testDeflicker(const SDL_PixelFormat& format,
+                          const PixelOperations<Pixel>& pixelOps)
+{
+	const unsigned HEIGHT = 8;
+	std::unique_ptr<RawFrame> frames[4];
+	for (auto& f : frames) f = make_unique<RawFrame>(format, 640, HEIGHT);
+	auto deflicker = Deflicker::create(format, frames);
+
+	// All multiples of 16 bytes, some are not a multiple of 32 bytes.
+	for (unsigned width : { 8, 16, 24, 256, 264, 320, 328, 512, 640 }) {
+		if ((width * sizeof(Pixel)) % 16) continue;
+
+		// Start with 2 alternating frames, then change some pixels.
+		for (unsigned y = 0; y < HEIGHT; ++y) {
+			Pixel* f0 = frames[0]->template getLinePtrDirect<Pixel>(y);
+			Pixel* f1 = frames[1]->template getLinePtrDirect<Pixel>(y);
+			Pixel* f2 = frames[2]->template getLinePtrDirect<Pixel>(y);
+			Pixel* f3 = frames[3]->template getLinePtrDirect<Pixel>(y);
+			for (unsigned x = 0; x < width; ++x) {
+				f0[x] = f2[x] = Pixel(rng());
+				f1[x] = f3[x] = Pixel(rng());
+				if ((rng() % 4) == 0) f2[x] = Pixel(rng());
+				if ((rng() % 4) == 0) f3[x] = Pixel(rng());
+			}
+		}
+		for (auto& f : frames) {
+			for (unsigned y = 0; y < HEIGHT; ++y) f->setLineWidth(y, width);
+			f->compareLines(nullptr); // all lines changed
+		}
+		deflicker->init();
+
+		MemBuffer<Pixel, SSE2_ALIGNMENT> buf(width);
+		for (unsigned y = 0; y < HEIGHT; ++y) {
+			const Pixel* out = deflicker->getLinePtr(y, width, buf.data());
+			const Pixel* f0 = frames[0]->template getLinePtrDirect<Pixel>(y);
+			const Pixel* f1 = frames[1]->template getLinePtrDirect<Pixel>(y);
+			const Pixel* f2 = frames[2]->template getLinePtrDirect<Pixel>(y);
+			const Pixel* f3 = frames[3]->template getLinePtrDirect<Pixel>(y);
+			for (unsigned x = 0; x < width; ++x) {
+				// Like the C++ routine, but for 32bpp rounding up
+				// like the SIMD routines.
+				Pixel e = ((f0[x] == f2[x]) && (f1[x] == f3[x]))
+				        ? avg(pixelOps, f0[x], f1[x])
+				        : f0[x];
+				assert(out[x] == e);
+			}
+		}
+	}
+}
+
+int main()
+{
+	SDL_PixelFormat format16 = {};
+	format16.BitsPerPixel = 16;
+	format16.BytesPerPixel = 2;
+	format16.Rmask = 0xF800; format16.Rshift = 11; format16.Rloss = 3;
+	format16.Gmask = 0x07E0; format16.Gshift =  5; format16.Gloss = 2;
+	format16.Bmask = 0x001F; format16.Bshift =  0; format16.Bloss = 3;
+	format16.Aloss = 8;
+	test(PixelOperations<uint16_t>(format16));
+	Scale2xScalerTest::test(PixelOperations<uint16_t>(format16));
+	testDeflicker(format16, PixelOperations<uint16_t>(format16));
+
+	SDL_PixelFormat format32 = {};
+	format32.BitsPerPixel = 32;
+	format32.BytesPerPixel = 4;
+	format32.Rmask = 0x00FF0000; format32.Rshift = 16;
+	format32.Gmask = 0x0000FF00; format32.Gshift =  8;
+	format32.Bmask = 0x000000FF; format32.Bshift =  0;
+	format32.Amask = 0xFF000000; format32.Ashift = 24;
+	test(PixelOperations<uint32_t>(format32));
+	Scale2xScalerTest::test(PixelOperations<uint32_t>(format32));
+	testDeflicker(format32, PixelOperations<uint32_t>(format32));
+
+	std::cout << "All tests passed" << std::endl;
+}
@@ -25,6 +25,9 @@ public:
 		unsigned srcStartY, unsigned srcEndY, unsigned srcWidth,
 		ScalerOutput<Pixel>& dst, unsigned dstStartY, unsigned dstEndY) override;
 
+	// Edges can span the complete area.
+	bool canScaleInBands() const override { return false; }
+
 private:
 	const PixelOperations<Pixel> pixelOps;
 	const unsigned dstWidth;
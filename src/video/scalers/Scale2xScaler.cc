@@ -19,11 +19,15 @@ Visit the Scale2x site for info:
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #ifdef __SSE2__
 #include "emmintrin.h" // SSE2
 #ifdef __SSSE3__
 #include "tmmintrin.h" // SSSE3  (supplemental SSE3)
 #endif
+#ifdef __AVX2__
+#include "immintrin.h" // AVX2
+#endif
 #endif
 
 namespace openmsx {
@@ -203,7 +207,135 @@ template<bool DOUBLE_X, typename Pixel> static inline void scaleSSE(
 	                        reinterpret_cast<__m128i*>(out1));
 }
 
-#endif
+#ifdef __AVX2__
+
+template<typename Pixel> static inline __m256i isEqual(__m256i x, __m256i y)
+{
+	if (sizeof(Pixel) == 4) {
+		return _mm256_cmpeq_epi32(x, y);
+	} else if (sizeof(Pixel) == 2) {
+		return _mm256_cmpeq_epi16(x, y);
+	} else {
+		UNREACHABLE;
+	}
+}
+
+static inline __m256i select(__m256i a0, __m256i a1, __m256i mask)
+{
+	return _mm256_xor_si256(_mm256_and_si256(_mm256_xor_si256(a0, a1), mask), a0);
+}
+
+// Same as scaleSSE(), but 32 bytes at a time. Shifting a 32-byte register
+// by one pixel is awkward in AVX2 (most shuffles work per 128-bit lane), so
+// instead the left and right neighbours are fetched with unaligned loads
+// from a copy of the middle line that has the first and last pixel
+// duplicated at both ends.
+template<bool DOUBLE_X, typename Pixel> static inline void scaleAVX2(
+	      Pixel* __restrict out0_,  // top output line
+	      Pixel* __restrict out1_,  // bottom output line
+	const Pixel* __restrict in0_,   // top input line
+	const Pixel* __restrict in1_,   // middle output line
+	const Pixel* __restrict in2_,   // bottom output line
+	size_t width)
+{
+	assert(((width * sizeof(Pixel)) % sizeof(__m256i)) == 0);
+	assert(width > 1);
+
+	VLA_SSE_ALIGNED(Pixel, padded, width + 2);
+	padded[0] = in1_[0];
+	memcpy(padded + 1, in1_, width * sizeof(Pixel));
+	padded[width + 1] = in1_[width - 1];
+
+	static const size_t SCALE = DOUBLE_X ? 2 : 1;
+	size_t bytes = width * sizeof(Pixel);
+	auto* in0  = reinterpret_cast<const char*>(in0_ ) +         bytes;
+	auto* in1  = reinterpret_cast<const char*>(in1_ ) +         bytes;
+	auto* in2  = reinterpret_cast<const char*>(in2_ ) +         bytes;
+	auto* pl   = reinterpret_cast<const char*>(padded + 0) +    bytes;
+	auto* pr   = reinterpret_cast<const char*>(padded + 2) +    bytes;
+	auto* out0 = reinterpret_cast<      char*>(out0_) + SCALE * bytes;
+	auto* out1 = reinterpret_cast<      char*>(out1_) + SCALE * bytes;
+	ptrdiff_t x = -ptrdiff_t(bytes);
+
+	do {
+		__m256i top    = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in0 + x));
+		__m256i mid    = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in1 + x));
+		__m256i bottom = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in2 + x));
+		__m256i left   = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pl  + x));
+		__m256i right  = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pr  + x));
+
+		__m256i teqb = isEqual<Pixel>(top, bottom);
+		__m256i leqt = isEqual<Pixel>(left, top);
+		__m256i reqt = isEqual<Pixel>(right, top);
+		__m256i leqb = isEqual<Pixel>(left, bottom);
+		__m256i reqb = isEqual<Pixel>(right, bottom);
+
+		__m256i cnda = _mm256_andnot_si256(_mm256_or_si256(teqb, reqt), leqt);
+		__m256i cndb = _mm256_andnot_si256(_mm256_or_si256(teqb, leqt), reqt);
+		__m256i cndc = _mm256_andnot_si256(_mm256_or_si256(teqb, reqb), leqb);
+		__m256i cndd = _mm256_andnot_si256(_mm256_or_si256(teqb, leqb), reqb);
+
+		__m256i a = select(mid, top,    cnda);
+		__m256i b = select(mid, top,    cndb);
+		__m256i c = select(mid, bottom, cndc);
+		__m256i d = select(mid, bottom, cndd);
+
+		auto* o0 = reinterpret_cast<__m256i*>(out0 + SCALE * x);
+		auto* o1 = reinterpret_cast<__m256i*>(out1 + SCALE * x);
+		if (DOUBLE_X) {
+			// unpack works per 128-bit lane, afterwards put the
+			// lanes back in the right order
+			__m256i ab0, ab1, cd0, cd1;
+			if (sizeof(Pixel) == 4) {
+				ab0 = _mm256_unpacklo_epi32(a, b);
+				ab1 = _mm256_unpackhi_epi32(a, b);
+				cd0 = _mm256_unpacklo_epi32(c, d);
+				cd1 = _mm256_unpackhi_epi32(c, d);
+			} else {
+				ab0 = _mm256_unpacklo_epi16(a, b);
+				ab1 = _mm256_unpackhi_epi16(a, b);
+				cd0 = _mm256_unpacklo_epi16(c, d);
+				cd1 = _mm256_unpackhi_epi16(c, d);
+			}
+			_mm256_storeu_si256(o0 + 0, _mm256_permute2x128_si256(ab0, ab1, 0x20));
+			_mm256_storeu_si256(o0 + 1, _mm256_permute2x128_si256(ab0, ab1, 0x31));
+			_mm256_storeu_si256(o1 + 0, _mm256_permute2x128_si256(cd0, cd1, 0x20));
+			_mm256_storeu_si256(o1 + 1, _mm256_permute2x128_si256(cd0, cd1, 0x31));
+		} else {
+			_mm256_storeu_si256(o0, a);
+			_mm256_storeu_si256(o1, c);
+		}
+		x += sizeof(__m256i);
+	} while (x < 0);
+}
+
+// Use the AVX2 routine when the line width is a multiple of 32 bytes (that's
+// the case for all normal line widths), otherwise fall back to SSE2.
+template<bool DOUBLE_X, typename Pixel> static inline void scaleSIMD(
+	Pixel* __restrict out0, Pixel* __restrict out1,
+	const Pixel* __restrict in0, const Pixel* __restrict in1,
+	const Pixel* __restrict in2, size_t width)
+{
+	if (((width * sizeof(Pixel)) % sizeof(__m256i)) == 0) {
+		scaleAVX2<DOUBLE_X>(out0, out1, in0, in1, in2, width);
+	} else {
+		scaleSSE<DOUBLE_X>(out0, out1, in0, in1, in2, width);
+	}
+}
+
+#else
+
+template<bool DOUBLE_X, typename Pixel> static inline void scaleSIMD(
+	Pixel* __restrict out0, Pixel* __restrict out1,
+	const Pixel* __restrict in0, const Pixel* __restrict in1,
+	const Pixel* __restrict in2, size_t width)
+{
+	scaleSSE<DOUBLE_X>(out0, out1, in0, in1, in2, width);
+}
+
+#endif // __AVX2__
+
+#endif // __SSE2__
 
 
 template <class Pixel>
@@ -224,7 +356,7 @@ inline void Scale2xScaler<Pixel>::scaleLine_1on2(
 	// eliminate some common sub-expressions). For the asm version the
 	// situation is reversed.
 #ifdef __SSE2__
-	scaleSSE<true>(dst0, dst1, src0, src1, src2, srcWidth);
+	scaleSIMD<true>(dst0, dst1, src0, src1, src2, srcWidth);
 #else
 	scaleLineHalf_1on2(dst0, src0, src1, src2, srcWidth);
 	scaleLineHalf_1on2(dst1, src2, src1, src0, srcWidth);
@@ -276,7 +408,7 @@ inline void Scale2xScaler<Pixel>::scaleLine_1on1(
 	const Pixel* __restrict src2, size_t srcWidth) __restrict
 {
 #ifdef __SSE2__
-	scaleSSE<false>(dst0, dst1, src0, src1, src2, srcWidth);
+	scaleSIMD<false>(dst0, dst1, src0, src1, src2, srcWidth);
 #else
 	scaleLineHalf_1on1(dst0, src0, src1, src2, srcWidth);
 	scaleLineHalf_1on1(dst1, src2, src1, src0, srcWidth);
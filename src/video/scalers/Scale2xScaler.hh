@@ -21,6 +21,8 @@ public:
 		ScalerOutput<Pixel>& dst, unsigned dstStartY, unsigned dstEndY) override;
 
 private:
+	friend class Scale2xScalerTest; // compares SIMD and C++ routines
+
 	void scaleLine_1on2(Pixel* dst0, Pixel* dst1,
 		const Pixel* src0, const Pixel* src1, const Pixel* src2,
 		size_t srcWidth) __restrict;
@@ -30,6 +30,16 @@ public:
 	virtual void scaleImage(FrameSource& src, const RawFrame* superImpose,
 		unsigned srcStartY, unsigned srcEndY, unsigned srcWidth,
 		ScalerOutput<Pixel>& dst, unsigned dstStartY, unsigned dstEndY) = 0;
+
+	/** Can an area be split in horizontal bands that are scaled
+	  * independently (by different Scaler objects, possibly in parallel,
+	  * each with its own ScalerOutput), with exactly the same result as
+	  * scaling the area in one go?
+	  * This is the case for scalers where each output line only depends
+	  * on a fixed number of surrounding source lines (which they fetch
+	  * from the FrameSource, also outside the given area).
+	  */
+	virtual bool canScaleInBands() const { return true; }
 };
 
 } // namespace openmsx
@@ -3,6 +3,11 @@
 
 namespace openmsx {
 
+/** Destination of a Scaler.
+  * A ScalerOutput object should only be used by one thread. To scale a
+  * frame in parallel, each band gets its own ScalerOutput object (they
+  * can write to disjoint lines of the same OutputSurface).
+  */
 template<typename Pixel> class ScalerOutput
 {
 public:
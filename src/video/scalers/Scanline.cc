@@ -7,6 +7,9 @@
 #ifdef __SSE2__
 #include <emmintrin.h>
 #endif
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
 namespace openmsx {
 
@@ -97,6 +100,25 @@ static inline void drawSSE2_1(
 	__m128i r = _mm_packus_epi16(m, n);
 	*reinterpret_cast<__m128i*>(out) = r;
 }
+#ifdef __AVX2__
+// Same as drawSSE2_1(), but for 32 bytes. Unpack and pack both work per
+// 128-bit lane, so the pixel order is preserved.
+static inline void drawAVX2_1(
+	const char* __restrict in1, const char* __restrict in2,
+	      char* __restrict out, __m256i f)
+{
+	__m256i zero = _mm256_setzero_si256();
+	__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in1));
+	__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in2));
+	__m256i c = _mm256_avg_epu8(a, b);
+	__m256i l = _mm256_unpacklo_epi8(c, zero);
+	__m256i h = _mm256_unpackhi_epi8(c, zero);
+	__m256i m = _mm256_mulhi_epu16(l, f);
+	__m256i n = _mm256_mulhi_epu16(h, f);
+	__m256i r = _mm256_packus_epi16(m, n);
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(out), r);
+}
+#endif
 static inline void drawSSE2(
 	const uint32_t* __restrict in1_,
 	const uint32_t* __restrict in2_,
@@ -115,8 +137,16 @@ static inline void drawSSE2(
 	auto* in2 = reinterpret_cast<const char*>(in2_) + width;
 	auto* out = reinterpret_cast<      char*>(out_) + width;
 
-	__m128i f = _mm_set1_epi16(factor << 8);
 	ptrdiff_t x = -ptrdiff_t(width);
+#ifdef __AVX2__
+	__m256i f = _mm256_set1_epi16(factor << 8);
+	do {
+		drawAVX2_1(in1 + x +  0, in2 + x +  0, out + x +  0, f);
+		drawAVX2_1(in1 + x + 32, in2 + x + 32, out + x + 32, f);
+		x += 64;
+	} while (x < 0);
+#else
+	__m128i f = _mm_set1_epi16(factor << 8);
 	do {
 		drawSSE2_1(in1 + x +   0, in2 + x +  0, out + x +  0, f);
 		drawSSE2_1(in1 + x +  16, in2 + x + 16, out + x + 16, f);
@@ -124,6 +154,7 @@ static inline void drawSSE2(
 		drawSSE2_1(in1 + x +  48, in2 + x + 48, out + x + 48, f);
 		x += 64;
 	} while (x < 0);
+#endif
 }
 
 // 16bpp
@@ -357,8 +357,14 @@ private:
 
 	// Scheduler stuff
 	struct SyncBase : Schedulable {
-		explicit SyncBase(V9990& v9990) : Schedulable(v9990.getScheduler()) {}
+		explicit SyncBase(V9990& v9990)
+			: Schedulable(v9990.getScheduler()), device(v9990) {}
+		std::string getStatsDeviceName() const override {
+			return device.getName();
+		}
 		friend class V9990;
+	private:
+		const V9990& device;
 	};
 
 	struct SyncVSync : SyncBase {
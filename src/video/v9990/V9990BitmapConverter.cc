@@ -8,6 +8,10 @@
 #include <cassert>
 #include <cstdint>
 
+#ifdef __SSE2__
+#include "emmintrin.h" // SSE2
+#endif
+
 namespace openmsx {
 
 template <class Pixel>
@@ -23,13 +27,13 @@ V9990BitmapConverter<Pixel>::V9990BitmapConverter(
 
 template<bool YJK, bool PAL, bool SKIP, typename Pixel>
 static inline void draw_YJK_YUV_PAL(
-	V9990VRAM& vram,
+	const byte* __restrict vramData,
 	const Pixel* __restrict palette64, const Pixel* __restrict palette32768,
-	Pixel* __restrict pixelPtr, unsigned& address, int firstX = 0)
+	Pixel* __restrict& pixelPtr, unsigned& address, int firstX = 0)
 {
 	byte data[4];
 	for (auto& d : data) {
-		d = vram.readVRAMBx(address++);
+		d = vramData[V9990VRAM::transformBx(address++)];
 	}
 
 	int u = (data[2] & 7) + ((data[3] & 3) << 3) - ((data[3] & 4) << 3);
@@ -51,57 +55,163 @@ static inline void draw_YJK_YUV_PAL(
 	}
 }
 
-template <class Pixel>
-void V9990BitmapConverter<Pixel>::rasterBYUV(
-	Pixel* __restrict pixelPtr, unsigned x, unsigned y, int nrPixels)
+#ifdef __SSE2__
+// Calculates the (15-bit) color index of 32 YUV or YJK pixels (16 bytes from
+// both VRAM banks) at once. Also returns the VRAM bytes in pixel order (only
+// needed for YUVP and YJKP). This is the same as calcYJK() in
+// BitmapConverter.cc, except for the order of the color components.
+template<bool YJK>
+static inline void calcYJK_YUV(
+	const byte* __restrict vram0, const byte* __restrict vram1,
+	uint16_t* __restrict col, byte* __restrict data)
 {
-	unsigned address = (x & ~3) + y * vdp.getImageWidth();
-	if (x & 3) {
-		draw_YJK_YUV_PAL<false, false, true>(
-			vram, palette64, palette32768, pixelPtr, address, x & 3);
-		nrPixels -= 4 - (x & 3);
+	__m128i in0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(vram0));
+	__m128i in1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(vram1));
+	// In Bx modes even addresses are in the first VRAM bank and odd
+	// addresses in the second, so interleaving both gives the pixels in
+	// the right order.
+	__m128i pix8[2] = { _mm_unpacklo_epi8(in0, in1),
+	                    _mm_unpackhi_epi8(in0, in1) };
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(data +  0), pix8[0]);
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(data + 16), pix8[1]);
+
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i c7   = _mm_set1_epi16(7);
+	const __m128i c31  = _mm_set1_epi16(31);
+	for (int n = 0; n < 4; ++n) {
+		// 8 pixels (2 groups) in 16-bit lanes
+		__m128i p = (n & 1) ? _mm_unpackhi_epi8(pix8[n / 2], zero)
+		                    : _mm_unpacklo_epi8(pix8[n / 2], zero);
+		__m128i y = _mm_srli_epi16(p, 3);
+
+		// In each 32-bit lane combine the lower 3 bits of data[0] and
+		// data[1] (that's v) or of data[2] and data[3] (that's u) to a
+		// signed 6-bit value. Then copy v and u to all 4 pixels of the
+		// group.
+		__m128i low = _mm_and_si128(p, c7);
+		__m128i vu = _mm_or_si128(low, _mm_srli_epi32(low, 13));
+		vu = _mm_srai_epi32(_mm_slli_epi32(vu, 26), 26);
+		vu = _mm_packs_epi32(vu, vu);    // v0 u0 v1 u1 v0 u0 v1 u1
+		vu = _mm_unpacklo_epi16(vu, vu); // v0 v0 u0 u0 v1 v1 u1 u1
+		__m128i v = _mm_shuffle_epi32(vu, _MM_SHUFFLE(2, 2, 0, 0));
+		__m128i u = _mm_shuffle_epi32(vu, _MM_SHUFFLE(3, 3, 1, 1));
+
+		// The division by 4 is done with a shift, that rounds negative
+		// values differently, but those are clipped to 0 anyway.
+		__m128i r = _mm_add_epi16(y, u);
+		__m128i g = _mm_add_epi16(_mm_slli_epi16(y, 2), y);
+		g = _mm_sub_epi16(g, _mm_add_epi16(_mm_add_epi16(u, u), v));
+		g = _mm_srai_epi16(g, 2);
+		__m128i b = _mm_add_epi16(y, v);
+		r = _mm_max_epi16(_mm_min_epi16(r, c31), zero);
+		g = _mm_max_epi16(_mm_min_epi16(g, c31), zero);
+		b = _mm_max_epi16(_mm_min_epi16(b, c31), zero);
+		// YJK: green and blue are swapped, see draw_YJK_YUV_PAL()
+		__m128i hi = YJK ? b : g;
+		__m128i lo = YJK ? g : b;
+		__m128i c = _mm_or_si128(_mm_or_si128(_mm_slli_epi16(hi, 10),
+		                                      _mm_slli_epi16(r, 5)),
+		                         lo);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(col + 8 * n), c);
 	}
+}
+#endif
+
+template<bool YJK, bool PAL, typename Pixel>
+static void convertLineYJK_YUV_PAL(
+	const byte* __restrict vramData,
+	const Pixel* __restrict palette64, const Pixel* __restrict palette32768,
+	Pixel* __restrict pixelPtr, unsigned address, int nrPixels)
+{
+	if (address & 3) {
+		int firstX = address & 3;
+		address &= ~3;
+		draw_YJK_YUV_PAL<YJK, PAL, true>(
+			vramData, palette64, palette32768, pixelPtr, address,
+			firstX);
+		nrPixels -= 4 - firstX;
+	}
+#ifdef __SSE2__
+	// SSE2 version: calculate the color indices of 32 pixels at once, only
+	// the palette lookups are done per pixel. Pixels that wrap around the
+	// end of VRAM are left for the C++ version.
+	for (/**/; nrPixels >= 32; nrPixels -= 32) {
+		unsigned addr = address & (V9990VRAM::VRAM_SIZE - 1);
+		if (addr > (V9990VRAM::VRAM_SIZE - 32)) break;
+		const byte* vram0 = &vramData[V9990VRAM::transformBx(addr)];
+		const byte* vram1 = vram0 + V9990VRAM::VRAM_SIZE / 2;
+		uint16_t col[32];
+		byte data[32];
+		calcYJK_YUV<YJK>(vram0, vram1, col, data);
+		for (int n = 0; n < 32; ++n) {
+			pixelPtr[n] = (PAL && (data[n] & 0x08))
+			            ? palette64[data[n] >> 4]
+			            : palette32768[col[n]];
+		}
+		pixelPtr += 32;
+		address += 32;
+	}
+#endif
+	// C++ version
 	for (/**/; nrPixels > 0; nrPixels -= 4) {
-		draw_YJK_YUV_PAL<false, false, false>(
-			vram, palette64, palette32768, pixelPtr, address);
+		draw_YJK_YUV_PAL<YJK, PAL, false>(
+			vramData, palette64, palette32768, pixelPtr, address);
 	}
 	// Note: this can draw up to 3 pixels too many, but that's ok.
 }
 
+template <class Pixel>
+void V9990BitmapConverter<Pixel>::convertLineYUV(
+	V9990ColorMode color, const byte* vramData,
+	const Pixel* palette64, const Pixel* palette32768,
+	Pixel* pixelPtr, unsigned address, int nrPixels)
+{
+	switch (color) {
+	case BYUV:
+		convertLineYJK_YUV_PAL<false, false>(vramData, palette64,
+			palette32768, pixelPtr, address, nrPixels);
+		break;
+	case BYUVP:
+		convertLineYJK_YUV_PAL<false, true>(vramData, palette64,
+			palette32768, pixelPtr, address, nrPixels);
+		break;
+	case BYJK:
+		convertLineYJK_YUV_PAL<true, false>(vramData, palette64,
+			palette32768, pixelPtr, address, nrPixels);
+		break;
+	case BYJKP:
+		convertLineYJK_YUV_PAL<true, true>(vramData, palette64,
+			palette32768, pixelPtr, address, nrPixels);
+		break;
+	default:
+		UNREACHABLE;
+	}
+}
+
+template <class Pixel>
+void V9990BitmapConverter<Pixel>::rasterBYUV(
+	Pixel* __restrict pixelPtr, unsigned x, unsigned y, int nrPixels)
+{
+	convertLineYUV(BYUV, vram.getData(), palette64, palette32768,
+	               pixelPtr, x + y * vdp.getImageWidth(), nrPixels);
+}
+
 template <class Pixel>
 void V9990BitmapConverter<Pixel>::rasterBYUVP(
 	Pixel* __restrict pixelPtr, unsigned x, unsigned y, int nrPixels)
 {
 	// TODO this mode cannot be shown in B4 and higher resolution modes
 	//      (So the dual palette for B4 modes is not an issue here.)
-	unsigned address = (x & ~3) + y * vdp.getImageWidth();
-	if (x & 3) {
-		draw_YJK_YUV_PAL<false, true, true>(
-			vram, palette64, palette32768, pixelPtr, address, x & 3);
-		nrPixels -= 4 - (x & 3);
-	}
-	for (/**/; nrPixels > 0; nrPixels -= 4) {
-		draw_YJK_YUV_PAL<false, true, false>(
-			vram, palette64, palette32768, pixelPtr, address);
-	}
-	// Note: this can draw up to 3 pixels too many, but that's ok.
+	convertLineYUV(BYUVP, vram.getData(), palette64, palette32768,
+	               pixelPtr, x + y * vdp.getImageWidth(), nrPixels);
 }
 
 template <class Pixel>
 void V9990BitmapConverter<Pixel>::rasterBYJK(
 	Pixel* __restrict pixelPtr, unsigned x, unsigned y, int nrPixels)
 {
-	unsigned address = (x & ~3)+ y * vdp.getImageWidth();
-	if (x & 3) {
-		draw_YJK_YUV_PAL<true, false, true>(
-			vram, palette64, palette32768, pixelPtr, address, x & 3);
-		nrPixels -= 4 - (x & 3);
-	}
-	for (/**/; nrPixels > 0; nrPixels -= 4) {
-		draw_YJK_YUV_PAL<true, false, false>(
-			vram, palette64, palette32768, pixelPtr, address);
-	}
-	// Note: this can draw up to 3 pixels too many, but that's ok.
+	convertLineYUV(BYJK, vram.getData(), palette64, palette32768,
+	               pixelPtr, x + y * vdp.getImageWidth(), nrPixels);
 }
 
 template <class Pixel>
@@ -110,17 +220,8 @@ void V9990BitmapConverter<Pixel>::rasterBYJKP(
 {
 	// TODO this mode cannot be shown in B4 and higher resolution modes
 	//      (So the dual palette for B4 modes is not an issue here.)
-	unsigned address = (x & ~3) + y * vdp.getImageWidth();
-	if (x & 3) {
-		draw_YJK_YUV_PAL<true, true, true>(
-			vram, palette64, palette32768, pixelPtr, address, x & 3);
-		nrPixels -= 4 - (x & 3);
-	}
-	for (/**/; nrPixels > 0; nrPixels -= 4) {
-		draw_YJK_YUV_PAL<true, true, false>(
-			vram, palette64, palette32768, pixelPtr, address);
-	}
-	// Note: this can draw up to 3 pixels too many, but that's ok.
+	convertLineYUV(BYJKP, vram.getData(), palette64, palette32768,
+	               pixelPtr, x + y * vdp.getImageWidth(), nrPixels);
 }
 
 template <class Pixel>
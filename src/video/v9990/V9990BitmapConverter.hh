@@ -2,6 +2,7 @@
 #define V9990BITMAPCONVERTER_HH
 
 #include "V9990ModeEnum.hh"
+#include "openmsx.hh"
 
 namespace openmsx {
 
@@ -27,6 +28,24 @@ public:
 	  */
 	void setColorMode(V9990ColorMode color, V9990DisplayMode display);
 
+	/** Convert a line in one of the YUV or YJK color modes (BYUV, BYUVP,
+	  * BYJK or BYJKP) into host pixels. Like the other color modes, this
+	  * can draw up to 3 pixels too many.
+	  * This doesn't need a V9990, so it can be tested on its own (see
+	  * V9990BitmapConverter_Test.cc).
+	  * @param color One of the YUV or YJK color modes.
+	  * @param vramData The VRAM data, see V9990VRAM::getData().
+	  * @param palette64 The 64 color palette (only used for YUVP/YJKP).
+	  * @param palette32768 The 15-bits color palette.
+	  * @param pixelPtr Output buffer.
+	  * @param address Address (for readVRAMBx()) of the first pixel.
+	  * @param nrPixels The number of pixels to convert.
+	  */
+	static void convertLineYUV(
+		V9990ColorMode color, const byte* vramData,
+		const Pixel* palette64, const Pixel* palette32768,
+		Pixel* pixelPtr, unsigned address, int nrPixels);
+
 private:
 	/** Reference to VDP
 	  */
@@ -0,0 +1,95 @@
+#include "V9990BitmapConverter.hh"
+#include "V9990VRAM.hh"
+#include "Math.hh"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace openmsx;
+
+// Converts random VRAM contents in the YUV and YJK color modes with
+// V9990BitmapConverter and compares the result against a straightforward
+// scalar implementation, pixel-for-pixel. Build once with and once without
+// SSE2 (e.g. add -U__SSE2__) to check both code paths.
+
+static std::mt19937 rng(1234);
+
+template<typename Pixel> struct Palettes
+{
+	Palettes()
+		: palette64(64), palette32768(32768)
+	{
+		for (auto& p : palette64)    p = Pixel(rng());
+		for (auto& p : palette32768) p = Pixel(rng());
+	}
+	std::vector<Pixel> palette64;
+	std::vector<Pixel> palette32768;
+};
+
+template<typename Pixel>
+static Pixel refYUV(const Palettes<Pixel>& pal, V9990ColorMode color,
+                    const byte* vram, unsigned address)
+{
+	bool yjk = (color == BYJK)  || (color == BYJKP);
+	bool pal16 = (color == BYUVP) || (color == BYJKP);
+	byte p[4];
+	for (unsigned i = 0; i < 4; ++i) {
+		p[i] = vram[V9990VRAM::transformBx((address & ~3) + i)];
+	}
+	byte data = p[address & 3];
+	if (pal16 && (data & 0x08)) {
+		return pal.palette64[data >> 4];
+	}
+	int u = (p[2] & 7) + ((p[3] & 3) << 3) - ((p[3] & 4) << 3);
+	int v = (p[0] & 7) + ((p[1] & 3) << 3) - ((p[1] & 4) << 3);
+	int y = data >> 3;
+	int r = Math::clip<0, 31>(y + u);
+	int g = Math::clip<0, 31>((5 * y - 2 * u - v) / 4);
+	int b = Math::clip<0, 31>(y + v);
+	if (yjk) std::swap(g, b);
+	return pal.palette32768[(g << 10) + (r << 5) + b];
+}
+
+template<typename Pixel> static void test()
+{
+	Palettes<Pixel> pal;
+	std::vector<byte> vram(V9990VRAM::VRAM_SIZE);
+	for (auto& v : vram) v = byte(rng());
+
+	const Pixel guard = Pixel(0x5A5A5A5A);
+	for (auto color : { BYUV, BYUVP, BYJK, BYJKP }) {
+		for (int iter = 0; iter < 1000; ++iter) {
+			unsigned address = rng() % (2 * V9990VRAM::VRAM_SIZE);
+			if (iter % 4 == 0) {
+				// close to the end of VRAM, wraps around
+				address = V9990VRAM::VRAM_SIZE - 1 - rng() % 600;
+			}
+			int nrPixels = (iter < 8) ? (256 << (iter & 1))
+			                          : 1 + int(rng() % 600);
+
+			// may draw up to 3 pixels too many, but no more
+			std::vector<Pixel> out(nrPixels + 3 + 8, guard);
+			V9990BitmapConverter<Pixel>::convertLineYUV(
+				color, vram.data(),
+				pal.palette64.data(), pal.palette32768.data(),
+				out.data(), address, nrPixels);
+			for (int i = 0; i < nrPixels; ++i) {
+				assert(out[i] == refYUV(pal, color, vram.data(),
+				                        address + i));
+			}
+			for (int i = nrPixels + 3; i < int(out.size()); ++i) {
+				assert(out[i] == guard);
+			}
+		}
+	}
+}
+
+int main()
+{
+	test<uint16_t>();
+	test<uint32_t>();
+	std::cout << "All tests passed" << std::endl;
+}
@@ -11,6 +11,7 @@
 #include "serialize.hh"
 #include "likely.hh"
 #include "unreachable.hh"
+#include <algorithm>
 #include <iostream>
 
 namespace openmsx {
@@ -657,6 +658,139 @@ inline void V9990CmdEngine::V9990Bpp16::psetColor(
 	vram.writeVRAMDirect(addr + 0x40000, result >> 8);
 }
 
+// Line operations -----------------------------------------------------
+
+// Process 'num' pixels of one line, starting at 'x' and going in direction
+// 'dx'. The result is the same as calling psetColor()/pset() for each pixel,
+// but in the modes with more than one pixel per byte, groups of pixels that
+// cover a whole byte are handled in one go. That's allowed because the
+// logical operation LUTs treat each pixel in a byte independently.
+template<typename Mode, bool BYTES = (Mode::PIXELS_PER_BYTE > 1)>
+struct LineOp
+{
+	static inline bool psetByte(
+		V9990VRAM& /*vram*/, word /*x*/, word /*y*/, int /*dx*/,
+		unsigned /*num*/, unsigned /*pitch*/, byte /*src*/,
+		word /*mask*/, const byte* /*lut*/)
+	{
+		return false;
+	}
+
+	static inline void fill(
+		V9990VRAM& vram, word x, word y, int dx, unsigned num,
+		unsigned pitch, word color, word mask, const byte* lut, byte op)
+	{
+		for (; num; --num, x += dx) {
+			Mode::psetColor(vram, x, y, pitch, color, mask, lut, op);
+		}
+	}
+
+	static inline void copy(
+		V9990VRAM& vram, word sx, word sy, word x, word y, int dx,
+		unsigned num, unsigned pitch, word mask, const byte* lut, byte op)
+	{
+		for (; num; --num, sx += dx, x += dx) {
+			auto src = Mode::point(vram, sx, sy, pitch);
+			src = Mode::shift(src, sx, x);
+			Mode::pset(vram, x, y, pitch, src, mask, lut, op);
+		}
+	}
+};
+
+template<typename Mode>
+struct LineOp<Mode, true>
+{
+	static const unsigned PPB = Mode::PIXELS_PER_BYTE;
+
+	// Is 'x' the first pixel of a byte, in the direction 'dx'?
+	static inline bool startOfByte(word x, int dx)
+	{
+		return (((dx > 0) ? x : ~x) & (PPB - 1)) == 0;
+	}
+
+	// Do the next 'num' pixels, starting at 'x', cover a whole byte?
+	static inline bool wholeByte(word x, int dx, unsigned num)
+	{
+		return (num >= PPB) && startOfByte(x, dx);
+	}
+
+	static inline void writeByte(
+		V9990VRAM& vram, unsigned addr, byte src, word mask,
+		const byte* lut)
+	{
+		byte m = (addr & 0x40000) ? (mask >> 8) : (mask & 0xFF);
+		byte d = vram.readVRAMDirect(addr);
+		vram.writeVRAMDirect(addr, (d & ~m) | (Mode::logOp(lut, src, d) & m));
+	}
+
+	// Same as calling pset() for the next PIXELS_PER_BYTE pixels (with
+	// the same 'src'), but only when those cover exactly one byte.
+	static inline bool psetByte(
+		V9990VRAM& vram, word x, word y, int dx, unsigned num,
+		unsigned pitch, byte src, word mask, const byte* lut)
+	{
+		if (!wholeByte(x, dx, num)) return false;
+		writeByte(vram, Mode::addressOf(x, y, pitch), src, mask, lut);
+		return true;
+	}
+
+	static inline void fill(
+		V9990VRAM& vram, word x, word y, int dx, unsigned num,
+		unsigned pitch, word color, word mask, const byte* lut, byte op)
+	{
+		while (num) {
+			if (wholeByte(x, dx, num)) {
+				// the source color depends on the VRAM bank
+				unsigned addr = Mode::addressOf(x, y, pitch);
+				byte src = (addr & 0x40000) ? (color >> 8)
+				                            : (color & 0xFF);
+				writeByte(vram, addr, src, mask, lut);
+				x += int(PPB) * dx;
+				num -= PPB;
+			} else {
+				Mode::psetColor(vram, x, y, pitch, color, mask, lut, op);
+				x += dx;
+				--num;
+			}
+		}
+	}
+
+	static inline void copy(
+		V9990VRAM& vram, word sx, word sy, word x, word y, int dx,
+		unsigned num, unsigned pitch, word mask, const byte* lut, byte op)
+	{
+		// Only when source and destination have the same alignment, a
+		// source byte maps to exactly one destination byte.
+		bool aligned = ((sx ^ x) & (PPB - 1)) == 0;
+		while (num) {
+			auto src = Mode::point(vram, sx, sy, pitch);
+			if (aligned &&
+			    psetByte(vram, x, y, dx, num, pitch, src, mask, lut)) {
+				sx += int(PPB) * dx;
+				x  += int(PPB) * dx;
+				num -= PPB;
+			} else {
+				src = Mode::shift(src, sx, x);
+				Mode::pset(vram, x, y, pitch, src, mask, lut, op);
+				sx += dx;
+				x  += dx;
+				--num;
+			}
+		}
+	}
+};
+
+// Number of iterations of a 'while (time < limit) { time += delta; ... }'
+// loop. Unbounded for instantaneous (broken) command timing.
+static inline unsigned getNumSteps(
+	EmuTime::param time, EmuTime::param limit, EmuDuration::param delta)
+{
+	if (time >= limit) return 0;
+	if (delta == EmuDuration::zero) return unsigned(-1);
+	uint64_t steps = (limit - time).divUp(delta);
+	return unsigned(std::min<uint64_t>(steps, unsigned(-1)));
+}
+
 // ====================================================================
 /** Constructor
   */
@@ -1020,19 +1154,24 @@ void V9990CmdEngine::startLMMV(EmuTime::param time)
 template<typename Mode>
 void V9990CmdEngine::executeLMMV(EmuTime::param limit)
 {
-	// TODO can be optimized a lot
-
 	auto delta = getTiming(LMMV_TIMING);
 	unsigned pitch = Mode::getPitch(vdp.getImageWidth());
 	int dx = (ARG & DIX) ? -1 : 1;
 	int dy = (ARG & DIY) ? -1 : 1;
 	const byte* lut = Mode::getLogOpLUT(LOG);
-	while (engineTime < limit) {
-		engineTime += delta;
-		Mode::psetColor(vram, DX, DY, pitch, fgCol, WM, lut, LOG);
-
-		DX += dx;
-		if (!--(ANX)) {
+	// The command engine is only synced when its effect can be observed,
+	// so execute (the remainder of) each line in one go.
+	unsigned steps = getNumSteps(engineTime, limit, delta);
+	while (steps) {
+		unsigned num = std::min<unsigned>(ANX, steps);
+		LineOp<Mode>::fill(vram, DX, DY, dx, num, pitch,
+		                   fgCol, WM, lut, LOG);
+		engineTime += delta * num;
+		steps -= num;
+
+		DX += num * dx;
+		ANX -= num;
+		if (!ANX) {
 			DX -= (NX * dx);
 			DY += dy;
 			if (!--(ANY)) {
@@ -1112,22 +1251,24 @@ void V9990CmdEngine::startLMMM(EmuTime::param time)
 template<typename Mode>
 void V9990CmdEngine::executeLMMM(EmuTime::param limit)
 {
-	// TODO can be optimized a lot
-
 	auto delta = getTiming(LMMM_TIMING);
 	unsigned pitch = Mode::getPitch(vdp.getImageWidth());
 	int dx = (ARG & DIX) ? -1 : 1;
 	int dy = (ARG & DIY) ? -1 : 1;
 	const byte* lut = Mode::getLogOpLUT(LOG);
-	while (engineTime < limit) {
-		engineTime += delta;
-		auto src = Mode::point(vram, SX, SY, pitch);
-		src = Mode::shift(src, SX, DX);
-		Mode::pset(vram, DX, DY, pitch, src, WM, lut, LOG);
-
-		DX += dx;
-		SX += dx;
-		if (!--(ANX)) {
+	// see executeLMMV()
+	unsigned steps = getNumSteps(engineTime, limit, delta);
+	while (steps) {
+		unsigned num = std::min<unsigned>(ANX, steps);
+		LineOp<Mode>::copy(vram, SX, SY, DX, DY, dx, num, pitch,
+		                   WM, lut, LOG);
+		engineTime += delta * num;
+		steps -= num;
+
+		DX += num * dx;
+		SX += num * dx;
+		ANX -= num;
+		if (!ANX) {
 			DX -= (NX * dx);
 			SX -= (NX * dx);
 			DY += dy;
@@ -1292,6 +1433,21 @@ void V9990CmdEngine::executeBMXL(EmuTime::param limit)
 	while (engineTime < limit) {
 		engineTime += delta;
 		byte d = vram.readVRAMBx(srcAddress++);
+		if (LineOp<Mode>::psetByte(vram, DX, DY, dx, ANX, pitch,
+		                           d, WM, lut)) {
+			// all pixels of this byte in one go, see LineOp
+			DX += Mode::PIXELS_PER_BYTE * dx;
+			ANX -= Mode::PIXELS_PER_BYTE;
+			if (ANX) continue;
+			DX -= (NX * dx);
+			DY += dy;
+			if (!--(ANY)) {
+				cmdReady(engineTime);
+				return;
+			}
+			ANX = getWrappedNX();
+			continue;
+		}
 		for (int i = 0; (ANY > 0) && (i < Mode::PIXELS_PER_BYTE); ++i) {
 			Mode::pset(vram, DX, DY, pitch, d, WM, lut, LOG);
 			DX += dx;
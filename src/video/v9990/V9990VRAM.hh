@@ -74,6 +74,13 @@ public:
 	inline byte readVRAMDirect(unsigned address) {
 		return data[address];
 	}
+
+	/** Read-only access to all of VRAM, for the renderers. The data is in
+	  * physical order, see transformBx().
+	  */
+	inline const byte* getData() const {
+		return &data[0];
+	}
 	inline void writeVRAMDirect(unsigned address, byte value) {
 		data[address] = value;
 	}